@@ -29,9 +29,9 @@ OUTPUT_FOLDER=nets/tracker_output/$FOLDER
 
 echo "Saving output to " $OUTPUT_FILE
 
-# Run tracker on validation set
+# Run tracker on validation set (this also prints the validation score)
 build/test_tracker_alov $VIDEOS_FOLDER $ANNOTATIONS_FOLDER $DEPLOY_PROTO $CAFFE_MODEL $OUTPUT_FOLDER $USE_TRAIN $SAVE_VIDEOS $GPU_ID 
 
-# Compute validation score
-matlab -nodisplay -r "addpath(genpath('scripts/Fscore_v1.0')); evaluate_all $ANNOTATIONS_FOLDER $OUTPUT_FOLDER; exit"
+# To recompute the validation score from the saved output, run:
+# build/evaluate_alov $ANNOTATIONS_FOLDER $OUTPUT_FOLDER
 
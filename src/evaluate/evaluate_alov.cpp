@@ -0,0 +1,50 @@
+// Compute the ALOV validation F-scores from the output of test_tracker_alov.
+// (Replaces scripts/Fscore_v1.0/evaluate_all.m, so MATLAB is not needed).
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "evaluate/evaluator_alov.h"
+#include "helper/high_res_timer.h"
+
+using std::string;
+
+int main (int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0]
+              << " alov_annotations_folder tracker_output_folder"
+              << " [num_threads]" << std::endl;
+    return 1;
+  }
+
+  const string& annotations_folder = argv[1];
+  const string& output_folder      = argv[2];
+
+  // By default, use one thread per core.
+  int num_threads = 0;
+  if (argc >= 4) {
+    num_threads = atoi(argv[3]);
+  }
+
+  printf("%s\n", output_folder.c_str());
+
+  HighResTimer hrt("Evaluation", CLOCK_MONOTONIC);
+  hrt.start();
+
+  // Score all videos.
+  EvaluatorAlov evaluator(annotations_folder, output_folder);
+  const std::vector<double>& thresholds = EvaluatorAlov::DefaultThresholds();
+  std::vector<double> mean_fscores;
+  if (!evaluator.EvaluateAll(thresholds, num_threads, &mean_fscores)) {
+    return 1;
+  }
+
+  hrt.stop();
+
+  EvaluatorAlov::PrintScores(thresholds, mean_fscores);
+  hrt.print();
+
+  return 0;
+}
@@ -0,0 +1,62 @@
+// Run the VOT supervised experiment (with re-initialization after failures) on a
+// folder of VOT sequences and print the accuracy, robustness and expected average overlap.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "evaluate/evaluator_vot.h"
+#include "helper/high_res_timer.h"
+#include "loader/loader_vot.h"
+#include "network/regressor.h"
+
+using std::string;
+
+int main (int argc, char *argv[]) {
+  if (argc < 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " videos_folder deploy.prototxt network.caffemodel"
+              << " [gpu_id] [num_threads]" << std::endl;
+    std::cerr << "(Each of the num_threads threads, 1 by default, sets up its own copy of"
+              << " the network on gpu_id.)" << std::endl;
+    return 1;
+  }
+
+  ::google::InitGoogleLogging(argv[0]);
+
+  const string& videos_folder = argv[1];
+  const string& test_proto    = argv[2];
+  const string& caffe_model   = argv[3];
+
+  int gpu_id = 0;
+  if (argc >= 5) {
+    gpu_id = atoi(argv[4]);
+  }
+
+  // By default, track with a single network.
+  int num_threads = 1;
+  if (argc >= 6) {
+    num_threads = atoi(argv[5]);
+  }
+
+  HighResTimer hrt_total("Total evaluation (including loading videos)", CLOCK_MONOTONIC);
+  hrt_total.start();
+
+  // Get videos.
+  LoaderVOT loader(videos_folder);
+  std::vector<Video> videos = loader.get_videos();
+
+  // Run the experiment on all sequences.
+  EvaluatorVOT evaluator(videos, test_proto, caffe_model, gpu_id);
+  std::vector<VOTSequenceResult> results;
+  VOTScores scores;
+  evaluator.EvaluateAll(num_threads, &results, &scores);
+
+  EvaluatorVOT::PrintScores(results, scores);
+
+  hrt_total.stop();
+  hrt_total.print();
+
+  return 0;
+}
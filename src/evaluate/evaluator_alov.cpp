@@ -0,0 +1,238 @@
+#include "evaluator_alov.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+#include "helper/bounding_box.h"
+#include "helper/helper.h"
+#include "helper/polygon.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Tracker output for a single frame.
+struct TrackedFrame {
+  int frame_num;
+  BoundingBox bbox;
+};
+
+// Polygon annotation for a single frame.
+struct PolygonFrame {
+  int frame_num;
+  Polygon polygon;
+};
+
+// Read the tracker output, in the format written by TrackerTesterAlov:
+// frame_num x_min y_min width height (with 1-indexed frame numbers).
+void ReadTrackerOutput(const string& output_file, vector<TrackedFrame>* tracked_frames) {
+  FILE* output_file_ptr = fopen(output_file.c_str(), "r");
+  if (!output_file_ptr) {
+    return;
+  }
+
+  int frame_num;
+  double x_min, y_min, width, height;
+  while (fscanf(output_file_ptr, "%d %lf %lf %lf %lf\n",
+                &frame_num, &x_min, &y_min, &width, &height) == 5) {
+    TrackedFrame tracked_frame;
+    tracked_frame.frame_num = frame_num;
+    tracked_frame.bbox.x1_ = x_min;
+    tracked_frame.bbox.y1_ = y_min;
+    tracked_frame.bbox.x2_ = x_min + width;
+    tracked_frame.bbox.y2_ = y_min + height;
+    tracked_frames->push_back(tracked_frame);
+  }
+
+  fclose(output_file_ptr);
+}
+
+// Read the ALOV annotation file; each line is frame_num x1 y1 x2 y2 ... xn yn
+// (with 1-indexed frame numbers).
+void ReadAnnotations(const string& annotation_file, vector<PolygonFrame>* annotations) {
+  std::ifstream annotation_stream(annotation_file.c_str());
+  string line;
+  while (std::getline(annotation_stream, line)) {
+    std::istringstream line_stream(line);
+    vector<double> values;
+    double value;
+    while (line_stream >> value) {
+      values.push_back(value);
+    }
+    if (values.empty()) {
+      continue;
+    }
+
+    // Remove trailing (0, 0) vertices, which the MATLAB evaluation treats as padding.
+    while (values.size() >= 3 && values[values.size() - 1] == 0 &&
+           values[values.size() - 2] == 0) {
+      values.resize(values.size() - 2);
+    }
+
+    PolygonFrame annotation;
+    annotation.frame_num = static_cast<int>(values[0]);
+    for (size_t i = 1; i + 1 < values.size(); i += 2) {
+      annotation.polygon.x.push_back(values[i]);
+      annotation.polygon.y.push_back(values[i + 1]);
+    }
+    annotations->push_back(annotation);
+  }
+}
+
+} // namespace
+
+EvaluatorAlov::EvaluatorAlov(const string& annotations_folder,
+                             const string& output_folder)
+  : annotations_folder_(annotations_folder),
+    output_folder_(output_folder)
+{
+}
+
+// Compute the F-score from the precision and recall at the given threshold.
+// Frames without tracker output (NaN overlap) count as false negatives;
+// frames with an overlap below the threshold count as both false positives
+// and false negatives (cvpr12 formula).
+double EvaluatorAlov::ComputeFScore(const vector<double>& overlaps, const double threshold) {
+  int num_missing = 0;
+  int true_pos = 0;
+  int false_pos = 0;
+  for (size_t i = 0; i < overlaps.size(); ++i) {
+    if (std::isnan(overlaps[i])) {
+      num_missing++;
+    } else if (overlaps[i] >= threshold) {
+      true_pos++;
+    } else {
+      false_pos++;
+    }
+  }
+  const int false_neg = num_missing + false_pos;
+
+  const double precision = static_cast<double>(true_pos) / (true_pos + false_pos);
+  const double recall = static_cast<double>(true_pos) / (true_pos + false_neg);
+  const double fscore = 2 * precision * recall / (precision + recall);
+
+  // An undefined F-score (no true positives) counts as 0.
+  return std::isnan(fscore) ? 0 : fscore;
+}
+
+vector<double> EvaluatorAlov::DefaultThresholds() {
+  vector<double> thresholds;
+  thresholds.push_back(0.5);
+  thresholds.push_back(0.7);
+  thresholds.push_back(0.9);
+  return thresholds;
+}
+
+void EvaluatorAlov::EvaluateVideo(const string& output_file,
+                                  const string& annotation_file,
+                                  const vector<double>& thresholds,
+                                  AlovVideoScore* video_score) {
+  video_score->overlaps.clear();
+  video_score->fscores.clear();
+
+  vector<TrackedFrame> tracked_frames;
+  ReadTrackerOutput(output_file, &tracked_frames);
+
+  // The MATLAB evaluation gives a score of 1 to unreadable output files.
+  if (tracked_frames.empty()) {
+    printf("Error - cannot read file: %s\n", output_file.c_str());
+    video_score->has_annotations = true;
+    video_score->fscores.assign(thresholds.size(), 1);
+    return;
+  }
+
+  vector<PolygonFrame> annotations;
+  ReadAnnotations(annotation_file, &annotations);
+
+  video_score->has_annotations = !annotations.empty();
+  if (!video_score->has_annotations) {
+    printf("Warning - there is no performance evaluation for %s\n", output_file.c_str());
+    return;
+  }
+
+  // Compute the overlap between the tracker output and each annotation.
+  for (size_t i = 0; i < annotations.size(); ++i) {
+    const PolygonFrame& annotation = annotations[i];
+
+    // Find the tracker output for the annotated frame.
+    double overlap = std::numeric_limits<double>::quiet_NaN();
+    for (size_t j = 0; j < tracked_frames.size(); ++j) {
+      if (tracked_frames[j].frame_num == annotation.frame_num) {
+        overlap = ComputePolygonOverlap(annotation.polygon, tracked_frames[j].bbox);
+        break;
+      }
+    }
+    video_score->overlaps.push_back(overlap);
+  }
+
+  // Compute the F-score at each threshold.
+  for (size_t i = 0; i < thresholds.size(); ++i) {
+    video_score->fscores.push_back(ComputeFScore(video_score->overlaps, thresholds[i]));
+  }
+}
+
+bool EvaluatorAlov::EvaluateAll(const vector<double>& thresholds, const int num_threads,
+                                vector<AlovVideoScore>* video_scores,
+                                vector<double>* mean_fscores) const {
+  // Find all tracker output files (skipping hidden files; subfolders such as
+  // the saved videos are not regular files).
+  vector<string> output_files;
+  find_matching_files(output_folder_, boost::regex("[^.].*"), &output_files);
+
+  video_scores->clear();
+  video_scores->resize(output_files.size());
+
+  // Evaluate the videos in parallel; each video writes only to its own score.
+  parallel_for(output_files.size(), num_threads, [&](const size_t i) {
+    const string& video_name = output_files[i];
+
+    // The annotations are grouped by category, which is the prefix of the video name.
+    const string category = video_name.substr(0, video_name.find('_'));
+    const string output_file = output_folder_ + "/" + video_name;
+    const string annotation_file = annotations_folder_ + "/" + category + "/" + video_name + ".ann";
+
+    AlovVideoScore& video_score = (*video_scores)[i];
+    video_score.video_name = video_name;
+    EvaluateVideo(output_file, annotation_file, thresholds, &video_score);
+  });
+
+  // Average the F-scores over all videos that have annotations.
+  mean_fscores->assign(thresholds.size(), 0);
+  int num_videos = 0;
+  for (size_t i = 0; i < video_scores->size(); ++i) {
+    const AlovVideoScore& video_score = (*video_scores)[i];
+    if (!video_score.has_annotations) {
+      continue;
+    }
+    for (size_t j = 0; j < thresholds.size(); ++j) {
+      (*mean_fscores)[j] += video_score.fscores[j];
+    }
+    num_videos++;
+  }
+  if (num_videos == 0) {
+    printf("Error - no tracker output in %s has annotations in %s\n",
+           output_folder_.c_str(), annotations_folder_.c_str());
+    return false;
+  }
+  for (size_t j = 0; j < thresholds.size(); ++j) {
+    (*mean_fscores)[j] /= num_videos;
+  }
+  return true;
+}
+
+bool EvaluatorAlov::EvaluateAll(const vector<double>& thresholds, const int num_threads,
+                                vector<double>* mean_fscores) const {
+  vector<AlovVideoScore> video_scores;
+  return EvaluateAll(thresholds, num_threads, &video_scores, mean_fscores);
+}
+
+void EvaluatorAlov::PrintScores(const vector<double>& thresholds,
+                                const vector<double>& mean_fscores) {
+  for (size_t i = 0; i < thresholds.size(); ++i) {
+    printf("Thresh: %lf, Mean: %lf\n", thresholds[i], mean_fscores[i]);
+  }
+}
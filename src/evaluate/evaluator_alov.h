@@ -0,0 +1,70 @@
+#ifndef EVALUATOR_ALOV_H
+#define EVALUATOR_ALOV_H
+
+#include <string>
+#include <vector>
+
+// Evaluation results for the tracker output on a single video.
+struct AlovVideoScore {
+  // Name of the tracker output file (same as the video name, e.g. 01-Light_video00001).
+  std::string video_name;
+
+  // Whether the video had any annotations to evaluate against.
+  // Videos without annotations are left out of the means.
+  bool has_annotations;
+
+  // Overlap (intersection over union) between the tracker output and the
+  // annotation for each annotated frame, NaN if the tracker has no output for that frame.
+  std::vector<double> overlaps;
+
+  // F-score for each of the requested overlap thresholds.
+  std::vector<double> fscores;
+};
+
+// Scores the output of TrackerTesterAlov against the ALOV polygon annotations,
+// computing the same per-video F-score as scripts/Fscore_v1.0/quantitativeEvaluationFScore_poly.m.
+class EvaluatorAlov
+{
+public:
+  EvaluatorAlov(const std::string& annotations_folder,
+                const std::string& output_folder);
+
+  // Evaluate every tracker output file in the output folder, using num_threads threads
+  // (one per core if num_threads <= 0).
+  // Returns the score of each video, and the F-score for each threshold
+  // averaged over all videos.
+  // Returns false (with the mean F-scores set to 0) if no video has annotations.
+  bool EvaluateAll(const std::vector<double>& thresholds, const int num_threads,
+                   std::vector<AlovVideoScore>* video_scores,
+                   std::vector<double>* mean_fscores) const;
+
+  // Same as above, but only return the mean F-scores.
+  bool EvaluateAll(const std::vector<double>& thresholds, const int num_threads,
+                   std::vector<double>* mean_fscores) const;
+
+  // Print the mean F-score for each threshold (in the same format as evaluate_all.m).
+  static void PrintScores(const std::vector<double>& thresholds,
+                          const std::vector<double>& mean_fscores);
+
+  // Evaluate a single tracker output file against its annotation file.
+  static void EvaluateVideo(const std::string& output_file,
+                            const std::string& annotation_file,
+                            const std::vector<double>& thresholds,
+                            AlovVideoScore* video_score);
+
+  // Compute the F-score at the given threshold from the overlap for each annotated
+  // frame (NaN for frames without tracker output).
+  static double ComputeFScore(const std::vector<double>& overlaps, const double threshold);
+
+  // The default overlap thresholds used for validation (as in evaluate_all.m).
+  static std::vector<double> DefaultThresholds();
+
+private:
+  // Folder containing the ALOV annotations, one subfolder per category.
+  std::string annotations_folder_;
+
+  // Folder containing the tracker output, one file per video.
+  std::string output_folder_;
+};
+
+#endif // EVALUATOR_ALOV_H
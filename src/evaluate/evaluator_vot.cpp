@@ -0,0 +1,263 @@
+#include "evaluator_vot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+#include <boost/shared_ptr.hpp>
+
+#include "helper/helper.h"
+#include "helper/polygon.h"
+#include "network/regressor.h"
+#include "tracker/tracker.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Number of frames to skip after a failure before re-initializing the tracker.
+const int kSkipFramesAfterFailure = 5;
+
+// Number of frames after each initialization (including the initialization frame)
+// that are left out of the accuracy, since the tracker is biased towards
+// the ground-truth right after initialization.
+const int kBurnInFrames = 10;
+
+// Range of sequence lengths over which the expected overlap is averaged
+// (the values used in VOT 2016).
+const int kEAOLowLength = 100;
+const int kEAOHighLength = 356;
+
+// Read the ground-truth polygons of a VOT sequence (one per frame).
+// Lines with 4 values are treated as rectangles: left, top, width, height.
+// As in LoaderVOT, the coordinates are converted to be 0-indexed.
+void ReadGroundTruthPolygons(const string& groundtruth_path, vector<Polygon>* polygons) {
+  FILE* groundtruth_file_ptr = fopen(groundtruth_path.c_str(), "r");
+  if (!groundtruth_file_ptr) {
+    printf("Error - cannot open %s\n", groundtruth_path.c_str());
+    return;
+  }
+
+  char line[1024];
+  while (fgets(line, sizeof(line), groundtruth_file_ptr)) {
+    double values[8];
+    const int num_values = sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf",
+                                  &values[0], &values[1], &values[2], &values[3],
+                                  &values[4], &values[5], &values[6], &values[7]);
+    Polygon polygon;
+    if (num_values == 8) {
+      for (int i = 0; i < 4; ++i) {
+        polygon.x.push_back(values[2 * i] - 1);
+        polygon.y.push_back(values[2 * i + 1] - 1);
+      }
+    } else if (num_values == 4) {
+      const double x1 = values[0] - 1;
+      const double y1 = values[1] - 1;
+      const double x2 = x1 + values[2];
+      const double y2 = y1 + values[3];
+      polygon.x.push_back(x1); polygon.y.push_back(y1);
+      polygon.x.push_back(x2); polygon.y.push_back(y1);
+      polygon.x.push_back(x2); polygon.y.push_back(y2);
+      polygon.x.push_back(x1); polygon.y.push_back(y2);
+    } else {
+      continue;
+    }
+    polygons->push_back(polygon);
+  }
+
+  fclose(groundtruth_file_ptr);
+}
+
+// Run the supervised experiment on one sequence.
+void RunSequence(const Video& video, RegressorBase* regressor, Tracker* tracker,
+                 VOTSequenceResult* result) {
+  vector<Polygon> polygons;
+  ReadGroundTruthPolygons(video.path + "/groundtruth.txt", &polygons);
+
+  const int num_frames = video.all_frames.size();
+  result->path = video.path;
+  result->num_frames = num_frames;
+  result->overlaps.assign(num_frames, std::numeric_limits<double>::quiet_NaN());
+  result->init_frames.clear();
+  result->failure_frames.clear();
+
+  const bool draw_bounding_box = false;
+  const bool load_only_annotation = false;
+
+  int frame_num = 0;
+  while (frame_num < num_frames) {
+    // (Re)initialize the tracker with the ground-truth bounding box.
+    cv::Mat image;
+    BoundingBox bbox_gt;
+    if (!video.LoadFrame(frame_num, draw_bounding_box, load_only_annotation,
+                         &image, &bbox_gt)) {
+      frame_num++;
+      continue;
+    }
+    tracker->Init(image, bbox_gt, regressor);
+    result->init_frames.push_back(frame_num);
+    result->overlaps[frame_num] = 1;
+
+    // Track until the tracker fails or the sequence ends.
+    bool failed = false;
+    for (frame_num++; frame_num < num_frames; ++frame_num) {
+      cv::Mat image_curr;
+      BoundingBox bbox_unused;
+      video.LoadFrame(frame_num, draw_bounding_box, load_only_annotation,
+                      &image_curr, &bbox_unused);
+
+      BoundingBox bbox_estimate;
+      tracker->Track(image_curr, regressor, &bbox_estimate);
+
+      if (frame_num >= static_cast<int>(polygons.size())) {
+        continue;
+      }
+      const double overlap = ComputePolygonOverlap(polygons[frame_num], bbox_estimate);
+      result->overlaps[frame_num] = overlap;
+
+      // A failure is an output with no overlap with the ground-truth.
+      if (overlap <= 0) {
+        result->failure_frames.push_back(frame_num);
+        failed = true;
+        break;
+      }
+    }
+
+    if (!failed) {
+      break;
+    }
+    frame_num += kSkipFramesAfterFailure;
+  }
+
+  // Compute the accuracy, leaving out the burn-in frames after each initialization
+  // and the failure frames.
+  double total_overlap = 0;
+  result->num_accuracy_frames = 0;
+  for (size_t k = 0; k < result->init_frames.size(); ++k) {
+    const int start = result->init_frames[k] + kBurnInFrames;
+    const int end = k < result->failure_frames.size() ? result->failure_frames[k] : num_frames;
+    for (int i = start; i < end; ++i) {
+      if (!std::isnan(result->overlaps[i])) {
+        total_overlap += result->overlaps[i];
+        result->num_accuracy_frames++;
+      }
+    }
+  }
+  result->accuracy = result->num_accuracy_frames > 0 ?
+      total_overlap / result->num_accuracy_frames : 0;
+}
+
+} // namespace
+
+EvaluatorVOT::EvaluatorVOT(const vector<Video>& videos,
+                           const string& deploy_proto,
+                           const string& caffe_model,
+                           const int gpu_id)
+  : videos_(videos),
+    deploy_proto_(deploy_proto),
+    caffe_model_(caffe_model),
+    gpu_id_(gpu_id)
+{
+}
+
+void EvaluatorVOT::EvaluateAll(const int num_threads,
+                               vector<VOTSequenceResult>* results,
+                               VOTScores* scores) const {
+  results->clear();
+  results->resize(videos_.size());
+
+  // Unlike the loaders, do not default to one thread per core: each thread holds
+  // a whole network on the same GPU.
+  const int num_tracking_threads = std::max(1, num_threads);
+
+  // The network and tracker are not thread-safe, so each thread gets its own.
+  // They are created by the thread that uses them, since Caffe's mode and device
+  // are set per thread.
+  vector<boost::shared_ptr<Regressor> > regressors(get_num_threads(num_tracking_threads));
+  vector<boost::shared_ptr<Tracker> > trackers(regressors.size());
+
+  parallel_for_thread(videos_.size(), num_tracking_threads,
+                      [&](const size_t video_num, const size_t thread_num) {
+    if (!regressors[thread_num]) {
+      const bool do_train = false;
+      regressors[thread_num].reset(new Regressor(deploy_proto_, caffe_model_, gpu_id_, do_train));
+      const bool show_intermediate_output = false;
+      trackers[thread_num].reset(new Tracker(show_intermediate_output));
+    }
+    RunSequence(videos_[video_num], regressors[thread_num].get(),
+                trackers[thread_num].get(), &(*results)[video_num]);
+  });
+
+  ComputeScores(*results, scores);
+}
+
+void EvaluatorVOT::ComputeScores(const vector<VOTSequenceResult>& results,
+                                 VOTScores* scores) {
+  // Pool the accuracy and failures over all sequences.
+  double total_overlap = 0;
+  int num_accuracy_frames = 0;
+  int num_frames = 0;
+  scores->num_failures = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const VOTSequenceResult& result = results[i];
+    total_overlap += result.accuracy * result.num_accuracy_frames;
+    num_accuracy_frames += result.num_accuracy_frames;
+    num_frames += result.num_frames;
+    scores->num_failures += result.failure_frames.size();
+  }
+  scores->accuracy = num_accuracy_frames > 0 ? total_overlap / num_accuracy_frames : 0;
+  scores->failure_rate = num_frames > 0 ? 100.0 * scores->num_failures / num_frames : 0;
+
+  // Compute the expected average overlap.  Each run from an initialization is a
+  // segment; a segment that ends in a failure counts for every sequence length
+  // (with zero overlap after the failure), while a segment that reaches the end
+  // of the sequence only counts for lengths up to its own length.
+  double eao_sum = 0;
+  int eao_count = 0;
+  for (int length = kEAOLowLength; length <= kEAOHighLength; ++length) {
+    double expected_overlap_sum = 0;
+    int num_segments = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+      const VOTSequenceResult& result = results[i];
+      for (size_t k = 0; k < result.init_frames.size(); ++k) {
+        const int start = result.init_frames[k];
+        const bool failed = k < result.failure_frames.size();
+        const int end = failed ? result.failure_frames[k] + 1 : result.num_frames;
+        if (!failed && end - start < length) {
+          continue;
+        }
+
+        double segment_overlap = 0;
+        for (int j = start; j < std::min(end, start + length); ++j) {
+          if (!std::isnan(result.overlaps[j])) {
+            segment_overlap += result.overlaps[j];
+          }
+        }
+        expected_overlap_sum += segment_overlap / length;
+        num_segments++;
+      }
+    }
+
+    if (num_segments > 0) {
+      eao_sum += expected_overlap_sum / num_segments;
+      eao_count++;
+    }
+  }
+  scores->eao = eao_count > 0 ? eao_sum / eao_count : 0;
+}
+
+void EvaluatorVOT::PrintScores(const vector<VOTSequenceResult>& results,
+                               const VOTScores& scores) {
+  for (size_t i = 0; i < results.size(); ++i) {
+    const VOTSequenceResult& result = results[i];
+    const string& video_name = result.path.substr(result.path.find_last_of("/") + 1);
+    printf("%s: accuracy: %lf, failures: %zu\n", video_name.c_str(), result.accuracy,
+           result.failure_frames.size());
+  }
+  printf("Accuracy: %lf\n", scores.accuracy);
+  printf("Robustness: %d failures (%lf per 100 frames)\n", scores.num_failures,
+         scores.failure_rate);
+  printf("Expected average overlap: %lf\n", scores.eao);
+}
@@ -0,0 +1,88 @@
+#ifndef EVALUATOR_VOT_H
+#define EVALUATOR_VOT_H
+
+#include <string>
+#include <vector>
+
+#include "loader/video.h"
+
+// Results of running the VOT supervised (reset-based) experiment on a single sequence.
+struct VOTSequenceResult {
+  // Path to the sequence.
+  std::string path;
+
+  // Number of frames in the sequence.
+  int num_frames;
+
+  // Overlap between the tracker output and the ground-truth for every frame;
+  // 1 for frames where the tracker was (re)initialized and NaN for frames
+  // skipped after a failure.
+  std::vector<double> overlaps;
+
+  // Frames at which the tracker was (re)initialized.
+  std::vector<int> init_frames;
+
+  // Frames at which the tracker failed (zero overlap with the ground-truth).
+  std::vector<int> failure_frames;
+
+  // Mean overlap over the frames used for accuracy (excluding the burn-in
+  // period after each initialization), and the number of such frames.
+  double accuracy;
+  int num_accuracy_frames;
+};
+
+// Summary of the VOT measures over all sequences.
+struct VOTScores {
+  // Mean overlap over all frames used for accuracy (pooled over all sequences).
+  double accuracy;
+
+  // Total number of failures, and failures per 100 frames.
+  int num_failures;
+  double failure_rate;
+
+  // Expected average overlap.
+  double eao;
+};
+
+// Runs the VOT supervised experiment: the tracker is initialized on the first frame,
+// a failure is detected when the output has zero overlap with the ground-truth,
+// and the tracker is re-initialized a few frames after each failure.
+// This replaces the VOT toolkit (which restarts the tracker through TraX for each
+// sequence) for internal regression runs.
+class EvaluatorVOT
+{
+public:
+  // Each thread sets up its own network from deploy_proto and caffe_model.
+  EvaluatorVOT(const std::vector<Video>& videos,
+               const std::string& deploy_proto,
+               const std::string& caffe_model,
+               const int gpu_id);
+
+  // Run the experiment on all sequences using num_threads threads (one if
+  // num_threads <= 0), and compute the scores.  Each thread sets up its own copy
+  // of the network on the GPU, so more than one thread only pays off if the GPU
+  // has the memory and the spare capacity for them.
+  void EvaluateAll(const int num_threads,
+                   std::vector<VOTSequenceResult>* results,
+                   VOTScores* scores) const;
+
+  // Compute the accuracy, robustness and expected average overlap from the
+  // per-sequence results.
+  static void ComputeScores(const std::vector<VOTSequenceResult>& results,
+                            VOTScores* scores);
+
+  // Print the scores for each sequence and overall.
+  static void PrintScores(const std::vector<VOTSequenceResult>& results,
+                          const VOTScores& scores);
+
+private:
+  // Videos to evaluate on (from LoaderVOT).
+  const std::vector<Video>& videos_;
+
+  // Network used by the tracker.
+  std::string deploy_proto_;
+  std::string caffe_model_;
+  int gpu_id_;
+};
+
+#endif // EVALUATOR_VOT_H
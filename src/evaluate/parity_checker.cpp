@@ -0,0 +1,206 @@
+#include "parity_checker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "helper/bounding_box.h"
+#include "network/regressor.h"
+#include "tracker/tracker.h"
+#include "tracker/tracker_manager.h"
+
+using std::string;
+using std::vector;
+
+// Runs the network through the single or batched forward pass,
+// and keeps the fc8 output of the last estimate.
+class ParityRegressor : public Regressor
+{
+public:
+  ParityRegressor(const ParityPath& path, const int gpu_id)
+    : Regressor(path.deploy_proto, path.caffe_model, gpu_id, false),
+      batched_(path.batched)
+  {
+  }
+
+  virtual void Regress(const cv::Mat& image_curr, const cv::Mat& image,
+                       const cv::Mat& target, BoundingBox* bbox) {
+    if (batched_) {
+      Estimate(vector<cv::Mat>(1, image), vector<cv::Mat>(1, target), &output_);
+    } else {
+      Estimate(image, target, &output_);
+    }
+    *bbox = BoundingBox(output_);
+  }
+
+  virtual void Init() { Regressor::Init(); }
+
+  const vector<float>& get_output() const { return output_; }
+
+private:
+  bool batched_;
+  vector<float> output_;
+};
+
+namespace {
+
+// Compute the overlap (intersection over union) between two bounding boxes.
+double ComputeOverlap(const BoundingBox& bbox1, const BoundingBox& bbox2) {
+  const double intersection = bbox1.compute_intersection(bbox2);
+  const double union_area = bbox1.compute_area() + bbox2.compute_area() - intersection;
+  return union_area > 0 ? intersection / union_area : 0;
+}
+
+// Passes the same inputs to the reference and the candidate network.
+// The reference output drives the tracker; the differences are recorded.
+class PairedRegressor : public RegressorBase
+{
+public:
+  PairedRegressor(ParityRegressor* reference, ParityRegressor* candidate,
+                  ParityVideoResult* result)
+    : reference_(reference),
+      candidate_(candidate),
+      result_(result)
+  {
+  }
+
+  virtual void Regress(const cv::Mat& image_curr, const cv::Mat& image,
+                       const cv::Mat& target, BoundingBox* bbox) {
+    BoundingBox bbox_candidate;
+    reference_->Regress(image_curr, image, target, bbox);
+    candidate_->Regress(image_curr, image, target, &bbox_candidate);
+
+    const vector<float>& output_reference = reference_->get_output();
+    const vector<float>& output_candidate = candidate_->get_output();
+    for (size_t i = 0; i < output_reference.size() && i < output_candidate.size(); ++i) {
+      result_->max_fc8_diff = std::max(result_->max_fc8_diff,
+          static_cast<double>(fabs(output_reference[i] - output_candidate[i])));
+    }
+
+    // The boxes are relative to the same search region, so their overlap is the
+    // same as in the full image.
+    result_->min_box_iou = std::min(result_->min_box_iou, ComputeOverlap(*bbox, bbox_candidate));
+  }
+
+  virtual void Init() {
+    reference_->Init();
+    candidate_->Init();
+  }
+
+private:
+  ParityRegressor* reference_;
+  ParityRegressor* candidate_;
+  ParityVideoResult* result_;
+};
+
+// Records the tracker output for every frame.
+class TrackRecorder : public TrackerManager
+{
+public:
+  TrackRecorder(const vector<Video>& videos, RegressorBase* regressor,
+                Tracker* tracker, vector<BoundingBox>* track)
+    : TrackerManager(videos, regressor, tracker),
+      track_(track)
+  {
+  }
+
+  virtual void ProcessTrackOutput(
+      const size_t frame_num, const cv::Mat& image_curr, const bool has_annotation,
+      const BoundingBox& bbox_gt, const BoundingBox& bbox_estimate,
+      const int pause_val) {
+    track_->push_back(bbox_estimate);
+  }
+
+private:
+  vector<BoundingBox>* track_;
+};
+
+} // namespace
+
+ParityPath::ParityPath()
+  : batched(false)
+{
+}
+
+ParityThresholds::ParityThresholds()
+  : max_fc8_diff(0.05),
+    min_box_iou(0.95),
+    max_drift(0.1)
+{
+}
+
+ParityChecker::ParityChecker(const ParityPath& reference, const ParityPath& candidate,
+                             const int gpu_id, const ParityThresholds& thresholds)
+  : reference_(new ParityRegressor(reference, gpu_id)),
+    candidate_(new ParityRegressor(candidate, gpu_id)),
+    thresholds_(thresholds)
+{
+}
+
+bool ParityChecker::CheckAll(const vector<Video>& videos,
+                             vector<ParityVideoResult>* results) {
+  results->resize(videos.size());
+  bool all_passed = true;
+  for (size_t video_num = 0; video_num < videos.size(); ++video_num) {
+    ParityVideoResult& result = (*results)[video_num];
+    CheckVideo(videos[video_num], &result);
+    all_passed = all_passed && result.passed;
+  }
+  return all_passed;
+}
+
+void ParityChecker::CheckVideo(const Video& video, ParityVideoResult* result) {
+  result->path = video.path;
+  result->max_fc8_diff = 0;
+  result->min_box_iou = 1;
+  result->max_drift = 0;
+  result->final_drift = 0;
+
+  const vector<Video> videos(1, video);
+  const bool show_intermediate_output = false;
+
+  // Track with the reference path, running the candidate on the same inputs.
+  vector<BoundingBox> track_reference;
+  {
+    PairedRegressor paired_regressor(reference_.get(), candidate_.get(), result);
+    Tracker tracker(show_intermediate_output);
+    TrackRecorder recorder(videos, &paired_regressor, &tracker, &track_reference);
+    recorder.TrackAll();
+  }
+
+  // Track with the candidate path on its own.
+  vector<BoundingBox> track_candidate;
+  {
+    Tracker tracker(show_intermediate_output);
+    TrackRecorder recorder(videos, candidate_.get(), &tracker, &track_candidate);
+    recorder.TrackAll();
+  }
+
+  result->num_frames = std::min(track_reference.size(), track_candidate.size());
+  for (int i = 0; i < result->num_frames; ++i) {
+    const double drift = 1 - ComputeOverlap(track_reference[i], track_candidate[i]);
+    result->max_drift = std::max(result->max_drift, drift);
+    result->final_drift = drift;
+  }
+
+  result->passed = result->max_fc8_diff <= thresholds_.max_fc8_diff &&
+      result->min_box_iou >= thresholds_.min_box_iou &&
+      result->max_drift <= thresholds_.max_drift;
+}
+
+void ParityChecker::PrintResults(const vector<ParityVideoResult>& results) const {
+  printf("Thresholds: max fc8 diff %lf, min box IoU %lf, max drift %lf\n",
+         thresholds_.max_fc8_diff, thresholds_.min_box_iou, thresholds_.max_drift);
+  int num_passed = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const ParityVideoResult& result = results[i];
+    printf("%s: %s - %d frames, max fc8 diff: %lf, min box IoU: %lf, "
+           "max drift: %lf, final drift: %lf\n",
+           result.path.c_str(), result.passed ? "PASS" : "FAIL", result.num_frames,
+           result.max_fc8_diff, result.min_box_iou, result.max_drift, result.final_drift);
+    if (result.passed) {
+      num_passed++;
+    }
+  }
+  printf("%d / %zu videos passed\n", num_passed, results.size());
+}
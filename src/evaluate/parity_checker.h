@@ -0,0 +1,83 @@
+#ifndef PARITY_CHECKER_H
+#define PARITY_CHECKER_H
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "loader/video.h"
+
+class ParityRegressor;
+
+// One way of running the network: the architecture and weights (e.g. a model
+// with fused layers or quantized weights), and whether to run through the
+// batched forward pass.
+struct ParityPath {
+  ParityPath();
+
+  std::string deploy_proto;
+  std::string caffe_model;
+  bool batched;
+};
+
+// How far the candidate path may deviate from the reference path.
+struct ParityThresholds {
+  ParityThresholds();
+
+  // Maximum absolute difference of any fc8 output, given the same inputs.
+  double max_fc8_diff;
+
+  // Minimum overlap between the reference and candidate boxes, given the same inputs.
+  double min_box_iou;
+
+  // Maximum drift (1 - overlap) between the reference and candidate tracks,
+  // when each path tracks the video on its own.
+  double max_drift;
+};
+
+// Comparison of the two paths on one video.
+struct ParityVideoResult {
+  std::string path;
+  int num_frames;
+
+  // Per-frame comparison with identical inputs: the reference path drives the
+  // tracker and the candidate path is run on the same crops.
+  double max_fc8_diff;
+  double min_box_iou;
+
+  // End-to-end comparison: each path tracks the video on its own, and the
+  // tracks are compared frame by frame (errors can compound over time).
+  double max_drift;
+  double final_drift;
+
+  bool passed;
+};
+
+// Compares a candidate (optimized) path through the tracker against the
+// reference path, to check that a speed-up does not change the results
+// beyond the given thresholds.
+class ParityChecker
+{
+public:
+  ParityChecker(const ParityPath& reference, const ParityPath& candidate,
+                const int gpu_id, const ParityThresholds& thresholds);
+
+  // Compare the paths on all videos; returns true if every video passes.
+  bool CheckAll(const std::vector<Video>& videos,
+                std::vector<ParityVideoResult>* results);
+
+  // Print the comparison for each video.
+  void PrintResults(const std::vector<ParityVideoResult>& results) const;
+
+private:
+  // Compare the paths on one video.
+  void CheckVideo(const Video& video, ParityVideoResult* result);
+
+  boost::shared_ptr<ParityRegressor> reference_;
+  boost::shared_ptr<ParityRegressor> candidate_;
+
+  ParityThresholds thresholds_;
+};
+
+#endif // PARITY_CHECKER_H
@@ -0,0 +1,136 @@
+// Sweep the tracker over a grid of networks, context factors and frame skips,
+// and save the speed and accuracy of each configuration (with the Pareto frontier)
+// to a CSV file, to choose an operating point for a given speed or accuracy target.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "evaluate/tracker_sweep.h"
+#include "helper/high_res_timer.h"
+#include "loader/loader_alov.h"
+#include "loader/loader_vot.h"
+#include "network/regressor.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Split a comma-separated list.
+vector<string> SplitList(const string& list) {
+  vector<string> items;
+  std::istringstream stream(list);
+  string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+} // namespace
+
+int main (int argc, char *argv[]) {
+  if (argc < 8) {
+    std::cerr << "Usage: " << argv[0]
+              << " alov|vot videos_folder annotations_folder"
+              << " deploy.prototxt:network.caffemodel[,...] context_factors[,...] frame_skips[,...]"
+              << " output.csv [gpu_id] [num_threads] [cache_mb]" << std::endl;
+    std::cerr << "(For VOT, annotations_folder is ignored.  The configurations are tracked"
+              << " one at a time; num_threads only decodes the frames.)" << std::endl;
+    return 1;
+  }
+
+  ::google::InitGoogleLogging(argv[0]);
+
+  const string& dataset            = argv[1];
+  const string& videos_folder      = argv[2];
+  const string& annotations_folder = argv[3];
+  const vector<string> model_list  = SplitList(argv[4]);
+  const vector<string> context_factor_list = SplitList(argv[5]);
+  const vector<string> frame_skip_list     = SplitList(argv[6]);
+  const string& output_file        = argv[7];
+
+  int gpu_id = 0;
+  if (argc >= 9) {
+    gpu_id = atoi(argv[8]);
+  }
+
+  // By default, decode the frames with one thread per core.
+  int num_threads = 0;
+  if (argc >= 10) {
+    num_threads = atoi(argv[9]);
+  }
+
+  // Size of the cache of decoded frames, shared by all configurations.
+  int cache_mb = 1024;
+  if (argc >= 11) {
+    cache_mb = atoi(argv[10]);
+  }
+
+  vector<SweepModel> models;
+  for (size_t i = 0; i < model_list.size(); ++i) {
+    const size_t separator = model_list[i].find(':');
+    if (separator == string::npos) {
+      printf("Error - model should be given as deploy.prototxt:network.caffemodel, got %s\n",
+             model_list[i].c_str());
+      return 1;
+    }
+    SweepModel model;
+    model.deploy_proto = model_list[i].substr(0, separator);
+    model.caffe_model = model_list[i].substr(separator + 1);
+    models.push_back(model);
+  }
+
+  // Evaluate every combination of the settings.
+  vector<SweepConfig> configs;
+  for (size_t i = 0; i < models.size(); ++i) {
+    for (size_t j = 0; j < context_factor_list.size(); ++j) {
+      for (size_t k = 0; k < frame_skip_list.size(); ++k) {
+        SweepConfig config;
+        config.model_index = i;
+        config.context_factor = atof(context_factor_list[j].c_str());
+        config.frame_skip = std::max(1, atoi(frame_skip_list[k].c_str()));
+        configs.push_back(config);
+      }
+    }
+  }
+
+  HighResTimer hrt_total("Total sweep (including loading videos)", CLOCK_MONOTONIC);
+  hrt_total.start();
+
+  // Get videos.
+  vector<Video> videos;
+  if (dataset == "alov") {
+    // Use the validation set, as in test_tracker_alov.
+    LoaderAlov loader(videos_folder, annotations_folder);
+    const bool get_train = false;
+    loader.get_videos(get_train, &videos);
+  } else if (dataset == "vot") {
+    LoaderVOT loader(videos_folder);
+    videos = loader.get_videos();
+  } else {
+    printf("Error - unknown dataset type %s (should be alov or vot)\n", dataset.c_str());
+    return 1;
+  }
+
+  printf("Sweeping %zu configurations over %zu videos\n", configs.size(), videos.size());
+
+  TrackerSweep sweep(videos, models, gpu_id, static_cast<size_t>(cache_mb) * 1024 * 1024);
+  vector<SweepResult> results;
+  sweep.Run(configs, num_threads, &results);
+
+  sweep.SaveResults(results, output_file);
+  sweep.PrintParetoFrontier(results);
+
+  hrt_total.stop();
+  hrt_total.print();
+
+  return 0;
+}
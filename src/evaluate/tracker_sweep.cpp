@@ -0,0 +1,301 @@
+#include "tracker_sweep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+#include <boost/shared_ptr.hpp>
+
+#include "evaluate/evaluator_alov.h"
+#include "helper/bounding_box.h"
+#include "helper/helper.h"
+#include "helper/high_res_timer.h"
+#include "network/regressor.h"
+#include "tracker/tracker.h"
+#include "tracker/tracker_manager.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Overlap threshold for the F-score.
+const double kFScoreThreshold = 0.5;
+
+// Measurements from tracking one video with one configuration.
+struct SweepMeasurements {
+  SweepMeasurements()
+    : num_frames(0),
+      track_seconds(0)
+  {
+  }
+
+  // Time to track each processed frame.
+  vector<double> latencies_ms;
+
+  // Overlap with the ground-truth for each annotated frame.
+  vector<double> overlaps;
+
+  // Number of video frames covered (excluding the initialization frame).
+  int num_frames;
+
+  // Total time spent tracking.
+  double track_seconds;
+};
+
+// Records the timing of each tracked frame and the overlap of the tracker output
+// with the ground-truth for every annotated frame.
+class TrackerSweepRecorder : public TrackerManager
+{
+public:
+  TrackerSweepRecorder(const vector<Video>& videos, RegressorBase* regressor,
+                       Tracker* tracker, SweepMeasurements* measurements)
+    : TrackerManager(videos, regressor, tracker),
+      hrt_("Track", CLOCK_MONOTONIC),
+      measurements_(measurements)
+  {
+  }
+
+  // Run() skips the videos without annotations.
+  virtual void VideoInit(const Video& video, const size_t video_num) {
+    video_ = &video;
+    first_frame_ = video.annotations[0].frame_num;
+    last_frame_ = first_frame_;
+    bbox_last_ = video.annotations[0].bbox;
+  }
+
+  virtual void SetupEstimate() {
+    hrt_.reset();
+    hrt_.start();
+  }
+
+  virtual void ProcessTrackOutput(
+      const size_t frame_num, const cv::Mat& image_curr, const bool has_annotation,
+      const BoundingBox& bbox_gt, const BoundingBox& bbox_estimate,
+      const int pause_val) {
+    hrt_.stop();
+    measurements_->latencies_ms.push_back(hrt_.getMilliseconds());
+    measurements_->track_seconds += hrt_.getSeconds();
+
+    // The skipped frames keep the previous output.
+    ScoreFrames(last_frame_ + 1, frame_num);
+
+    bbox_last_ = bbox_estimate;
+    last_frame_ = frame_num;
+    if (has_annotation) {
+      ScoreFrame(bbox_gt);
+    }
+  }
+
+  virtual void PostProcessVideo() {
+    const int num_frames = video_->all_frames.size();
+    ScoreFrames(last_frame_ + 1, num_frames);
+    measurements_->num_frames += num_frames - 1 - first_frame_;
+  }
+
+private:
+  // Score the frames in [start_frame, end_frame) using the last tracker output.
+  void ScoreFrames(const int start_frame, const int end_frame) {
+    for (int frame_num = start_frame; frame_num < end_frame; ++frame_num) {
+      BoundingBox bbox_gt;
+      const bool draw_bounding_box = false;
+      const bool load_only_annotation = true;
+      if (video_->LoadFrame(frame_num, draw_bounding_box, load_only_annotation, NULL, &bbox_gt)) {
+        ScoreFrame(bbox_gt);
+      }
+    }
+  }
+
+  // Score the last tracker output by its overlap with the ground-truth box
+  // (0 if both boxes are empty).
+  void ScoreFrame(const BoundingBox& bbox_gt) {
+    const double intersection = bbox_last_.compute_intersection(bbox_gt);
+    const double union_area = bbox_last_.compute_area() + bbox_gt.compute_area() - intersection;
+    measurements_->overlaps.push_back(union_area > 0 ? intersection / union_area : 0);
+  }
+
+  HighResTimer hrt_;
+  SweepMeasurements* measurements_;
+
+  const Video* video_;
+  int first_frame_;
+  int last_frame_;
+  BoundingBox bbox_last_;
+};
+
+// Compute the given percentile of the values.
+double ComputePercentile(vector<double> values, const double percentile) {
+  if (values.empty()) {
+    return 0;
+  }
+  const size_t index = std::min(values.size() - 1,
+      static_cast<size_t>(ceil(percentile / 100 * values.size())) - 1);
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+// Whether result1 is at least as good as result2 in every measure and strictly better in one.
+bool Dominates(const SweepResult& result1, const SweepResult& result2) {
+  const bool at_least_as_good = result1.fps >= result2.fps &&
+      result1.p99_latency_ms <= result2.p99_latency_ms &&
+      result1.mean_iou >= result2.mean_iou;
+  const bool better = result1.fps > result2.fps ||
+      result1.p99_latency_ms < result2.p99_latency_ms ||
+      result1.mean_iou > result2.mean_iou;
+  return at_least_as_good && better;
+}
+
+} // namespace
+
+TrackerSweep::TrackerSweep(const vector<Video>& videos,
+                           const vector<SweepModel>& models,
+                           const int gpu_id,
+                           const size_t cache_bytes)
+  : videos_(videos),
+    models_(models),
+    gpu_id_(gpu_id),
+    image_cache_(cache_bytes)
+{
+}
+
+void TrackerSweep::Run(const vector<SweepConfig>& configs, const int num_threads,
+                       vector<SweepResult>* results) {
+  const size_t num_configs = configs.size();
+  vector<SweepMeasurements> measurements(videos_.size() * num_configs);
+
+  // One network per model, all set up by this thread (Caffe's mode and device are set per thread).
+  vector<boost::shared_ptr<Regressor> > regressors(models_.size());
+
+  // Restore the context factor after the sweep.
+  const double initial_context_factor = BoundingBox::get_context_factor();
+
+  for (size_t video_num = 0; video_num < videos_.size(); ++video_num) {
+    // The tracker is initialized from the first annotation.
+    if (videos_[video_num].annotations.empty()) {
+      printf("Warning - skipping %s, which has no annotations\n", videos_[video_num].path.c_str());
+      continue;
+    }
+
+    // Load the frames through the shared cache.
+    vector<Video> videos(1, videos_[video_num]);
+    videos[0].set_image_cache(&image_cache_);
+
+    // Decode the frames of this video in parallel first, so that the configurations
+    // find them in the cache (if it is large enough to hold the video).
+    parallel_for(videos[0].all_frames.size(), num_threads, [&](const size_t frame_num) {
+      cv::Mat image;
+      BoundingBox bbox;
+      const bool draw_bounding_box = false;
+      const bool load_only_annotation = false;
+      videos[0].LoadFrame(frame_num, draw_bounding_box, load_only_annotation, &image, &bbox);
+    });
+
+    // Track the video with each configuration in turn, so that each is timed on its own.
+    for (size_t config_num = 0; config_num < num_configs; ++config_num) {
+      const SweepConfig& config = configs[config_num];
+
+      boost::shared_ptr<Regressor>& regressor = regressors[config.model_index];
+      if (!regressor) {
+        const SweepModel& model = models_[config.model_index];
+        const bool do_train = false;
+        regressor.reset(new Regressor(model.deploy_proto, model.caffe_model, gpu_id_, do_train));
+      }
+
+      BoundingBox::set_context_factor(config.context_factor);
+
+      const bool show_intermediate_output = false;
+      Tracker tracker(show_intermediate_output);
+      TrackerSweepRecorder recorder(videos, regressor.get(), &tracker,
+                                    &measurements[video_num * num_configs + config_num]);
+      recorder.set_frame_skip(config.frame_skip);
+      recorder.TrackAll();
+    }
+  }
+  BoundingBox::set_context_factor(initial_context_factor);
+  image_cache_.PrintStats();
+
+  // Combine the measurements over all videos for each configuration.
+  results->clear();
+  for (size_t config_num = 0; config_num < num_configs; ++config_num) {
+    vector<double> latencies_ms;
+    vector<double> overlaps;
+    int num_frames = 0;
+    double track_seconds = 0;
+    for (size_t video_num = 0; video_num < videos_.size(); ++video_num) {
+      const SweepMeasurements& video_measurements = measurements[video_num * num_configs + config_num];
+      latencies_ms.insert(latencies_ms.end(), video_measurements.latencies_ms.begin(),
+                          video_measurements.latencies_ms.end());
+      overlaps.insert(overlaps.end(), video_measurements.overlaps.begin(),
+                      video_measurements.overlaps.end());
+      num_frames += video_measurements.num_frames;
+      track_seconds += video_measurements.track_seconds;
+    }
+
+    SweepResult result;
+    result.config = configs[config_num];
+    result.fps = track_seconds > 0 ? num_frames / track_seconds : 0;
+    result.tracker_fps = track_seconds > 0 ? latencies_ms.size() / track_seconds : 0;
+    result.p99_latency_ms = ComputePercentile(latencies_ms, 99);
+
+    double total_overlap = 0;
+    for (size_t i = 0; i < overlaps.size(); ++i) {
+      total_overlap += overlaps[i];
+    }
+    result.mean_iou = overlaps.empty() ? 0 : total_overlap / overlaps.size();
+    result.box_fscore = EvaluatorAlov::ComputeFScore(overlaps, kFScoreThreshold);
+    results->push_back(result);
+  }
+
+  FindParetoFrontier(results);
+}
+
+void TrackerSweep::FindParetoFrontier(vector<SweepResult>* results) {
+  for (size_t i = 0; i < results->size(); ++i) {
+    SweepResult& result = (*results)[i];
+    result.pareto = true;
+    for (size_t j = 0; j < results->size(); ++j) {
+      if (j != i && Dominates((*results)[j], result)) {
+        result.pareto = false;
+        break;
+      }
+    }
+  }
+}
+
+void TrackerSweep::SaveResults(const vector<SweepResult>& results,
+                               const string& output_file) const {
+  FILE* output_file_ptr = fopen(output_file.c_str(), "w");
+  if (!output_file_ptr) {
+    printf("Error - cannot open %s\n", output_file.c_str());
+    return;
+  }
+
+  fprintf(output_file_ptr, "model,context_factor,frame_skip,fps,tracker_fps,"
+          "p99_latency_ms,mean_iou,box_fscore,pareto\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const SweepResult& result = results[i];
+    fprintf(output_file_ptr, "%s,%lf,%d,%lf,%lf,%lf,%lf,%lf,%d\n",
+            models_[result.config.model_index].caffe_model.c_str(),
+            result.config.context_factor, result.config.frame_skip,
+            result.fps, result.tracker_fps, result.p99_latency_ms,
+            result.mean_iou, result.box_fscore, result.pareto ? 1 : 0);
+  }
+
+  fclose(output_file_ptr);
+}
+
+void TrackerSweep::PrintParetoFrontier(const vector<SweepResult>& results) const {
+  printf("Pareto frontier:\n");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const SweepResult& result = results[i];
+    if (!result.pareto) {
+      continue;
+    }
+    printf("%s, context factor %lf, frame skip %d: %lf fps, p99 latency %lf ms, "
+           "mean IoU %lf, box F-score %lf\n",
+           models_[result.config.model_index].caffe_model.c_str(),
+           result.config.context_factor, result.config.frame_skip,
+           result.fps, result.p99_latency_ms, result.mean_iou, result.box_fscore);
+  }
+}
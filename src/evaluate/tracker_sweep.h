@@ -0,0 +1,92 @@
+#ifndef TRACKER_SWEEP_H
+#define TRACKER_SWEEP_H
+
+#include <string>
+#include <vector>
+
+#include "loader/image_cache.h"
+#include "loader/video.h"
+
+// A trained network to evaluate.
+struct SweepModel {
+  std::string deploy_proto;
+  std::string caffe_model;
+};
+
+// One combination of inference-time settings.
+struct SweepConfig {
+  // Index of the network (in the list of models given to TrackerSweep).
+  size_t model_index;
+
+  // How much context to pad the target and search region with (see BoundingBox::set_context_factor).
+  double context_factor;
+
+  // Track only every frame_skip-th frame, keeping the previous output for the frames in between.
+  int frame_skip;
+};
+
+// Speed and accuracy of one configuration.
+struct SweepResult {
+  SweepConfig config;
+
+  // Video frames covered per second of tracking time (counting skipped frames),
+  // and frames actually tracked per second of tracking time.
+  double fps;
+  double tracker_fps;
+
+  // 99th percentile of the time to track a single frame.
+  double p99_latency_ms;
+
+  // Mean overlap with the ground-truth boxes over all annotated frames (skipped frames
+  // are scored with the previous output), and the F-score at an overlap of 0.5.
+  // The overlaps are between axis-aligned boxes, whereas EvaluatorAlov scores against
+  // the ALOV polygons, so box_fscore can differ from the F-score of evaluate_alov.
+  double mean_iou;
+  double box_fscore;
+
+  // Whether no other configuration is at least as fast, as responsive and as accurate
+  // (and strictly better in one of these).
+  bool pareto;
+};
+
+// Evaluates the speed and accuracy of the tracker over a grid of settings,
+// to choose operating points.  Each configuration is run over all videos through
+// TrackerManager.  The configurations are tracked one at a time with one network per
+// model, so that their timings are not skewed by other configurations sharing the
+// GPU; only decoding the frames (which is not timed) runs in parallel.
+class TrackerSweep
+{
+public:
+  TrackerSweep(const std::vector<Video>& videos,
+               const std::vector<SweepModel>& models,
+               const int gpu_id,
+               const size_t cache_bytes);
+
+  // Evaluate every configuration, decoding the frames of each video with num_threads
+  // threads (one per core if num_threads <= 0) before tracking it.
+  void Run(const std::vector<SweepConfig>& configs, const int num_threads,
+           std::vector<SweepResult>* results);
+
+  // Mark the configurations on the Pareto frontier of (fps, p99 latency, mean IoU).
+  static void FindParetoFrontier(std::vector<SweepResult>* results);
+
+  // Save the results as a CSV file, with one row per configuration.
+  void SaveResults(const std::vector<SweepResult>& results,
+                   const std::string& output_file) const;
+
+  // Print the configurations on the Pareto frontier.
+  void PrintParetoFrontier(const std::vector<SweepResult>& results) const;
+
+private:
+  // Videos to track.
+  const std::vector<Video>& videos_;
+
+  // Networks to evaluate.
+  std::vector<SweepModel> models_;
+  int gpu_id_;
+
+  // Decoded frames, shared between all configurations.
+  ImageCache image_cache_;
+};
+
+#endif // TRACKER_SWEEP_H
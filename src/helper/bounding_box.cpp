@@ -10,8 +10,11 @@
 #include "helper.h"
 
 // How much context to pad the image and target with (relative to the
-// bounding box size).
-const double kContextFactor = 2;
+// bounding box size), unless changed with set_context_factor.
+const double kDefaultContextFactor = 2;
+
+// Read without synchronization by every tracker and training thread.
+static double context_factor = kDefaultContextFactor;
 
 // Factor by which to scale the bounding box coordinates, based on the
 // neural network default output range.
@@ -35,6 +38,14 @@ BoundingBox::BoundingBox(const VOTRegion& region)
   y2_ = region.get_y() + region.get_height();
 }
 
+void BoundingBox::set_context_factor(const double factor) {
+  context_factor = factor;
+}
+
+double BoundingBox::get_context_factor() {
+  return context_factor;
+}
+
 void BoundingBox::GetRegion(VOTRegion* region) {
   // VOTRegion is given by left, top, width, and height.
   region->set_x(x1_);
@@ -94,10 +105,12 @@ void BoundingBox::Print() const {
 }
 
 void BoundingBox::Scale(const cv::Mat& image, BoundingBox* bbox_scaled) const {
-  *bbox_scaled = *this;
+  Scale(image.cols, image.rows, bbox_scaled);
+}
 
-  const int width = image.cols;
-  const int height = image.rows;
+void BoundingBox::Scale(const double width, const double height,
+                        BoundingBox* bbox_scaled) const {
+  *bbox_scaled = *this;
 
   // Scale the bounding box so that the coordinates range from 0 to 1.
   bbox_scaled->x1_ /= width;
@@ -113,10 +126,12 @@ void BoundingBox::Scale(const cv::Mat& image, BoundingBox* bbox_scaled) const {
 }
 
 void BoundingBox::Unscale(const cv::Mat& image, BoundingBox* bbox_unscaled) const {
-  *bbox_unscaled = *this;
+  Unscale(image.cols, image.rows, bbox_unscaled);
+}
 
-  const int image_width = image.cols;
-  const int image_height = image.rows;
+void BoundingBox::Unscale(const double image_width, const double image_height,
+                          BoundingBox* bbox_unscaled) const {
+  *bbox_unscaled = *this;
 
   // Unscale the bounding box so that the coordinates range from 0 to 1.
   bbox_unscaled->x1_ /= scale_factor_;
@@ -136,9 +151,9 @@ double BoundingBox::compute_output_width() const {
   // Get the bounding box width.
   const double bbox_width = (x2_ - x1_);
 
-  // We pad the image by a factor of kContextFactor around the bounding box
+  // We pad the image by a factor of context_factor around the bounding box
   // to include some image context.
-  const double output_width = kContextFactor * bbox_width;
+  const double output_width = context_factor * bbox_width;
 
   // Ensure that the output width is at least 1 pixel.
   return std::max(1.0, output_width);
@@ -148,9 +163,9 @@ double BoundingBox::compute_output_height() const {
   // Get the bounding box height.
   const double bbox_height = (y2_ - y1_);
 
-  // We pad the image by a factor of kContextFactor around the bounding box
+  // We pad the image by a factor of context_factor around the bounding box
   // to include some image context.
-  const double output_height = kContextFactor * bbox_height;
+  const double output_height = context_factor * bbox_height;
 
   // Ensure that the output height is at least 1 pixel.
   return std::max(1.0, output_height);
@@ -235,6 +250,7 @@ void BoundingBox::Shift(const cv::Mat& image,
                         const double lambda_shift_frac,
                         const double min_scale, const double max_scale,
                         const bool shift_motion_model,
+                        Rng* rng,
                         BoundingBox* bbox_rand) const {
   const double width = get_width();
   const double height = get_height();
@@ -252,9 +268,9 @@ void BoundingBox::Shift(const cv::Mat& image,
     // Sample.
     double width_scale_factor;
     if (shift_motion_model) {
-      width_scale_factor = max(min_scale, min(max_scale, sample_exp_two_sided(lambda_scale_frac)));
+      width_scale_factor = max(min_scale, min(max_scale, sample_exp_two_sided(lambda_scale_frac, rng)));
     } else {
-      const double rand_num = sample_rand_uniform();
+      const double rand_num = sample_rand_uniform(rng);
       width_scale_factor = rand_num * (max_scale - min_scale) + min_scale;
     }
     // Expand width by scaling factor.
@@ -271,9 +287,9 @@ void BoundingBox::Shift(const cv::Mat& image,
     // Sample.
     double height_scale_factor;
     if (shift_motion_model) {
-      height_scale_factor = max(min_scale, min(max_scale, sample_exp_two_sided(lambda_scale_frac)));
+      height_scale_factor = max(min_scale, min(max_scale, sample_exp_two_sided(lambda_scale_frac, rng)));
     } else {
-      const double rand_num = sample_rand_uniform();
+      const double rand_num = sample_rand_uniform(rng);
       height_scale_factor = rand_num * (max_scale - min_scale) + min_scale;
     }
     // Expand height by scaling factor.
@@ -289,8 +305,8 @@ void BoundingBox::Shift(const cv::Mat& image,
   int num_tries_x = 0;
   while ((first_time_x ||
          // Ensure that the new object center remains in the old image window.
-         new_center_x < center_x - width * kContextFactor / 2 ||
-         new_center_x > center_x + width * kContextFactor / 2 ||
+         new_center_x < center_x - width * context_factor / 2 ||
+         new_center_x > center_x + width * context_factor / 2 ||
           // Ensure that the new window stays within the borders of the image.
          new_center_x - new_width / 2 < 0 ||
          new_center_x + new_width / 2 > image.cols)
@@ -298,9 +314,9 @@ void BoundingBox::Shift(const cv::Mat& image,
     // Sample.
     double new_x_temp;
     if (shift_motion_model) {
-      new_x_temp = center_x + width * sample_exp_two_sided(lambda_shift_frac);
+      new_x_temp = center_x + width * sample_exp_two_sided(lambda_shift_frac, rng);
     } else {
-      const double rand_num = sample_rand_uniform();
+      const double rand_num = sample_rand_uniform(rng);
       new_x_temp = center_x + rand_num * (2 * new_width) - new_width;
     }
     // Make sure that the window stays within the image.
@@ -315,8 +331,8 @@ void BoundingBox::Shift(const cv::Mat& image,
   int num_tries_y = 0;
   while ((first_time_y ||
           // Ensure that the new object center remains in the old image window.
-         new_center_y < center_y - height * kContextFactor / 2 ||
-         new_center_y > center_y + height * kContextFactor / 2  ||
+         new_center_y < center_y - height * context_factor / 2 ||
+         new_center_y > center_y + height * context_factor / 2  ||
           // Ensure that the new window stays within the borders of the image.
          new_center_y - new_height / 2 < 0 ||
          new_center_y + new_height / 2 > image.rows)
@@ -324,9 +340,9 @@ void BoundingBox::Shift(const cv::Mat& image,
     // Sample.
     double new_y_temp;
     if (shift_motion_model) {
-      new_y_temp = center_y + height * sample_exp_two_sided(lambda_shift_frac);
+      new_y_temp = center_y + height * sample_exp_two_sided(lambda_shift_frac, rng);
     } else {
-      const double rand_num = sample_rand_uniform();
+      const double rand_num = sample_rand_uniform(rng);
       new_y_temp = center_y + rand_num * (2 * new_height) - new_height;
     }
     // Make sure that the window stays within the image.
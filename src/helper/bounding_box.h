@@ -8,6 +8,7 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+class Rng;
 class VOTRegion;
 
 // Represents a bounding box on an image, with some additional functionality.
@@ -36,10 +37,18 @@ public:
   // Normalize the size of the bounding box based on the size of the image.
   void Scale(const cv::Mat& image, BoundingBox* bbox_scaled) const;
 
+  // Normalize the size of the bounding box based on an image of the given size.
+  void Scale(const double image_width, const double image_height,
+             BoundingBox* bbox_scaled) const;
+
   // Unnormalize the size of the bounding box based on the size of the image.
   // (Undoes the effect of Scale).
   void Unscale(const cv::Mat& image, BoundingBox* bbox_unscaled) const;
 
+  // Unnormalize the size of the bounding box based on an image of the given size.
+  void Unscale(const double image_width, const double image_height,
+               BoundingBox* bbox_unscaled) const;
+
   // Compute location of bounding box relative to search region
   // edge_spacing_x and edge_spacing_y is the spaving of the image within the search region to account for edge effects.
   // *this should be the ground-truth bbox.
@@ -52,13 +61,22 @@ public:
                 const double edge_spacing_x, const double edge_spacing_y,
                 BoundingBox* bbox_uncentered) const;
 
-  // Shift the cropped region of the image to generate a new random training example.
+  // Shift the cropped region of the image to generate a new random training example,
+  // sampling the shift from rng.
   void Shift(const cv::Mat& image,
              const double lambda_scale_frac, const double lambda_shift_frac,
              const double min_scale, const double max_scale,
              const bool shift_motion_model,
+             Rng* rng,
              BoundingBox* bbox_rand) const;
 
+  // Set how much context to pad the image and target with, relative to the bounding
+  // box size (default 2, which the network was trained with).
+  // The setting applies to all threads and is read from them without synchronization,
+  // so it must not be changed while trackers or training workers are running.
+  static void set_context_factor(const double factor);
+  static double get_context_factor();
+
   double get_scale_factor() const { return scale_factor_; }
   double get_width() const { return x2_ - x1_;  }
   double get_height() const { return y2_ - y1_; }
@@ -10,6 +10,10 @@
 #include <string>
 #include <cstdio>
 #include <vector>
+#include <atomic>
+#include <thread>
+
+#include "helper/rng.h"
 
 namespace bfs = boost::filesystem;
 
@@ -118,23 +122,90 @@ void find_matching_files(const bfs::path& folder, const boost::regex filter,
   std::sort(files->begin(), files->end());
 }
 
-double sample_rand_uniform() {
+void find_files_with_extension(const bfs::path& folder, const string& extension,
+                               vector<string>* files) {
+  if (!bfs::is_directory(folder)) {
+    printf("Error - %s is not a valid directory!\n", folder.c_str());
+    return;
+  }
+
+  bfs::directory_iterator end_itr; // default construction yields past-the-end
+  for (bfs::directory_iterator itr(folder); itr != end_itr; ++itr) {
+    const string filename = itr->path().filename().string();
+    if (filename.size() >= extension.size() &&
+        filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0 &&
+        bfs::is_regular_file(itr->status())) {
+      files->push_back(filename);
+    }
+  }
+
+  // Sort the files by name.
+  std::sort(files->begin(), files->end());
+}
+
+// *******Threading*************
+
+size_t get_num_threads(const int num_threads) {
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void parallel_for_thread(const size_t num_items, const int num_threads,
+                         const std::function<void(size_t, size_t)>& func) {
+  // Choose the number of threads, but never more than there are items.
+  const size_t threads_to_use = std::max(static_cast<size_t>(1),
+                                         std::min(get_num_threads(num_threads), num_items));
+
+  // With a single thread, avoid the overhead of spawning one.
+  if (threads_to_use == 1) {
+    for (size_t i = 0; i < num_items; ++i) {
+      func(i, 0);
+    }
+    return;
+  }
+
+  // Each thread repeatedly grabs the next unprocessed item.
+  std::atomic<size_t> next_item(0);
+  vector<std::thread> threads;
+  for (size_t t = 0; t < threads_to_use; ++t) {
+    threads.push_back(std::thread([&, t]() {
+      for (size_t i = next_item++; i < num_items; i = next_item++) {
+        func(i, t);
+      }
+    }));
+  }
+
+  for (size_t t = 0; t < threads.size(); ++t) {
+    threads[t].join();
+  }
+}
+
+void parallel_for(const size_t num_items, const int num_threads,
+                  const std::function<void(size_t)>& func) {
+  parallel_for_thread(num_items, num_threads,
+                      [&](const size_t i, const size_t thread_num) { func(i); });
+}
+
+// *******Probability*************
+
+double sample_rand_uniform(Rng* rng) {
   // Generate a random number in (0,1)
-  // http://www.cplusplus.com/forum/beginner/7445/
-  return (rand() + 1) / (static_cast<double>(RAND_MAX) + 2);
+  return rng->Uniform();
 }
 
-double sample_exp(const double lambda) {
+double sample_exp(const double lambda, Rng* rng) {
   // Sample from an exponential - http://stackoverflow.com/questions/11491458/how-to-generate-random-numbers-with-exponential-distribution-with-mean
-  const double rand_uniform = sample_rand_uniform();
+  const double rand_uniform = sample_rand_uniform(rng);
   return -log(rand_uniform) / lambda;
 }
 
-double sample_exp_two_sided(const double lambda) {
+double sample_exp_two_sided(const double lambda, Rng* rng) {
   // Determine which side of the two-sided exponential we are sampling from.
-  const double pos_or_neg = (rand() % 2 == 0) ? 1 : -1;
+  const double pos_or_neg = (rng->UniformInt(2) == 0) ? 1 : -1;
 
   // Sample from an exponential - http://stackoverflow.com/questions/11491458/how-to-generate-random-numbers-with-exponential-distribution-with-mean
-  const double rand_uniform = sample_rand_uniform();
+  const double rand_uniform = sample_rand_uniform(rng);
   return log(rand_uniform) / lambda * pos_or_neg;
 }
@@ -10,6 +10,7 @@
 
 #include <string>
 #include <iostream>
+#include <functional>
 
 #include <boost/filesystem.hpp>
 #include <boost/regex.hpp>
@@ -19,6 +20,8 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+class Rng;
+
 // Convenience helper functions.
 
 // *******Number / string conversions*************
@@ -55,15 +58,44 @@ void find_subfolders(const boost::filesystem::path& folder, std::vector<std::str
 void find_matching_files(const boost::filesystem::path& folder, const boost::regex filter,
                          std::vector<std::string>* files);
 
+// Find all files within a given folder that end with the given extension (e.g. ".jpg").
+// Cheaper than find_matching_files on large folders, since no regex is matched per file.
+void find_files_with_extension(const boost::filesystem::path& folder, const std::string& extension,
+                               std::vector<std::string>* files);
+
+// Number of threads used by the loaders to scan dataset folders and parse annotations.
+// This is limited by I/O latency (especially on network storage) rather than by the CPU,
+// so it uses more threads than there are cores.
+const int kNumScanThreads = 16;
+
+// *******Threading*************
+// Call func(i) for every i in [0, num_items), spreading the calls over num_threads threads.
+// Items are handed out one at a time, so uneven work (e.g. videos of different lengths)
+// is balanced across the threads.  If num_threads <= 0, use one thread per core.
+void parallel_for(const size_t num_items, const int num_threads,
+                  const std::function<void(size_t)>& func);
+
+// Same as parallel_for, but func(i, thread_num) also receives the index of the calling
+// thread, in [0, get_num_threads(num_threads)), so that each thread can use its own
+// non-thread-safe objects (e.g. a network and a tracker).
+void parallel_for_thread(const size_t num_items, const int num_threads,
+                         const std::function<void(size_t, size_t)>& func);
+
+// Number of threads that parallel_for will use (one per core if num_threads <= 0).
+size_t get_num_threads(const int num_threads);
+
 // *******Probability*************
+// All samples are drawn from the given generator (see helper/rng.h), so that
+// each thread can use its own independent, seeded stream.
+
 // Generate a random number in (0,1)
-double sample_rand_uniform();
+double sample_rand_uniform(Rng* rng);
 
 // Sample from an exponential distribution.
-double sample_exp(const double lambda);
+double sample_exp(const double lambda, Rng* rng);
 
 // Sample from a Laplacian distribution, aka two-sided exponential.
-double sample_exp_two_sided(const double lambda);
+double sample_exp_two_sided(const double lambda, Rng* rng);
 
 #endif /* HELPER_H_ */
 
@@ -1,5 +1,10 @@
 #include "image_proc.h"
 
+#include <algorithm>
+
+#include "helper/metrics.h"
+#include "helper/profiler.h"
+
 void ComputeCropPadImageLocation(const BoundingBox& bbox_tight, const cv::Mat& image, BoundingBox* pad_image_location) {
   // Get the bounding box center.
   const double bbox_center_x = bbox_tight.get_center_x();
@@ -55,10 +60,24 @@ void CropPadImage(const BoundingBox& bbox_tight, const cv::Mat& image, cv::Mat*
   CropPadImage(bbox_tight, image, pad_image, &pad_image_location, &edge_spacing_x, &edge_spacing_y);
 }
 
-void CropPadImage(const BoundingBox& bbox_tight, const cv::Mat& image, cv::Mat* pad_image,
-                  BoundingBox* pad_image_location, double* edge_spacing_x, double* edge_spacing_y) {
-  // Crop the image based on the bounding box location, adding some padding.
+namespace {
+
+// Where the crop comes from in the image, and where it goes in the padded output.
+struct CropPadGeometry {
+  // Region of the image to crop.
+  cv::Rect roi;
+
+  // Location within the padded output to put the cropped region (accounting for edge effects).
+  cv::Rect output_rect;
 
+  // Size of the padded output.
+  int output_width;
+  int output_height;
+};
+
+void ComputeCropPadGeometry(const BoundingBox& bbox_tight, const cv::Mat& image,
+                            BoundingBox* pad_image_location, double* edge_spacing_x, double* edge_spacing_y,
+                            CropPadGeometry* geometry) {
   // Get the location of the cropped and padded image.
   ComputeCropPadImageLocation(bbox_tight, image, pad_image_location);
 
@@ -67,32 +86,89 @@ void CropPadImage(const BoundingBox& bbox_tight, const cv::Mat& image, cv::Mat*
   const double roi_bottom = std::min(pad_image_location->y1_, static_cast<double>(image.rows - 1));
   const double roi_width = std::min(static_cast<double>(image.cols), std::max(1.0, ceil(pad_image_location->x2_ - pad_image_location->x1_)));
   const double roi_height = std::min(static_cast<double>(image.rows), std::max(1.0, ceil(pad_image_location->y2_ - pad_image_location->y1_)));
+  geometry->roi = cv::Rect(roi_left, roi_bottom, roi_width, roi_height);
 
-  // Crop the image based on the ROI.
-  cv::Rect myROI(roi_left, roi_bottom, roi_width, roi_height);
-  cv::Mat cropped_image = image(myROI);
-
-  // Now we need to place the crop in a new image of the appropriate size,
-  // adding a black border where necessary to account for edge effects.
-
-  // Make a new image to store the output.
-  // The new image should have size: get_output_width(), get_output_height(), but
+  // The output should have size: get_output_width(), get_output_height(), but
   // to be safe we ensure that the output is not smaller than roi_width, roi_height.
   const double output_width = std::max(ceil(bbox_tight.compute_output_width()), roi_width);
   const double output_height = std::max(ceil(bbox_tight.compute_output_height()), roi_height);
-  cv::Mat output_image = cv::Mat(output_height, output_width, image.type(), cv::Scalar(0, 0, 0));
+  geometry->output_width = output_width;
+  geometry->output_height = output_height;
 
   // Compute the location to place the crop so that it will be centered at the
   // center of the bounding box (accounting for edge effects).
 
   // Get the amount that the output "sticks out" beyond the left and bottom edges of the image.
   // This might be 0, but it might be > 0 if the output is near the edge of the image.
-  *edge_spacing_x = std::min(bbox_tight.edge_spacing_x(), static_cast<double>(output_image.cols - 1));
-  *edge_spacing_y = std::min(bbox_tight.edge_spacing_y(), static_cast<double>(output_image.rows - 1));
+  *edge_spacing_x = std::min(bbox_tight.edge_spacing_x(), output_width - 1);
+  *edge_spacing_y = std::min(bbox_tight.edge_spacing_y(), output_height - 1);
 
   // Get the location within the output to put the cropped image (accounting for edge effects).
-  cv::Rect output_rect(*edge_spacing_x, *edge_spacing_y, roi_width, roi_height);
-  cv::Mat output_image_roi = output_image(output_rect);
+  geometry->output_rect = cv::Rect(*edge_spacing_x, *edge_spacing_y, roi_width, roi_height);
+}
+
+// Get the affine map from the pixels of an output of output_size to the pixels of
+// the image, for resampling the padded crop to output_size.
+void GetOutputToImage(const CropPadGeometry& geometry, const cv::Size& output_size,
+                      cv::Mat* output_to_image) {
+  // Scale from the output back to the padded crop.
+  const double scale_x = static_cast<double>(geometry.output_width) / output_size.width;
+  const double scale_y = static_cast<double>(geometry.output_height) / output_size.height;
+
+  // Offset of the padded crop within the image.
+  const double offset_x = geometry.roi.x - geometry.output_rect.x;
+  const double offset_y = geometry.roi.y - geometry.output_rect.y;
+
+  // Sample at pixel centers, as cv::resize does.
+  output_to_image->create(2, 3, CV_64F);
+  output_to_image->at<double>(0, 0) = scale_x;
+  output_to_image->at<double>(0, 1) = 0;
+  output_to_image->at<double>(0, 2) = offset_x + 0.5 * scale_x - 0.5;
+  output_to_image->at<double>(1, 0) = 0;
+  output_to_image->at<double>(1, 1) = scale_y;
+  output_to_image->at<double>(1, 2) = offset_y + 0.5 * scale_y - 0.5;
+}
+
+uchar ClampToByte(const int value) {
+  return static_cast<uchar>(std::min(255, std::max(0, value)));
+}
+
+// Convert a video-range BT.601 YUV pixel to BGR (the conversion that OpenCV uses for
+// NV12 and I420), in fixed point with 10 fractional bits.
+void YuvToBgr(const int y, const int u, const int v, uchar* bgr) {
+  const int luma = (y - 16) * 1192;
+  const int u_offset = u - 128;
+  const int v_offset = v - 128;
+  bgr[0] = ClampToByte((luma + 2066 * u_offset + 512) >> 10);
+  bgr[1] = ClampToByte((luma - 833 * v_offset - 400 * u_offset + 512) >> 10);
+  bgr[2] = ClampToByte((luma + 1634 * v_offset + 512) >> 10);
+}
+
+// Count the bytes written into a crop.
+void CountCropBytes(const cv::Mat& pad_image) {
+  static Counter* crop_bytes = MetricsRegistry::Get()->GetCounter(
+      "goturn_crop_bytes_total", "Bytes of image data written into crops.");
+  crop_bytes->Increment(pad_image.total() * pad_image.elemSize());
+}
+
+} // namespace
+
+void CropPadImage(const BoundingBox& bbox_tight, const cv::Mat& image, cv::Mat* pad_image,
+                  BoundingBox* pad_image_location, double* edge_spacing_x, double* edge_spacing_y) {
+  PROFILE_ZONE("CropPadImage");
+
+  // Crop the image based on the bounding box location, adding some padding.
+  CropPadGeometry geometry;
+  ComputeCropPadGeometry(bbox_tight, image, pad_image_location, edge_spacing_x, edge_spacing_y,
+                         &geometry);
+
+  // Crop the image based on the ROI.
+  cv::Mat cropped_image = image(geometry.roi);
+
+  // Now we need to place the crop in a new image of the appropriate size,
+  // adding a black border where necessary to account for edge effects.
+  cv::Mat output_image = cv::Mat(geometry.output_height, geometry.output_width, image.type(), cv::Scalar(0, 0, 0));
+  cv::Mat output_image_roi = output_image(geometry.output_rect);
 
   // Copy the cropped image to the specified location within the output.
   // Without edge effects, this will fill the output.
@@ -102,5 +178,106 @@ void CropPadImage(const BoundingBox& bbox_tight, const cv::Mat& image, cv::Mat*
 
   // Set the output.
   *pad_image = output_image;
+  CountCropBytes(*pad_image);
 }
 
+void CropPadImageResized(const BoundingBox& bbox_tight, const cv::Mat& image,
+                         const cv::Size& output_size, cv::Mat* pad_image,
+                         BoundingBox* pad_image_location, double* edge_spacing_x, double* edge_spacing_y,
+                         double* pad_width, double* pad_height) {
+  PROFILE_ZONE("CropPadImageResized");
+  CropPadGeometry geometry;
+  ComputeCropPadGeometry(bbox_tight, image, pad_image_location, edge_spacing_x, edge_spacing_y,
+                         &geometry);
+
+  *pad_width = geometry.output_width;
+  *pad_height = geometry.output_height;
+
+  // Pixels that fall outside of the image are set to black, which gives the same
+  // border as CropPadImage.
+  cv::Mat output_to_image;
+  GetOutputToImage(geometry, output_size, &output_to_image);
+  cv::warpAffine(image, *pad_image, output_to_image, output_size,
+                 cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_CONSTANT,
+                 cv::Scalar(0, 0, 0));
+  CountCropBytes(*pad_image);
+}
+
+void WrapNV12(uchar* data, const int width, const int height, const size_t stride,
+              YuvImage* image) {
+  image->y = cv::Mat(height, width, CV_8UC1, data, stride);
+  image->uv = cv::Mat(height / 2, width / 2, CV_8UC2, data + stride * height, stride);
+  image->u = cv::Mat();
+  image->v = cv::Mat();
+}
+
+void WrapI420(uchar* data, const int width, const int height, const size_t stride,
+              YuvImage* image) {
+  const size_t chroma_stride = stride / 2;
+  uchar* u_data = data + stride * height;
+  uchar* v_data = u_data + chroma_stride * (height / 2);
+  image->y = cv::Mat(height, width, CV_8UC1, data, stride);
+  image->uv = cv::Mat();
+  image->u = cv::Mat(height / 2, width / 2, CV_8UC1, u_data, chroma_stride);
+  image->v = cv::Mat(height / 2, width / 2, CV_8UC1, v_data, chroma_stride);
+}
+
+void CropPadImageResized(const BoundingBox& bbox_tight, const YuvImage& image,
+                         const cv::Size& output_size, cv::Mat* pad_image,
+                         BoundingBox* pad_image_location, double* edge_spacing_x, double* edge_spacing_y,
+                         double* pad_width, double* pad_height) {
+  PROFILE_ZONE("CropPadYuvImage");
+  CropPadGeometry geometry;
+  ComputeCropPadGeometry(bbox_tight, image.y, pad_image_location, edge_spacing_x, edge_spacing_y,
+                         &geometry);
+
+  *pad_width = geometry.output_width;
+  *pad_height = geometry.output_height;
+
+  const cv::Size size = output_size.area() > 0 ? output_size :
+      cv::Size(geometry.output_width, geometry.output_height);
+
+  cv::Mat output_to_image;
+  GetOutputToImage(geometry, size, &output_to_image);
+
+  // The chroma planes have half the resolution, so map the pixel centers to them:
+  // x_chroma = (x + 0.5) / 2 - 0.5.
+  cv::Mat output_to_chroma = output_to_image * 0.5;
+  output_to_chroma.at<double>(0, 2) -= 0.25;
+  output_to_chroma.at<double>(1, 2) -= 0.25;
+
+  // Resample the planes to the output.  Outside of the image, the luma is 0 and the
+  // chroma is neutral, which converts to black as in CropPadImage.
+  const int flags = cv::INTER_LINEAR | cv::WARP_INVERSE_MAP;
+  cv::Mat y;
+  cv::warpAffine(image.y, y, output_to_image, size, flags, cv::BORDER_CONSTANT,
+                 cv::Scalar(0));
+  cv::Mat uv;
+  cv::Mat u;
+  cv::Mat v;
+  if (image.uv.data) {
+    cv::warpAffine(image.uv, uv, output_to_chroma, size, flags, cv::BORDER_CONSTANT,
+                   cv::Scalar(128, 128));
+  } else {
+    cv::warpAffine(image.u, u, output_to_chroma, size, flags, cv::BORDER_CONSTANT,
+                   cv::Scalar(128));
+    cv::warpAffine(image.v, v, output_to_chroma, size, flags, cv::BORDER_CONSTANT,
+                   cv::Scalar(128));
+  }
+
+  // Convert the output pixels to BGR.
+  pad_image->create(size, CV_8UC3);
+  for (int row = 0; row < size.height; ++row) {
+    const uchar* y_row = y.ptr<uchar>(row);
+    const uchar* uv_row = uv.data ? uv.ptr<uchar>(row) : NULL;
+    const uchar* u_row = u.data ? u.ptr<uchar>(row) : NULL;
+    const uchar* v_row = v.data ? v.ptr<uchar>(row) : NULL;
+    uchar* bgr_row = pad_image->ptr<uchar>(row);
+    for (int col = 0; col < size.width; ++col) {
+      const int u_value = uv_row ? uv_row[2 * col] : u_row[col];
+      const int v_value = uv_row ? uv_row[2 * col + 1] : v_row[col];
+      YuvToBgr(y_row[col], u_value, v_value, bgr_row + 3 * col);
+    }
+  }
+  CountCropBytes(*pad_image);
+}
@@ -12,6 +12,44 @@ void CropPadImage(const BoundingBox& bbox_tight, const cv::Mat& image, cv::Mat*
 void CropPadImage(const BoundingBox& bbox_tight, const cv::Mat& image, cv::Mat* pad_image,
                   BoundingBox* pad_image_location, double* edge_spacing_x, double* edge_spacing_y);
 
+// Same as CropPadImage, but resample the padded crop directly to output_size with a single
+// affine warp, without building the full-resolution padded crop in between.
+// pad_width and pad_height are set to the size that the padded crop from CropPadImage would have,
+// so that boxes can be recentered and scaled relative to it exactly as before.
+void CropPadImageResized(const BoundingBox& bbox_tight, const cv::Mat& image,
+                         const cv::Size& output_size, cv::Mat* pad_image,
+                         BoundingBox* pad_image_location, double* edge_spacing_x, double* edge_spacing_y,
+                         double* pad_width, double* pad_height);
+
+// A frame in a YUV 4:2:0 format, as produced by cameras and hardware decoders:
+// a full-resolution luma plane (y) and half-resolution chroma, either interleaved
+// (NV12: uv, with 2 channels) or in separate planes (I420: u and v).
+struct YuvImage {
+  cv::Mat y;
+  cv::Mat uv;
+  cv::Mat u;
+  cv::Mat v;
+};
+
+// Wrap the planes of an NV12 frame buffer (the luma plane followed by the interleaved
+// chroma plane, both with stride bytes per row) without copying it.
+void WrapNV12(uchar* data, const int width, const int height, const size_t stride,
+              YuvImage* image);
+
+// Wrap the planes of an I420 frame buffer (the luma plane with stride bytes per row,
+// followed by the U and V planes with stride / 2 bytes per row) without copying it.
+void WrapI420(uchar* data, const int width, const int height, const size_t stride,
+              YuvImage* image);
+
+// Same as CropPadImageResized, but crop from a YUV frame into a BGR image.
+// The planes are resampled to output_size first, so only the output pixels are
+// converted to BGR (instead of the whole frame).
+// If output_size is empty, the output has the size of the padded crop.
+void CropPadImageResized(const BoundingBox& bbox_tight, const YuvImage& image,
+                         const cv::Size& output_size, cv::Mat* pad_image,
+                         BoundingBox* pad_image_location, double* edge_spacing_x, double* edge_spacing_y,
+                         double* pad_width, double* pad_height);
+
 // Compute the location of the cropped image, which is centered on the bounding box center
 // but has a size given by (output_width, output_height) to account for additional padding.
 // The cropped image location is also limited by the edge of the image.
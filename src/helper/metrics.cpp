@@ -0,0 +1,311 @@
+#include "metrics.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// How often the socket server checks whether it should stop.
+const int kPollMilliseconds = 100;
+
+void AppendSample(const string& name, const string& labels, const double value,
+                  string* text) {
+  char value_text[64];
+  snprintf(value_text, sizeof(value_text), "%.17g", value);
+  *text += name;
+  *text += labels;
+  text->push_back(' ');
+  *text += value_text;
+  text->push_back('\n');
+}
+
+void AtomicAdd(const double amount, std::atomic<double>* value) {
+  double current = value->load(std::memory_order_relaxed);
+  while (!value->compare_exchange_weak(current, current + amount,
+                                       std::memory_order_relaxed)) {
+  }
+}
+
+// Send all of text to the socket (without raising SIGPIPE if the client went away).
+bool SendAll(const int fd, const string& text) {
+  size_t num_written = 0;
+  while (num_written < text.size()) {
+    const ssize_t result = send(fd, text.data() + num_written, text.size() - num_written,
+                                MSG_NOSIGNAL);
+    if (result <= 0) {
+      return false;
+    }
+    num_written += result;
+  }
+  return true;
+}
+
+} // namespace
+
+void Counter::AppendSamples(const string& name, string* text) const {
+  AppendSample(name, "", get_value(), text);
+}
+
+void Gauge::Add(const double amount) {
+  AtomicAdd(amount, &value_);
+}
+
+void Gauge::AppendSamples(const string& name, string* text) const {
+  AppendSample(name, "", get_value(), text);
+}
+
+Histogram::Histogram(const vector<double>& bucket_bounds)
+  : bucket_bounds_(bucket_bounds),
+    sum_(0),
+    count_(0)
+{
+  for (size_t i = 0; i <= bucket_bounds_.size(); ++i) {
+    bucket_counts_.push_back(boost::shared_ptr<std::atomic<int64_t> >(
+        new std::atomic<int64_t>(0)));
+  }
+}
+
+void Histogram::Observe(const double value) {
+  size_t bucket = 0;
+  while (bucket < bucket_bounds_.size() && value > bucket_bounds_[bucket]) {
+    bucket++;
+  }
+  bucket_counts_[bucket]->fetch_add(1, std::memory_order_relaxed);
+  AtomicAdd(value, &sum_);
+  count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Histogram::AppendSamples(const string& name, string* text) const {
+  // The bucket counts are cumulative in the Prometheus format.
+  int64_t cumulative_count = 0;
+  for (size_t i = 0; i < bucket_counts_.size(); ++i) {
+    cumulative_count += bucket_counts_[i]->load(std::memory_order_relaxed);
+    string labels = "{le=\"";
+    if (i < bucket_bounds_.size()) {
+      char bound[64];
+      snprintf(bound, sizeof(bound), "%g", bucket_bounds_[i]);
+      labels += bound;
+    } else {
+      labels += "+Inf";
+    }
+    labels += "\"}";
+    AppendSample(name + "_bucket", labels, cumulative_count, text);
+  }
+  AppendSample(name + "_sum", "", sum_.load(std::memory_order_relaxed), text);
+  AppendSample(name + "_count", "", count_.load(std::memory_order_relaxed), text);
+}
+
+vector<double> Histogram::DurationBuckets() {
+  const double bounds[] = {0.0001, 0.0005, 0.001, 0.002, 0.005, 0.01, 0.02, 0.05,
+                           0.1, 0.2, 0.5, 1, 2, 5, 10};
+  return vector<double>(bounds, bounds + sizeof(bounds) / sizeof(bounds[0]));
+}
+
+vector<double> Histogram::PowerOfTwoBuckets(const double max_value) {
+  vector<double> bounds;
+  for (double bound = 1; bound <= max_value; bound *= 2) {
+    bounds.push_back(bound);
+  }
+  return bounds;
+}
+
+MetricsRegistry* MetricsRegistry::Get() {
+  static MetricsRegistry registry;
+  return &registry;
+}
+
+Metric* MetricsRegistry::GetOrAdd(const string& name, const string& help, Metric* metric) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<string, Entry>::iterator it = metrics_.find(name);
+  if (it != metrics_.end()) {
+    delete metric;
+    return it->second.metric.get();
+  }
+  Entry& entry = metrics_[name];
+  entry.help = help;
+  entry.metric.reset(metric);
+  return metric;
+}
+
+Counter* MetricsRegistry::GetCounter(const string& name, const string& help) {
+  Counter* counter = dynamic_cast<Counter*>(GetOrAdd(name, help, new Counter));
+  if (!counter) {
+    printf("Error - metric %s is not a counter\n", name.c_str());
+  }
+  return counter;
+}
+
+Gauge* MetricsRegistry::GetGauge(const string& name, const string& help) {
+  Gauge* gauge = dynamic_cast<Gauge*>(GetOrAdd(name, help, new Gauge));
+  if (!gauge) {
+    printf("Error - metric %s is not a gauge\n", name.c_str());
+  }
+  return gauge;
+}
+
+Histogram* MetricsRegistry::GetHistogram(const string& name, const string& help,
+                                         const vector<double>& bucket_bounds) {
+  Histogram* histogram = dynamic_cast<Histogram*>(
+      GetOrAdd(name, help, new Histogram(bucket_bounds)));
+  if (!histogram) {
+    printf("Error - metric %s is not a histogram\n", name.c_str());
+  }
+  return histogram;
+}
+
+void MetricsRegistry::FormatPrometheus(string* text) const {
+  text->clear();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::map<string, Entry>::const_iterator it = metrics_.begin();
+       it != metrics_.end(); ++it) {
+    const string& name = it->first;
+    *text += "# HELP " + name + " " + it->second.help + "\n";
+    *text += "# TYPE " + name + " " + it->second.metric->get_type() + "\n";
+    it->second.metric->AppendSamples(name, text);
+  }
+}
+
+void CountDecodedImage(const size_t num_bytes) {
+  static Counter* images_decoded = MetricsRegistry::Get()->GetCounter(
+      "goturn_images_decoded_total", "Images decoded from files.");
+  static Counter* bytes_decoded = MetricsRegistry::Get()->GetCounter(
+      "goturn_image_bytes_decoded_total", "Bytes of pixel data decoded from image files.");
+  images_decoded->Increment();
+  bytes_decoded->Increment(num_bytes);
+}
+
+MetricsExporter::MetricsExporter(const MetricsRegistry* registry, const string& target,
+                                 const double interval_seconds)
+  : registry_(registry),
+    target_(target),
+    interval_seconds_(interval_seconds),
+    socket_fd_(-1),
+    stop_(false)
+{
+  const string socket_prefix = "unix:";
+  if (target.compare(0, socket_prefix.size(), socket_prefix) == 0) {
+    socket_path_ = target.substr(socket_prefix.size());
+  }
+}
+
+MetricsExporter::~MetricsExporter() {
+  if (!thread_.joinable()) {
+    // Not started.
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  stop_condition_.notify_all();
+  thread_.join();
+
+  if (socket_fd_ >= 0) {
+    close(socket_fd_);
+    unlink(socket_path_.c_str());
+  } else {
+    WriteFile();
+  }
+}
+
+bool MetricsExporter::Start() {
+  if (socket_path_.empty()) {
+    thread_ = std::thread(&MetricsExporter::WriteFileLoop, this);
+    return true;
+  }
+
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path_.size() >= sizeof(address.sun_path)) {
+    printf("Error - socket path too long: %s\n", socket_path_.c_str());
+    return false;
+  }
+  strncpy(address.sun_path, socket_path_.c_str(), sizeof(address.sun_path) - 1);
+
+  // Replace the socket of an earlier run.
+  unlink(socket_path_.c_str());
+
+  socket_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (socket_fd_ < 0 ||
+      bind(socket_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(socket_fd_, 4) != 0) {
+    printf("Error - could not serve the metrics on %s: %s\n", socket_path_.c_str(),
+           strerror(errno));
+    if (socket_fd_ >= 0) {
+      close(socket_fd_);
+      socket_fd_ = -1;
+    }
+    return false;
+  }
+
+  thread_ = std::thread(&MetricsExporter::ServeSocketLoop, this);
+  return true;
+}
+
+void MetricsExporter::WriteFileLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    lock.unlock();
+    WriteFile();
+    lock.lock();
+    stop_condition_.wait_for(lock, std::chrono::duration<double>(interval_seconds_),
+                             [this]() { return stop_; });
+  }
+}
+
+void MetricsExporter::ServeSocketLoop() {
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_) {
+        return;
+      }
+    }
+
+    pollfd poll_fd;
+    poll_fd.fd = socket_fd_;
+    poll_fd.events = POLLIN;
+    if (poll(&poll_fd, 1, kPollMilliseconds) <= 0) {
+      continue;
+    }
+
+    // Send the current metrics to the client and close the connection.
+    const int client_fd = accept(socket_fd_, NULL, NULL);
+    if (client_fd < 0) {
+      continue;
+    }
+    string text;
+    registry_->FormatPrometheus(&text);
+    SendAll(client_fd, text);
+    close(client_fd);
+  }
+}
+
+void MetricsExporter::WriteFile() const {
+  string text;
+  registry_->FormatPrometheus(&text);
+
+  // Write to a temporary file first, so that readers never see a partial file.
+  const string temp_file = target_ + ".tmp";
+  FILE* file = fopen(temp_file.c_str(), "w");
+  if (!file) {
+    printf("Error - could not write the metrics to %s\n", temp_file.c_str());
+    return;
+  }
+  const bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+  if (fclose(file) != 0 || !written || rename(temp_file.c_str(), target_.c_str()) != 0) {
+    printf("Error - could not write the metrics to %s\n", target_.c_str());
+  }
+}
@@ -0,0 +1,176 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+// Metrics of a running process (e.g. frames tracked, images decoded, queue depths),
+// which can be exported in the Prometheus text format while the process runs.
+//
+// The metrics are created once and then updated without locking, e.g.
+//   static Counter* frames_tracked = MetricsRegistry::Get()->GetCounter(
+//       "goturn_frames_tracked_total", "Frames tracked.");
+//   frames_tracked->Increment();
+
+// Base class of all metrics.
+class Metric
+{
+public:
+  virtual ~Metric() {}
+
+  // Append the samples of the metric in the Prometheus text format.
+  virtual void AppendSamples(const std::string& name, std::string* text) const = 0;
+
+  // Prometheus type of the metric.
+  virtual const char* get_type() const = 0;
+};
+
+// A count that only goes up.
+class Counter : public Metric
+{
+public:
+  Counter() : value_(0) {}
+
+  void Increment(const int64_t amount = 1) {
+    value_.fetch_add(amount, std::memory_order_relaxed);
+  }
+
+  int64_t get_value() const { return value_.load(std::memory_order_relaxed); }
+
+  virtual void AppendSamples(const std::string& name, std::string* text) const;
+  virtual const char* get_type() const { return "counter"; }
+
+private:
+  std::atomic<int64_t> value_;
+};
+
+// A value that goes up and down.
+class Gauge : public Metric
+{
+public:
+  Gauge() : value_(0) {}
+
+  void Set(const double value) { value_.store(value, std::memory_order_relaxed); }
+  void Add(const double amount);
+
+  double get_value() const { return value_.load(std::memory_order_relaxed); }
+
+  virtual void AppendSamples(const std::string& name, std::string* text) const;
+  virtual const char* get_type() const { return "gauge"; }
+
+private:
+  std::atomic<double> value_;
+};
+
+// Counts of observed values in buckets, with their sum.
+class Histogram : public Metric
+{
+public:
+  // bucket_bounds are the increasing upper bounds of the buckets (a bucket for
+  // larger values is added).
+  explicit Histogram(const std::vector<double>& bucket_bounds);
+
+  void Observe(const double value);
+
+  virtual void AppendSamples(const std::string& name, std::string* text) const;
+  virtual const char* get_type() const { return "histogram"; }
+
+  // Bucket bounds for durations in seconds, from 0.1 ms to 10 s.
+  static std::vector<double> DurationBuckets();
+
+  // Bucket bounds 1, 2, 4, ..., up to max_value.
+  static std::vector<double> PowerOfTwoBuckets(const double max_value);
+
+private:
+  std::vector<double> bucket_bounds_;
+
+  // Number of values in each bucket (not cumulative), with the last for larger values.
+  std::vector<boost::shared_ptr<std::atomic<int64_t> > > bucket_counts_;
+
+  std::atomic<double> sum_;
+  std::atomic<int64_t> count_;
+};
+
+// Holds the metrics of the process by name.
+class MetricsRegistry
+{
+public:
+  // The registry of the process.
+  static MetricsRegistry* Get();
+
+  // Get the metric with the given name, creating it on first use.  The metric
+  // lives as long as the registry, so callers can keep the pointer.
+  Counter* GetCounter(const std::string& name, const std::string& help);
+  Gauge* GetGauge(const std::string& name, const std::string& help);
+  Histogram* GetHistogram(const std::string& name, const std::string& help,
+                          const std::vector<double>& bucket_bounds);
+
+  // Get all metrics in the Prometheus text format.
+  void FormatPrometheus(std::string* text) const;
+
+private:
+  struct Entry {
+    std::string help;
+    boost::shared_ptr<Metric> metric;
+  };
+
+  // Get the metric with the given name, or add the given one if there is none.
+  Metric* GetOrAdd(const std::string& name, const std::string& help, Metric* metric);
+
+  std::map<std::string, Entry> metrics_;
+  mutable std::mutex mutex_;
+};
+
+// Count an image of num_bytes (decoded pixel data) that was decoded from a file.
+void CountDecodedImage(const size_t num_bytes);
+
+// Exports the metrics of a registry from a background thread, either by rewriting a
+// file every interval (e.g. for the textfile collector of the Prometheus node exporter),
+// or by serving them on a local socket, to each client that connects.
+class MetricsExporter
+{
+public:
+  // target is a file name, or "unix:" followed by the path of the socket to create.
+  MetricsExporter(const MetricsRegistry* registry, const std::string& target,
+                  const double interval_seconds);
+
+  // Stop exporting (writing the file a final time).
+  ~MetricsExporter();
+
+  // Start exporting.  Returns false if the socket could not be created.
+  bool Start();
+
+private:
+  // Rewrite the file every interval until stopped.
+  void WriteFileLoop();
+
+  // Serve the metrics on the socket until stopped.
+  void ServeSocketLoop();
+
+  // Replace the file with the current metrics.
+  void WriteFile() const;
+
+  const MetricsRegistry* registry_;
+  std::string target_;
+  double interval_seconds_;
+
+  // Path of the socket, or empty when writing a file.
+  std::string socket_path_;
+  int socket_fd_;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable stop_condition_;
+  bool stop_;
+};
+
+#endif // METRICS_H
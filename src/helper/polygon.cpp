@@ -0,0 +1,81 @@
+#include "polygon.h"
+
+#include <cmath>
+
+namespace {
+
+// Clip the polygon to the half-plane on which sign * (coordinate - boundary) >= 0,
+// where the coordinate is x if clip_x is true and y otherwise.
+// One step of the Sutherland-Hodgman algorithm.
+void ClipToHalfPlane(const Polygon& input, const bool clip_x,
+                     const double boundary, const double sign,
+                     Polygon* output) {
+  output->x.clear();
+  output->y.clear();
+
+  const size_t num_vertices = input.x.size();
+  for (size_t i = 0; i < num_vertices; ++i) {
+    // Get the edge from the previous vertex to this vertex.
+    const size_t prev = (i + num_vertices - 1) % num_vertices;
+    const double x_prev = input.x[prev];
+    const double y_prev = input.y[prev];
+    const double x_curr = input.x[i];
+    const double y_curr = input.y[i];
+
+    // Signed distance of each vertex from the boundary (>= 0 is inside).
+    const double dist_prev = sign * ((clip_x ? x_prev : y_prev) - boundary);
+    const double dist_curr = sign * ((clip_x ? x_curr : y_curr) - boundary);
+
+    // If the edge crosses the boundary, add the crossing point.
+    if ((dist_prev >= 0) != (dist_curr >= 0)) {
+      const double t = dist_prev / (dist_prev - dist_curr);
+      output->x.push_back(x_prev + t * (x_curr - x_prev));
+      output->y.push_back(y_prev + t * (y_curr - y_prev));
+    }
+
+    // Keep the vertex if it is inside.
+    if (dist_curr >= 0) {
+      output->x.push_back(x_curr);
+      output->y.push_back(y_curr);
+    }
+  }
+}
+
+} // namespace
+
+double ComputePolygonArea(const Polygon& polygon) {
+  // Shoelace formula.
+  const size_t num_vertices = polygon.x.size();
+  double twice_area = 0;
+  for (size_t i = 0; i < num_vertices; ++i) {
+    const size_t next = (i + 1) % num_vertices;
+    twice_area += polygon.x[i] * polygon.y[next] - polygon.x[next] * polygon.y[i];
+  }
+  return fabs(twice_area) / 2;
+}
+
+double ComputePolygonIntersection(const Polygon& polygon, const BoundingBox& bbox) {
+  // The bounding box may have been given with its corners swapped.
+  const double x_min = std::min(bbox.x1_, bbox.x2_);
+  const double x_max = std::max(bbox.x1_, bbox.x2_);
+  const double y_min = std::min(bbox.y1_, bbox.y2_);
+  const double y_max = std::max(bbox.y1_, bbox.y2_);
+
+  // Clip the polygon against each of the 4 sides of the bounding box in turn.
+  // Since the bounding box is convex, what remains is the intersection.
+  Polygon clipped = polygon;
+  Polygon temp;
+  ClipToHalfPlane(clipped, true, x_min, 1, &temp);
+  ClipToHalfPlane(temp, true, x_max, -1, &clipped);
+  ClipToHalfPlane(clipped, false, y_min, 1, &temp);
+  ClipToHalfPlane(temp, false, y_max, -1, &clipped);
+
+  return ComputePolygonArea(clipped);
+}
+
+double ComputePolygonOverlap(const Polygon& polygon, const BoundingBox& bbox) {
+  const double polygon_area = ComputePolygonArea(polygon);
+  const double bbox_area = fabs(bbox.get_width() * bbox.get_height());
+  const double intersection = ComputePolygonIntersection(polygon, bbox);
+  return intersection / (polygon_area + bbox_area - intersection);
+}
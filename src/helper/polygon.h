@@ -0,0 +1,26 @@
+#ifndef POLYGON_H
+#define POLYGON_H
+
+#include <vector>
+
+#include "helper/bounding_box.h"
+
+// A simple (non-self-intersecting) polygon, given by its vertices in order.
+// Used for ground-truth annotations that are not axis-aligned rectangles,
+// e.g. the 4-corner polygons of ALOV and VOT.
+struct Polygon {
+  std::vector<double> x;
+  std::vector<double> y;
+};
+
+// Area enclosed by the polygon (independent of the vertex orientation).
+double ComputePolygonArea(const Polygon& polygon);
+
+// Area of intersection between the polygon and an axis-aligned bounding box.
+double ComputePolygonIntersection(const Polygon& polygon, const BoundingBox& bbox);
+
+// Intersection over union between the polygon and the bounding box
+// (the Pascal overlap measure).
+double ComputePolygonOverlap(const Polygon& polygon, const BoundingBox& bbox);
+
+#endif // POLYGON_H
@@ -0,0 +1,285 @@
+#include "profiler.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <mutex>
+
+#include <boost/shared_ptr.hpp>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Maximum number of zones recorded per thread (about 24 MB); later zones are dropped.
+const size_t kMaxZonesPerThread = 1 << 20;
+
+// A zone that a thread entered and left.
+struct ZoneRecord {
+  const char* name;
+  int64_t start_ns;
+  int64_t end_ns;
+};
+
+// The zones recorded by one thread.  Only that thread adds zones, so the lock is
+// uncontended except while the zones are read.
+struct ThreadZones {
+  int thread_id;
+  string thread_name;
+  std::mutex mutex;
+  vector<ZoneRecord> zones;
+  size_t num_dropped;
+};
+
+// The zones of all threads that recorded any.  The zones are kept after their
+// thread exits, so that loader threads still show up in the trace, until Clear().
+std::mutex all_threads_mutex;
+vector<boost::shared_ptr<ThreadZones> > all_threads;
+
+// Number of threads that recorded any zones so far (the last thread id).
+int num_thread_ids = 0;
+
+// The zones of the calling thread.  Besides all_threads, this is the only owner of
+// the zones, so once the thread has exited, all_threads holds the only reference.
+thread_local boost::shared_ptr<ThreadZones> this_thread_zones;
+
+ThreadZones* GetThreadZones() {
+  if (!this_thread_zones) {
+    this_thread_zones.reset(new ThreadZones);
+    this_thread_zones->num_dropped = 0;
+    std::lock_guard<std::mutex> lock(all_threads_mutex);
+    this_thread_zones->thread_id = ++num_thread_ids;
+    all_threads.push_back(this_thread_zones);
+  }
+  return this_thread_zones.get();
+}
+
+// Copy the zones of all threads.
+void GetAllZones(vector<vector<ZoneRecord> >* zones, vector<int>* thread_ids,
+                 vector<string>* thread_names, size_t* num_dropped) {
+  std::lock_guard<std::mutex> lock(all_threads_mutex);
+  *num_dropped = 0;
+  for (size_t i = 0; i < all_threads.size(); ++i) {
+    ThreadZones* thread_zones = all_threads[i].get();
+    std::lock_guard<std::mutex> thread_lock(thread_zones->mutex);
+    zones->push_back(thread_zones->zones);
+    thread_ids->push_back(thread_zones->thread_id);
+    thread_names->push_back(thread_zones->thread_name);
+    *num_dropped += thread_zones->num_dropped;
+  }
+}
+
+// Order the zones of a thread so that each zone comes after the zones that it is nested in.
+bool EnteredBefore(const ZoneRecord& zone1, const ZoneRecord& zone2) {
+  if (zone1.start_ns != zone2.start_ns) {
+    return zone1.start_ns < zone2.start_ns;
+  }
+  return zone1.end_ns > zone2.end_ns;
+}
+
+// Get the value at the given fraction of the sorted values (nearest rank).
+double GetPercentile(const vector<double>& sorted_values, const double fraction) {
+  const size_t rank = static_cast<size_t>(std::ceil(fraction * sorted_values.size()));
+  return sorted_values[std::max(rank, static_cast<size_t>(1)) - 1];
+}
+
+void WriteJsonString(const string& value, FILE* file) {
+  fputc('"', file);
+  for (size_t i = 0; i < value.size(); ++i) {
+    const char c = value[i];
+    if (c == '"' || c == '\\') {
+      fputc('\\', file);
+      fputc(c, file);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      fprintf(file, "\\u%04x", c);
+    } else {
+      fputc(c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::enabled_(false);
+
+void Profiler::Enable() {
+  enabled_ = true;
+}
+
+void Profiler::Disable() {
+  enabled_ = false;
+}
+
+void Profiler::SetThreadName(const string& name) {
+  if (!IsEnabled()) {
+    return;
+  }
+  ThreadZones* thread_zones = GetThreadZones();
+  std::lock_guard<std::mutex> lock(thread_zones->mutex);
+  thread_zones->thread_name = name;
+}
+
+void Profiler::Record(const char* name, const int64_t start_ns, const int64_t end_ns) {
+  ThreadZones* thread_zones = GetThreadZones();
+  std::lock_guard<std::mutex> lock(thread_zones->mutex);
+  if (thread_zones->zones.size() >= kMaxZonesPerThread) {
+    thread_zones->num_dropped++;
+    return;
+  }
+  ZoneRecord zone;
+  zone.name = name;
+  zone.start_ns = start_ns;
+  zone.end_ns = end_ns;
+  thread_zones->zones.push_back(zone);
+}
+
+int64_t Profiler::Now() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void Profiler::GetStats(vector<ZoneStats>* stats) {
+  vector<vector<ZoneRecord> > all_zones;
+  vector<int> thread_ids;
+  vector<string> thread_names;
+  size_t num_dropped;
+  GetAllZones(&all_zones, &thread_ids, &thread_names, &num_dropped);
+
+  // Find the path of each zone from the zones that it is nested in, and collect
+  // the durations for each path.
+  std::map<string, vector<double> > path_durations;
+  for (size_t i = 0; i < all_zones.size(); ++i) {
+    vector<ZoneRecord>& zones = all_zones[i];
+    std::sort(zones.begin(), zones.end(), EnteredBefore);
+
+    // The zones that the current zone is nested in: when each was left, and its path.
+    vector<std::pair<int64_t, string> > open_zones;
+    for (size_t j = 0; j < zones.size(); ++j) {
+      const ZoneRecord& zone = zones[j];
+      while (!open_zones.empty() && open_zones.back().first <= zone.start_ns) {
+        open_zones.pop_back();
+      }
+      string path = open_zones.empty() ? string() : open_zones.back().second + "/";
+      path += zone.name;
+      path_durations[path].push_back((zone.end_ns - zone.start_ns) / 1e6);
+      open_zones.push_back(std::make_pair(zone.end_ns, path));
+    }
+  }
+
+  stats->clear();
+  for (std::map<string, vector<double> >::iterator it = path_durations.begin();
+       it != path_durations.end(); ++it) {
+    vector<double>& durations = it->second;
+    std::sort(durations.begin(), durations.end());
+
+    ZoneStats zone_stats;
+    zone_stats.path = it->first;
+    zone_stats.count = durations.size();
+    zone_stats.total_ms = 0;
+    for (size_t i = 0; i < durations.size(); ++i) {
+      zone_stats.total_ms += durations[i];
+    }
+    zone_stats.min_ms = durations.front();
+    zone_stats.max_ms = durations.back();
+    zone_stats.median_ms = GetPercentile(durations, 0.5);
+    zone_stats.p90_ms = GetPercentile(durations, 0.9);
+    zone_stats.p99_ms = GetPercentile(durations, 0.99);
+    stats->push_back(zone_stats);
+  }
+}
+
+void Profiler::PrintStats() {
+  vector<ZoneStats> stats;
+  GetStats(&stats);
+
+  printf("%-48s %10s %12s %10s %10s %10s %10s %10s\n", "Zone", "count", "total ms",
+         "min ms", "median ms", "p90 ms", "p99 ms", "max ms");
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const ZoneStats& zone_stats = stats[i];
+    printf("%-48s %10lld %12.3lf %10.3lf %10.3lf %10.3lf %10.3lf %10.3lf\n",
+           zone_stats.path.c_str(), static_cast<long long>(zone_stats.count),
+           zone_stats.total_ms, zone_stats.min_ms, zone_stats.median_ms,
+           zone_stats.p90_ms, zone_stats.p99_ms, zone_stats.max_ms);
+  }
+}
+
+bool Profiler::WriteChromeTrace(const string& trace_file) {
+  vector<vector<ZoneRecord> > all_zones;
+  vector<int> thread_ids;
+  vector<string> thread_names;
+  size_t num_dropped;
+  GetAllZones(&all_zones, &thread_ids, &thread_names, &num_dropped);
+
+  FILE* file = fopen(trace_file.c_str(), "w");
+  if (!file) {
+    printf("Error - could not write the trace to %s\n", trace_file.c_str());
+    return false;
+  }
+
+  // Start the timeline at the first zone.
+  int64_t first_ns = 0;
+  bool found_first = false;
+  for (size_t i = 0; i < all_zones.size(); ++i) {
+    for (size_t j = 0; j < all_zones[i].size(); ++j) {
+      if (!found_first || all_zones[i][j].start_ns < first_ns) {
+        first_ns = all_zones[i][j].start_ns;
+        found_first = true;
+      }
+    }
+  }
+
+  // Write each zone as a complete event ("X"), with the times in microseconds.
+  fprintf(file, "{\"traceEvents\":[\n");
+  bool first_event = true;
+  for (size_t i = 0; i < all_zones.size(); ++i) {
+    const int thread_id = thread_ids[i];
+    if (!thread_names[i].empty()) {
+      fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+              "\"args\":{\"name\":", first_event ? "" : ",\n", thread_id);
+      WriteJsonString(thread_names[i], file);
+      fprintf(file, "}}");
+      first_event = false;
+    }
+
+    const vector<ZoneRecord>& zones = all_zones[i];
+    for (size_t j = 0; j < zones.size(); ++j) {
+      fprintf(file, "%s{\"name\":", first_event ? "" : ",\n");
+      WriteJsonString(zones[j].name, file);
+      fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3lf,\"dur\":%.3lf}",
+              thread_id, (zones[j].start_ns - first_ns) / 1e3,
+              (zones[j].end_ns - zones[j].start_ns) / 1e3);
+      first_event = false;
+    }
+  }
+  fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  fclose(file);
+
+  printf("Wrote the trace to %s\n", trace_file.c_str());
+  if (num_dropped > 0) {
+    printf("(%zu zones were dropped after reaching the limit of %zu zones per thread)\n",
+           num_dropped, kMaxZonesPerThread);
+  }
+  return true;
+}
+
+void Profiler::Clear() {
+  std::lock_guard<std::mutex> lock(all_threads_mutex);
+  vector<boost::shared_ptr<ThreadZones> > running_threads;
+  for (size_t i = 0; i < all_threads.size(); ++i) {
+    // Drop the threads that have exited; they can record no more zones.
+    if (all_threads[i].use_count() == 1) {
+      continue;
+    }
+    std::lock_guard<std::mutex> thread_lock(all_threads[i]->mutex);
+    all_threads[i]->zones.clear();
+    all_threads[i]->num_dropped = 0;
+    running_threads.push_back(all_threads[i]);
+  }
+  all_threads.swap(running_threads);
+}
@@ -0,0 +1,80 @@
+#include "rng.h"
+
+// Credits:
+// xoshiro256** and splitmix64 by David Blackman and Sebastiano Vigna
+// http://prng.di.unimi.it/
+
+namespace {
+
+uint64_t rotl(const uint64_t x, const int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+// Used to expand the seed into the initial state.
+uint64_t splitmix64(uint64_t* x) {
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+} // namespace
+
+Rng::Rng(const uint64_t seed, const uint64_t stream) {
+  uint64_t x = seed;
+  for (int i = 0; i < 4; ++i) {
+    state_[i] = splitmix64(&x);
+  }
+
+  for (uint64_t i = 0; i < stream; ++i) {
+    Jump();
+  }
+}
+
+uint64_t Rng::Next() {
+  const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+  const uint64_t t = state_[1] << 17;
+
+  state_[2] ^= state_[0];
+  state_[3] ^= state_[1];
+  state_[1] ^= state_[2];
+  state_[0] ^= state_[3];
+
+  state_[2] ^= t;
+  state_[3] = rotl(state_[3], 45);
+
+  return result;
+}
+
+double Rng::Uniform() {
+  // Use the top 53 bits (the precision of a double), offset by half a step
+  // so that the result is never exactly 0 or 1.
+  return ((Next() >> 11) + 0.5) * (1.0 / (1ULL << 53));
+}
+
+size_t Rng::UniformInt(const size_t n) {
+  // Scale by n using the high bits of a 128-bit product, which avoids
+  // the bias and the division of Next() % n.
+  return static_cast<size_t>((static_cast<unsigned __int128>(Next()) * n) >> 64);
+}
+
+void Rng::Jump() {
+  static const uint64_t kJump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                                    0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+
+  uint64_t state[4] = { 0, 0, 0, 0 };
+  for (int i = 0; i < 4; ++i) {
+    for (int b = 0; b < 64; ++b) {
+      if (kJump[i] & (1ULL << b)) {
+        for (int j = 0; j < 4; ++j) {
+          state[j] ^= state_[j];
+        }
+      }
+      Next();
+    }
+  }
+
+  for (int j = 0; j < 4; ++j) {
+    state_[j] = state[j];
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <cstddef>
+
+// A fast random number generator (xoshiro256**) with independent streams.
+// Unlike rand(), each Rng has its own state, so each thread can sample from
+// its own generator without locking, and the samples only depend on the seed
+// and the stream (not on how the threads are scheduled).
+// Not thread-safe: use one Rng per thread.
+class Rng
+{
+public:
+  // Use stream number stream of the sequence for the given seed.
+  // Different streams do not overlap, so each thread can use the same seed
+  // with its own stream number.
+  Rng(const uint64_t seed, const uint64_t stream = 0);
+
+  // Generate a random 64-bit integer.
+  uint64_t Next();
+
+  // Generate a random number in (0,1).
+  double Uniform();
+
+  // Generate a random integer in [0, n).
+  size_t UniformInt(const size_t n);
+
+  // Interface of a standard random number engine (e.g. for std::shuffle).
+  typedef uint64_t result_type;
+  static result_type min() { return 0; }
+  static result_type max() { return UINT64_MAX; }
+  result_type operator()() { return Next(); }
+
+private:
+  // Advance the state by 2^128 samples, to the start of the next stream.
+  void Jump();
+
+  uint64_t state_[4];
+};
+
+#endif // RNG_H
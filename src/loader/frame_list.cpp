@@ -0,0 +1,148 @@
+#include "frame_list.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+using std::string;
+using std::vector;
+
+struct FrameList::Names {
+  Names()
+    : is_pattern(false),
+      num_digits(0),
+      first_number(0),
+      num_frames(0)
+  {
+  }
+
+  // Names of the form prefix + zero-padded number + suffix.
+  bool is_pattern;
+  string prefix;
+  int num_digits;
+  string suffix;
+  int first_number;
+  size_t num_frames;
+
+  // Otherwise, all names concatenated, and the offset of each name
+  // (with the end of the last name at the end).
+  string chars;
+  vector<uint32_t> offsets;
+};
+
+namespace {
+
+// Format number zero-padded to num_digits and append it to output.
+void AppendNumber(const int number, const int num_digits, string* output) {
+  char digits[32];
+  const int length = snprintf(digits, sizeof(digits), "%0*d", num_digits, number);
+  output->append(digits, length);
+}
+
+// Find the last run of digits in name, and check whether all of the names follow the
+// pattern prefix + number + suffix with consecutive numbers.
+bool FindPattern(const vector<string>& names, FrameList* frame_list) {
+  if (names.empty()) {
+    return false;
+  }
+
+  const string& first_name = names[0];
+  const size_t digits_end = first_name.find_last_of("0123456789");
+  if (digits_end == string::npos) {
+    return false;
+  }
+  const size_t digits_begin = first_name.find_last_not_of("0123456789", digits_end) + 1;
+  const int num_digits = digits_end + 1 - digits_begin;
+  if (num_digits > 9) {
+    return false;
+  }
+
+  const string& prefix = first_name.substr(0, digits_begin);
+  const string& suffix = first_name.substr(digits_end + 1);
+  const int first_number = atoi(first_name.substr(digits_begin, num_digits).c_str());
+
+  string expected_name;
+  for (size_t i = 0; i < names.size(); ++i) {
+    expected_name = prefix;
+    AppendNumber(first_number + i, num_digits, &expected_name);
+    expected_name += suffix;
+    if (names[i] != expected_name) {
+      return false;
+    }
+  }
+
+  *frame_list = FrameList(prefix, num_digits, suffix, first_number, names.size());
+  return true;
+}
+
+} // namespace
+
+FrameList::FrameList()
+  : names_(new Names())
+{
+}
+
+FrameList::FrameList(const vector<string>& names) {
+  if (FindPattern(names, this)) {
+    return;
+  }
+
+  Names* stored_names = new Names();
+  names_.reset(stored_names);
+
+  size_t num_chars = 0;
+  for (size_t i = 0; i < names.size(); ++i) {
+    num_chars += names[i].size();
+  }
+  stored_names->chars.reserve(num_chars);
+  stored_names->offsets.reserve(names.size() + 1);
+  for (size_t i = 0; i < names.size(); ++i) {
+    stored_names->offsets.push_back(stored_names->chars.size());
+    stored_names->chars += names[i];
+  }
+  stored_names->offsets.push_back(stored_names->chars.size());
+  stored_names->num_frames = names.size();
+}
+
+FrameList::FrameList(const string& prefix, const int num_digits, const string& suffix,
+                     const int first_number, const size_t num_frames) {
+  Names* stored_names = new Names();
+  names_.reset(stored_names);
+  stored_names->is_pattern = true;
+  stored_names->prefix = prefix;
+  stored_names->num_digits = num_digits;
+  stored_names->suffix = suffix;
+  stored_names->first_number = first_number;
+  stored_names->num_frames = num_frames;
+}
+
+size_t FrameList::size() const {
+  return names_->num_frames;
+}
+
+bool FrameList::is_pattern() const {
+  return names_->is_pattern;
+}
+
+string FrameList::operator[](const size_t i) const {
+  string name;
+  AppendName(i, &name);
+  return name;
+}
+
+void FrameList::AppendName(const size_t i, string* path) const {
+  const Names& names = *names_;
+  if (names.is_pattern) {
+    path->append(names.prefix);
+    AppendNumber(names.first_number + i, names.num_digits, path);
+    path->append(names.suffix);
+  } else {
+    path->append(names.chars, names.offsets[i], names.offsets[i + 1] - names.offsets[i]);
+  }
+}
+
+size_t FrameList::get_num_bytes() const {
+  const Names& names = *names_;
+  return sizeof(names) + names.prefix.capacity() + names.suffix.capacity() +
+         names.chars.capacity() + names.offsets.capacity() * sizeof(uint32_t);
+}
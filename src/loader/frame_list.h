@@ -0,0 +1,49 @@
+#ifndef FRAME_LIST_H
+#define FRAME_LIST_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+// The names of the image files of a video, stored compactly.  The list cannot be
+// modified, and copies share the same storage, so copying a video is cheap.
+// Names that follow a numeric pattern (e.g. 00000001.jpg, 00000002.jpg, ...) are
+// stored as just the pattern; other names are stored in one contiguous buffer.
+class FrameList
+{
+public:
+  // An empty list.
+  FrameList();
+
+  // The given names, in order.
+  explicit FrameList(const std::vector<std::string>& names);
+
+  // num_frames names of the form prefix + number + suffix, with the numbers counting
+  // up from first_number, zero-padded to num_digits digits.
+  FrameList(const std::string& prefix, const int num_digits, const std::string& suffix,
+            const int first_number, const size_t num_frames);
+
+  size_t size() const;
+  bool empty() const { return size() == 0; }
+
+  // Get the name of frame i.
+  std::string operator[](const size_t i) const;
+
+  // Append the name of frame i to path.
+  void AppendName(const size_t i, std::string* path) const;
+
+  // Whether the names are stored as a numeric pattern.
+  bool is_pattern() const;
+
+  // Approximate memory used to store the names, in bytes.
+  size_t get_num_bytes() const;
+
+private:
+  struct Names;
+
+  boost::shared_ptr<const Names> names_;
+};
+
+#endif // FRAME_LIST_H
@@ -0,0 +1,154 @@
+#include "image_cache.h"
+
+#include <algorithm>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "helper/metrics.h"
+#include "helper/profiler.h"
+
+using std::string;
+
+namespace {
+
+// Memory used by the image data.
+size_t ImageBytes(const cv::Mat& image) {
+  return image.total() * image.elemSize();
+}
+
+} // namespace
+
+ImageCache::ImageCache(const size_t max_bytes)
+  : max_bytes_(max_bytes),
+    num_bytes_(0),
+    max_side_(0),
+    num_hits_(0),
+    num_misses_(0),
+    num_evictions_(0)
+{
+}
+
+ImageCache::ImageCache(const size_t max_bytes, const int max_side)
+  : max_bytes_(max_bytes),
+    num_bytes_(0),
+    max_side_(max_side),
+    num_hits_(0),
+    num_misses_(0),
+    num_evictions_(0)
+{
+}
+
+void ImageCache::LoadImage(const string& image_file, cv::Mat* image, double* scale) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::unordered_map<string, EntryList::iterator>::iterator it = entry_map_.find(image_file);
+    if (it != entry_map_.end()) {
+      // Move the entry to the front, marking it as the most recently used.
+      entries_.splice(entries_.begin(), entries_, it->second);
+      *image = it->second->image;
+      *scale = it->second->scale;
+      num_hits_++;
+      return;
+    }
+    num_misses_++;
+  }
+
+  // Decode (and downscale) without holding the lock, so that other threads can use
+  // the cache meanwhile.
+  PROFILE_ZONE("DecodeImage");
+  *scale = 1;
+  *image = cv::imread(image_file);
+  if (!image->data) {
+    return;
+  }
+  CountDecodedImage(ImageBytes(*image));
+
+  const int side = std::max(image->cols, image->rows);
+  if (max_side_ > 0 && side > max_side_) {
+    *scale = static_cast<double>(max_side_) / side;
+    cv::Mat image_resized;
+    cv::resize(*image, image_resized, cv::Size(), *scale, *scale, cv::INTER_AREA);
+    *image = image_resized;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (*scale != 1) {
+    scales_[image_file] = *scale;
+  }
+  Insert(image_file, *image, *scale);
+}
+
+bool ImageCache::GetScale(const string& image_file, double* scale) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unordered_map<string, EntryList::iterator>::const_iterator entry = entry_map_.find(image_file);
+  if (entry != entry_map_.end()) {
+    *scale = entry->second->scale;
+    return true;
+  }
+  std::unordered_map<string, double>::const_iterator it = scales_.find(image_file);
+  if (it == scales_.end()) {
+    return false;
+  }
+  *scale = it->second;
+  return true;
+}
+
+void ImageCache::Insert(const string& image_file, const cv::Mat& image, const double scale) {
+  // Another thread may have decoded the same image in the meantime.
+  if (entry_map_.find(image_file) != entry_map_.end()) {
+    return;
+  }
+
+  // Images larger than the whole budget are not cached.
+  const size_t image_bytes = ImageBytes(image);
+  if (image_bytes > max_bytes_) {
+    return;
+  }
+
+  // Evict the least recently used images until the new image fits.
+  while (num_bytes_ + image_bytes > max_bytes_) {
+    num_bytes_ -= ImageBytes(entries_.back().image);
+    entry_map_.erase(entries_.back().image_file);
+    entries_.pop_back();
+    num_evictions_++;
+  }
+
+  Entry entry;
+  entry.image_file = image_file;
+  entry.image = image;
+  entry.scale = scale;
+  entries_.push_front(entry);
+  entry_map_[image_file] = entries_.begin();
+  num_bytes_ += image_bytes;
+}
+
+void ImageCache::PrintStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const size_t num_loads = num_hits_ + num_misses_;
+  printf("Image cache: %zu hits, %zu misses (%.1lf%% hit rate), %zu evictions, "
+         "%zu images, %.1lf / %.1lf MB\n",
+         num_hits_, num_misses_, num_loads > 0 ? 100.0 * num_hits_ / num_loads : 0.0,
+         num_evictions_, entries_.size(),
+         num_bytes_ / (1024.0 * 1024.0), max_bytes_ / (1024.0 * 1024.0));
+}
+
+size_t ImageCache::get_num_bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_bytes_;
+}
+
+size_t ImageCache::get_num_hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+size_t ImageCache::get_num_misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_misses_;
+}
+
+size_t ImageCache::get_num_evictions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_evictions_;
+}
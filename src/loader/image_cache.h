@@ -0,0 +1,90 @@
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <opencv2/core/core.hpp>
+
+// A thread-safe cache of decoded images, keyed by file path, that keeps the most
+// recently used images up to a memory budget.  Used to avoid decoding the same
+// frames again when several trackers or samplers read the same images.
+class ImageCache
+{
+public:
+  // The cache holds at most max_bytes of decoded image data.
+  ImageCache(const size_t max_bytes);
+
+  // As above, but images with a side longer than max_side are downscaled (keeping
+  // their aspect ratio) before they are cached, so that more of them fit in the budget.
+  ImageCache(const size_t max_bytes, const int max_side);
+
+  // Load the image at the given path, decoding it only if it is not already in the cache.
+  // The returned image shares its data with the cache, so it must not be modified.
+  // scale is set to the size of the returned image relative to the image file
+  // (less than 1 if it was downscaled).
+  void LoadImage(const std::string& image_file, cv::Mat* image, double* scale);
+
+  // Get the scale that LoadImage gives for the given path, without decoding the image,
+  // changing its recency or counting a hit or miss.  Returns false if the image is
+  // not in the cache and its scale was never recorded: only downscaled images have
+  // their scale kept after they are evicted.
+  bool GetScale(const std::string& image_file, double* scale) const;
+
+  // Print the hit rate, evictions and memory use.
+  void PrintStats() const;
+
+  // Number of bytes of image data currently in the cache.
+  size_t get_num_bytes() const;
+
+  int get_max_side() const { return max_side_; }
+
+  // Number of loads that found the image in the cache, or had to decode it.
+  size_t get_num_hits() const;
+  size_t get_num_misses() const;
+
+  // Number of images evicted to stay within the memory budget.
+  size_t get_num_evictions() const;
+
+private:
+  // A decoded image and its scale relative to the image file.
+  struct Entry {
+    std::string image_file;
+    cv::Mat image;
+    double scale;
+  };
+
+  // Add a decoded image to the cache, evicting the least recently used images
+  // to stay within the memory budget.
+  void Insert(const std::string& image_file, const cv::Mat& image, const double scale);
+
+  // Entries from the most recently used to the least recently used.
+  typedef std::list<Entry> EntryList;
+  EntryList entries_;
+
+  // Location of each entry in entries_, keyed by path.
+  std::unordered_map<std::string, EntryList::iterator> entry_map_;
+
+  // Scale of the downscaled images decoded so far, kept after the image is evicted
+  // (images at their original size need no entry).
+  std::unordered_map<std::string, double> scales_;
+
+  // Memory budget and current usage.
+  size_t max_bytes_;
+  size_t num_bytes_;
+
+  // Longest side of the cached images (0 to keep the original size).
+  int max_side_;
+
+  // Number of hits, misses and evictions so far.
+  size_t num_hits_;
+  size_t num_misses_;
+  size_t num_evictions_;
+
+  // Protects all of the above.
+  mutable std::mutex mutex_;
+};
+
+#endif // IMAGE_CACHE_H
@@ -0,0 +1,325 @@
+#include "image_shards.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "helper/metrics.h"
+#include "helper/profiler.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// Identifies an index file (and its version).
+const uint32_t kIndexMagic = 0x47534831;  // "GSH1"
+
+// JPEG quality for the downscaled images.
+const int kJpegQuality = 95;
+
+string ShardPath(const string& prefix, const uint32_t shard_num) {
+  char shard_name[32];
+  sprintf(shard_name, "-%05u.shard", shard_num);
+  return prefix + shard_name;
+}
+
+string IndexPath(const string& prefix) {
+  return prefix + ".index";
+}
+
+} // namespace
+
+ImageShardWriter::ImageShardWriter(const string& prefix, const size_t max_shard_bytes,
+                                   const int max_side)
+  : prefix_(prefix),
+    max_shard_bytes_(max_shard_bytes),
+    max_side_(max_side),
+    shard_file_(NULL),
+    shard_num_(0),
+    shard_bytes_(0),
+    write_failed_(false)
+{
+}
+
+ImageShardWriter::~ImageShardWriter() {
+  if (shard_file_) {
+    fclose(shard_file_);
+  }
+}
+
+bool ImageShardWriter::AddImage(const string& image_file) {
+  const double smallest_box_side = 0;
+  const double min_box_side = 0;
+  return AddImage(image_file, smallest_box_side, min_box_side, cv::Size());
+}
+
+bool ImageShardWriter::AddImage(const string& image_file, const double smallest_box_side,
+                                const double min_box_side, const cv::Size& annotation_size) {
+  // Read the encoded image.
+  std::ifstream input(image_file.c_str(), std::ios::binary);
+  if (!input) {
+    printf("Error - could not read %s\n", image_file.c_str());
+    return false;
+  }
+  vector<uchar> data((std::istreambuf_iterator<char>(input)),
+                     std::istreambuf_iterator<char>());
+
+  double scale = 1;
+  const bool fit_boxes = smallest_box_side > 0 && min_box_side > 0;
+  if (max_side_ > 0 || fit_boxes) {
+    const cv::Mat image = cv::imdecode(data, cv::IMREAD_COLOR);
+    if (!image.data) {
+      printf("Error - could not decode %s\n", image_file.c_str());
+      return false;
+    }
+
+    // Downscale (and re-encode) only the images that are too large.
+    const int long_side = std::max(image.cols, image.rows);
+    double max_scale = 1;
+    if (max_side_ > 0) {
+      max_scale = std::min(max_scale, static_cast<double>(max_side_) / long_side);
+    }
+    if (fit_boxes) {
+      // Measure the box in pixels of the image file.
+      const double annotation_factor = annotation_size.width > 0 ?
+          static_cast<double>(image.cols) / annotation_size.width : 1;
+      max_scale = std::min(max_scale,
+                           min_box_side / (smallest_box_side * annotation_factor));
+    }
+
+    if (max_scale < 1) {
+      cv::Mat image_resized;
+      cv::resize(image, image_resized, cv::Size(), max_scale, max_scale, cv::INTER_AREA);
+
+      // Use the exact scale of the resized image.
+      scale = static_cast<double>(image_resized.cols) / image.cols;
+
+      vector<int> params;
+      params.push_back(cv::IMWRITE_JPEG_QUALITY);
+      params.push_back(kJpegQuality);
+      cv::imencode(".jpg", image_resized, data, params);
+    }
+  }
+
+  return Append(image_file, data, scale);
+}
+
+bool ImageShardWriter::Append(const string& image_file, const vector<uchar>& data,
+                              const double scale) {
+  if (write_failed_) {
+    return false;
+  }
+
+  // Start a new shard when the current one is full.
+  if (shard_file_ && shard_bytes_ + data.size() > max_shard_bytes_ && shard_bytes_ > 0) {
+    const bool closed = fclose(shard_file_) == 0;
+    shard_file_ = NULL;
+    if (!closed) {
+      printf("Error - could not write %s\n", ShardPath(prefix_, shard_num_).c_str());
+      write_failed_ = true;
+      return false;
+    }
+    shard_num_++;
+    shard_bytes_ = 0;
+  }
+
+  if (!shard_file_) {
+    const string& shard_path = ShardPath(prefix_, shard_num_);
+    shard_file_ = fopen(shard_path.c_str(), "wb");
+    if (!shard_file_) {
+      printf("Error - could not open %s\n", shard_path.c_str());
+      write_failed_ = true;
+      return false;
+    }
+  }
+
+  if (fwrite(&data[0], 1, data.size(), shard_file_) != data.size()) {
+    printf("Error - could not write %s\n", ShardPath(prefix_, shard_num_).c_str());
+    write_failed_ = true;
+    return false;
+  }
+
+  ImageShardEntry entry;
+  entry.shard_num = shard_num_;
+  entry.offset = shard_bytes_;
+  entry.num_bytes = data.size();
+  entry.scale = scale;
+  entries_.push_back(std::make_pair(image_file, entry));
+
+  shard_bytes_ += data.size();
+  return true;
+}
+
+bool ImageShardWriter::Finish() {
+  if (shard_file_) {
+    if (fclose(shard_file_) != 0) {
+      printf("Error - could not write %s\n", ShardPath(prefix_, shard_num_).c_str());
+      write_failed_ = true;
+    }
+    shard_file_ = NULL;
+  }
+  if (write_failed_) {
+    return false;
+  }
+
+  const string& index_path = IndexPath(prefix_);
+  FILE* index_file = fopen(index_path.c_str(), "wb");
+  if (!index_file) {
+    printf("Error - could not open %s\n", index_path.c_str());
+    return false;
+  }
+
+  // Index format: magic, number of shards, number of images, then for each image:
+  // path length, path, shard number, offset, size, scale.
+  const uint32_t num_shards = entries_.empty() ? 0 : shard_num_ + 1;
+  const uint64_t num_images = entries_.size();
+  bool written = fwrite(&kIndexMagic, sizeof(kIndexMagic), 1, index_file) == 1 &&
+                 fwrite(&num_shards, sizeof(num_shards), 1, index_file) == 1 &&
+                 fwrite(&num_images, sizeof(num_images), 1, index_file) == 1;
+  for (size_t i = 0; written && i < entries_.size(); ++i) {
+    const string& image_file = entries_[i].first;
+    const ImageShardEntry& entry = entries_[i].second;
+    const uint32_t path_length = image_file.size();
+    written = fwrite(&path_length, sizeof(path_length), 1, index_file) == 1 &&
+              fwrite(image_file.data(), 1, path_length, index_file) == path_length &&
+              fwrite(&entry.shard_num, sizeof(entry.shard_num), 1, index_file) == 1 &&
+              fwrite(&entry.offset, sizeof(entry.offset), 1, index_file) == 1 &&
+              fwrite(&entry.num_bytes, sizeof(entry.num_bytes), 1, index_file) == 1 &&
+              fwrite(&entry.scale, sizeof(entry.scale), 1, index_file) == 1;
+  }
+  written = fclose(index_file) == 0 && written;
+  if (!written) {
+    printf("Error - could not write %s\n", index_path.c_str());
+    return false;
+  }
+
+  printf("Packed %zu images into %u shards\n", entries_.size(), num_shards);
+  return true;
+}
+
+ImageShards::ImageShards(const string& prefix) {
+  const string& index_path = IndexPath(prefix);
+  FILE* index_file = fopen(index_path.c_str(), "rb");
+  if (!index_file) {
+    printf("Error - could not open %s\n", index_path.c_str());
+    return;
+  }
+
+  uint32_t magic = 0;
+  uint32_t num_shards = 0;
+  uint64_t num_images = 0;
+  if (fread(&magic, sizeof(magic), 1, index_file) != 1 || magic != kIndexMagic ||
+      fread(&num_shards, sizeof(num_shards), 1, index_file) != 1 ||
+      fread(&num_images, sizeof(num_images), 1, index_file) != 1) {
+    printf("Error - %s is not a valid shard index\n", index_path.c_str());
+    fclose(index_file);
+    return;
+  }
+
+  index_.reserve(num_images);
+  for (uint64_t i = 0; i < num_images; ++i) {
+    uint32_t path_length = 0;
+    if (fread(&path_length, sizeof(path_length), 1, index_file) != 1) {
+      printf("Error - %s is truncated\n", index_path.c_str());
+      break;
+    }
+    string image_file(path_length, '\0');
+    ImageShardEntry entry;
+    if (fread(&image_file[0], 1, path_length, index_file) != path_length ||
+        fread(&entry.shard_num, sizeof(entry.shard_num), 1, index_file) != 1 ||
+        fread(&entry.offset, sizeof(entry.offset), 1, index_file) != 1 ||
+        fread(&entry.num_bytes, sizeof(entry.num_bytes), 1, index_file) != 1 ||
+        fread(&entry.scale, sizeof(entry.scale), 1, index_file) != 1) {
+      printf("Error - %s is truncated\n", index_path.c_str());
+      break;
+    }
+    index_[image_file] = entry;
+  }
+  fclose(index_file);
+
+  // Map the shards into memory; the pages are read from disk on first access.
+  shards_.resize(num_shards);
+  for (uint32_t shard_num = 0; shard_num < num_shards; ++shard_num) {
+    MappedShard& shard = shards_[shard_num];
+    shard.data = NULL;
+    shard.num_bytes = 0;
+
+    const string& shard_path = ShardPath(prefix, shard_num);
+    const int fd = open(shard_path.c_str(), O_RDONLY);
+    struct stat shard_stat;
+    if (fd < 0 || fstat(fd, &shard_stat) != 0) {
+      printf("Error - could not open %s\n", shard_path.c_str());
+      if (fd >= 0) {
+        close(fd);
+      }
+      continue;
+    }
+
+    if (shard_stat.st_size > 0) {
+      void* data = mmap(NULL, shard_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (data == MAP_FAILED) {
+        printf("Error - could not map %s\n", shard_path.c_str());
+      } else {
+        shard.data = static_cast<const uchar*>(data);
+        shard.num_bytes = shard_stat.st_size;
+      }
+    }
+
+    // The mapping stays valid after closing the file.
+    close(fd);
+  }
+
+  printf("Loaded %zu images from %u shards\n", index_.size(), num_shards);
+}
+
+ImageShards::~ImageShards() {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    if (shards_[i].data) {
+      munmap(const_cast<uchar*>(shards_[i].data), shards_[i].num_bytes);
+    }
+  }
+}
+
+bool ImageShards::LoadImage(const string& image_file, cv::Mat* image, double* scale) const {
+  std::unordered_map<string, ImageShardEntry>::const_iterator it = index_.find(image_file);
+  if (it == index_.end()) {
+    return false;
+  }
+
+  const ImageShardEntry& entry = it->second;
+  if (entry.shard_num >= shards_.size()) {
+    return false;
+  }
+  const MappedShard& shard = shards_[entry.shard_num];
+  if (!shard.data || entry.offset + entry.num_bytes > shard.num_bytes) {
+    return false;
+  }
+
+  // Decode directly from the mapped memory (without copying it).
+  PROFILE_ZONE("DecodeShardImage");
+  const cv::Mat encoded(1, entry.num_bytes, CV_8UC1,
+                        const_cast<uchar*>(shard.data + entry.offset));
+  *image = cv::imdecode(encoded, cv::IMREAD_COLOR);
+  CountDecodedImage(image->total() * image->elemSize());
+  *scale = entry.scale;
+  return image->data != NULL;
+}
+
+bool ImageShards::GetScale(const string& image_file, double* scale) const {
+  std::unordered_map<string, ImageShardEntry>::const_iterator it = index_.find(image_file);
+  if (it == index_.end()) {
+    return false;
+  }
+  *scale = it->second.scale;
+  return true;
+}
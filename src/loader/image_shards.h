@@ -0,0 +1,116 @@
+#ifndef IMAGE_SHARDS_H
+#define IMAGE_SHARDS_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+// Packed image storage for training: many encoded images are concatenated into
+// a few large shard files (prefix-00000.shard, prefix-00001.shard, ...) with an
+// index (prefix.index) mapping each image path to its location.  Reading from
+// the memory-mapped shards replaces millions of small file opens and random
+// seeks with reads from a few large files that stay in the page cache.
+//
+// Images are keyed by the path that the loaders would otherwise read them from.
+// Images may be downscaled when packed; each image keeps its scale factor
+// (packed size / original size) so that the annotations can be scaled to match.
+
+// Location of one image in the shards.
+struct ImageShardEntry {
+  uint32_t shard_num;
+  uint64_t offset;
+  uint64_t num_bytes;
+  double scale;
+};
+
+// Writes images into shard files and saves the index.
+class ImageShardWriter
+{
+public:
+  // Start a new set of shards with the given prefix, starting a new shard
+  // file every max_shard_bytes bytes.
+  // If max_side > 0, downscale the images so that their longer side is at most max_side.
+  ImageShardWriter(const std::string& prefix, const size_t max_shard_bytes,
+                   const int max_side);
+
+  ~ImageShardWriter();
+
+  // Add the image file, keyed by its path.
+  // Images that do not need to be downscaled are copied without re-encoding.
+  // Returns false if the image could not be read or written.
+  bool AddImage(const std::string& image_file);
+
+  // As above, but also downscale the image as far as its annotations allow: until
+  // the shorter side of its smallest box, smallest_box_side, is min_box_side pixels.
+  // (The boxes are cropped with context to the network resolution, so
+  // min_box_side = resolution / context factor keeps all the detail the network sees.)
+  // smallest_box_side is measured on an image of annotation_size (use an empty size
+  // if it is in pixels of the image file).
+  bool AddImage(const std::string& image_file, const double smallest_box_side,
+                const double min_box_side, const cv::Size& annotation_size);
+
+  // Write the index and close the shards.
+  // Returns false if any shard or the index could not be written completely.
+  bool Finish();
+
+  size_t get_num_images() const { return entries_.size(); }
+
+private:
+  // Append data to the current shard, starting a new shard if it is full.
+  // Returns false if it could not be written.
+  bool Append(const std::string& image_file, const std::vector<uchar>& data,
+              const double scale);
+
+  std::string prefix_;
+  size_t max_shard_bytes_;
+  int max_side_;
+
+  // Current shard file and the number of bytes written to it.
+  FILE* shard_file_;
+  uint32_t shard_num_;
+  uint64_t shard_bytes_;
+
+  // Whether a write has failed; no more images are written after that, since the
+  // offsets in the shard are no longer known.
+  bool write_failed_;
+
+  // Index of all images added so far.
+  std::vector<std::pair<std::string, ImageShardEntry> > entries_;
+};
+
+// Reads images from memory-mapped shards.  Thread-safe (all reads are const).
+class ImageShards
+{
+public:
+  // Map the shards with the given prefix.
+  ImageShards(const std::string& prefix);
+
+  ~ImageShards();
+
+  // Decode the image for the given path.  Returns false if it is not in the shards.
+  // scale is set to the ratio of the packed image size to the original image size.
+  bool LoadImage(const std::string& image_file, cv::Mat* image, double* scale) const;
+
+  // Get the scale of the packed image for the given path, without decoding it.
+  // Returns false if it is not in the shards.
+  bool GetScale(const std::string& image_file, double* scale) const;
+
+  size_t get_num_images() const { return index_.size(); }
+
+private:
+  // Memory-mapped shard files.
+  struct MappedShard {
+    const uchar* data;
+    size_t num_bytes;
+  };
+  std::vector<MappedShard> shards_;
+
+  // Location of each image, keyed by path.
+  std::unordered_map<std::string, ImageShardEntry> index_;
+};
+
+#endif // IMAGE_SHARDS_H
@@ -5,6 +5,7 @@
 #include <opencv2/highgui/highgui.hpp>
 
 #include "helper/helper.h"
+#include "loader/video_file_reader.h"
 
 using std::string;
 using std::vector;
@@ -19,6 +20,65 @@ const bool kDoTest = false;
 // to train the final model on the training set + validation set (not the test set!)
 const double val_ratio = 0.2;
 
+namespace {
+
+// Read the annotations for one video, and find its image files.
+void LoadVideo(const string& video_folder, const string& annotations_folder,
+               const string& category_name, const string& annotation_file,
+               Video* video) {
+  //printf("Processing annotation file: %s\n", annotation_file.c_str());
+
+  // Get the path to the video image files.
+  const string video_path = video_folder + "/" + category_name + "/" +
+      annotation_file.substr(0, annotation_file.length() - 4);
+  video->path = video_path;
+  //printf("Video path: %s\n", video_path.c_str());
+
+  // Add all image files (or read the frames from a video file in their place).
+  string video_file;
+  if (FindVideoFile(video_path, &video_file)) {
+    video->set_video_file(video_file);
+  } else {
+    vector<string> image_files;
+    find_files_with_extension(video_path, ".jpg", &image_files);
+    video->all_frames = FrameList(image_files);
+  }
+
+  // Open the annotation file.
+  const string& annotation_file_path = annotations_folder + "/" + category_name + "/" + annotation_file;
+  FILE* annotation_file_ptr = fopen(annotation_file_path.c_str(), "r");
+  int frame_num;
+  double Ax, Ay, Bx, By, Cx, Cy, Dx, Dy;
+  vector<Frame> frames;
+
+  while (true) {
+    // Read a line from the annotation file.
+    const int status = fscanf(annotation_file_ptr, "%d %lf %lf %lf %lf %lf %lf %lf %lf\n",
+                 &frame_num, &Ax, &Ay, &Bx, &By, &Cx, &Cy, &Dx, &Dy);
+    if (status == EOF) {
+      break;
+    }
+
+    // Convert the annotation data into frame and bounding box format.
+    Frame frame;
+    frame.frame_num = frame_num - 1; // Convert to 0-index
+    BoundingBox& bbox = frame.bbox;
+    bbox.x1_ = std::min(Ax, std::min(Bx, std::min(Cx, Dx))) - 1;
+    bbox.y1_ = std::min(Ay, std::min(By, std::min(Cy, Dy))) - 1;
+    bbox.x2_ = std::max(Ax, std::max(Bx, std::max(Cx, Dx))) - 1;
+    bbox.y2_ = std::max(Ay, std::max(By, std::max(Cy, Dy))) - 1;
+
+    // Save the annotation data.
+    frames.push_back(frame);
+  } // Process annotation file
+
+  fclose(annotation_file_ptr);
+
+  video->annotations = FrameAnnotations(frames);
+}
+
+} // namespace
+
 LoaderAlov::LoaderAlov(const string& video_folder, const string& annotations_folder)
 {
   if (!bfs::is_directory(annotations_folder)) {
@@ -31,78 +91,43 @@ LoaderAlov::LoaderAlov(const string& video_folder, const string& annotations_fol
   find_subfolders(annotations_folder, &categories);
 
   const int max_categories = kDoTest ? 3 : categories.size();
+  categories.resize(std::min(categories.size(), static_cast<size_t>(max_categories)));
 
   //printf("Found %zu categories...\n", categories.size());
-  for (size_t i = 0; i < max_categories; ++i) {
-    Category category;
 
-    const string& category_name = categories[i];
-    const string& category_path = annotations_folder + "/" + category_name;
-
-    //printf("Loading category: %s\n", category_name.c_str());
-
-    // Find the annotation files.
-    const boost::regex annotation_filter(".*\\.ann");
-    vector<string> annotation_files;
-    find_matching_files(category_path, annotation_filter, &annotation_files);
-
-    //printf("Found %zu annotations\n", annotation_files.size());
-
-    // Iterate over all annotation files (one annotation file per video).
-    for (size_t j = 0; j < annotation_files.size(); ++j) {
-      const string& annotation_file = annotation_files[j];
-
-      //printf("Processing annotation file: %s\n", annotation_file.c_str());
-
-      // Read annotations for a given video.
-      Video video;
-
-      // Get the path to the video image files.
-      const string video_path = video_folder + "/" + category_name + "/" +
-          annotation_file.substr(0, annotation_file.length() - 4);
-      video.path = video_path;
-      //printf("Video path: %s\n", video_path.c_str());
-
-      // Add all image files
-      const boost::regex image_filter(".*\\.jpg");
-      find_matching_files(video_path, image_filter, &video.all_frames);
-
-      // Open the annotation file.
-      const string& annotation_file_path = category_path + "/" + annotation_file;
-      FILE* annotation_file_ptr = fopen(annotation_file_path.c_str(), "r");
-      int frame_num;
-      double Ax, Ay, Bx, By, Cx, Cy, Dx, Dy;
-
-      while (true) {
-        // Read a line from the annotation file.
-        const int status = fscanf(annotation_file_ptr, "%d %lf %lf %lf %lf %lf %lf %lf %lf\n",
-                     &frame_num, &Ax, &Ay, &Bx, &By, &Cx, &Cy, &Dx, &Dy);
-        if (status == EOF) {
-          break;
-        }
-
-        // Convert the annotation data into frame and bounding box format.
-        Frame frame;
-        frame.frame_num = frame_num - 1; // Convert to 0-index
-        BoundingBox& bbox = frame.bbox;
-        bbox.x1_ = std::min(Ax, std::min(Bx, std::min(Cx, Dx))) - 1;
-        bbox.y1_ = std::min(Ay, std::min(By, std::min(Cy, Dy))) - 1;
-        bbox.x2_ = std::max(Ax, std::max(Bx, std::max(Cx, Dx))) - 1;
-        bbox.y2_ = std::max(Ay, std::max(By, std::max(Cy, Dy))) - 1;
-
-        // Save the annotation data.
-        video.annotations.push_back(frame);
-      } // Process annotation file
-
-      // Save the video.
-      fclose(annotation_file_ptr);
-      videos_.push_back(video);
-      category.videos.push_back(video);
-    } // Process all annotation files in category
-
-    // Save the video category.
+  // Find the annotation files (one per video) of all categories, scanning them in parallel.
+  vector<vector<string> > annotation_files(categories.size());
+  parallel_for(categories.size(), kNumScanThreads, [&](const size_t i) {
+    find_files_with_extension(annotations_folder + "/" + categories[i], ".ann",
+                              &annotation_files[i]);
+  });
+
+  // Load all of the videos in parallel, into slots in the same (sorted) order
+  // as the categories and annotation files, so that the videos (and therefore
+  // the train / validation split) do not depend on the number of threads.
+  vector<vector<Video> > category_videos(categories.size());
+  vector<std::pair<size_t, size_t> > video_indices;
+  for (size_t i = 0; i < categories.size(); ++i) {
+    category_videos[i].resize(annotation_files[i].size());
+    for (size_t j = 0; j < annotation_files[i].size(); ++j) {
+      video_indices.push_back(std::make_pair(i, j));
+    }
+  }
+  parallel_for(video_indices.size(), kNumScanThreads, [&](const size_t k) {
+    const size_t i = video_indices[k].first;
+    const size_t j = video_indices[k].second;
+    LoadVideo(video_folder, annotations_folder, categories[i], annotation_files[i][j],
+              &category_videos[i][j]);
+  });
+
+  // Save the videos; each category refers to its range of the videos.
+  for (size_t i = 0; i < categories.size(); ++i) {
+    Category category;
+    category.first_video = videos_.size();
+    category.num_videos = category_videos[i].size();
+    videos_.insert(videos_.end(), category_videos[i].begin(), category_videos[i].end());
     categories_.push_back(category);
-  } // Process all categories
+  }
 }
 
 void LoaderAlov::get_videos(const bool get_train, std::vector<Video>* videos) const {
@@ -110,7 +135,7 @@ void LoaderAlov::get_videos(const bool get_train, std::vector<Video>* videos) co
     const Category& category = categories_[category_num];
 
     // Number of videos in this category.
-    size_t num_videos = category.videos.size();
+    size_t num_videos = category.num_videos;
 
     // Number of videos from this category to use in the validation set (the rest go into the training set).
     const int num_val = static_cast<int>(val_ratio * num_videos);
@@ -131,10 +156,9 @@ void LoaderAlov::get_videos(const bool get_train, std::vector<Video>* videos) co
     }
 
     // Add the appropriate videos from this category to the list of videos
-    // to return.
-    const std::vector<Video>& category_videos = category.videos;
+    // to return (copying a video only copies references to its frames and annotations).
     for (size_t i = start_num; i <= end_num; ++i) {
-      const Video& video = category_videos[i];
+      const Video& video = videos_[category.first_video + i];
       videos->push_back(video);
     }
   }
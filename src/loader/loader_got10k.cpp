@@ -0,0 +1,53 @@
+#include "loader_got10k.h"
+
+#include <fstream>
+
+#include "helper/helper.h"
+
+using std::string;
+using std::vector;
+namespace bfs = boost::filesystem;
+
+LoaderGot10k::LoaderGot10k(const string& split_folder)
+  : LoaderGot10k(split_folder, bfs::temp_directory_path().string())
+{
+}
+
+LoaderGot10k::LoaderGot10k(const string& split_folder, const string& cache_folder)
+{
+  if (!bfs::is_directory(split_folder)) {
+    printf("Error - %s is not a valid directory!\n", split_folder.c_str());
+    return;
+  }
+
+  // The split lists its sequences, which saves listing a folder with ~10k entries.
+  vector<string> names;
+  std::ifstream list_file((split_folder + "/list.txt").c_str());
+  string name;
+  while (std::getline(list_file, name)) {
+    if (!name.empty() && name[name.size() - 1] == '\r') {
+      name.erase(name.size() - 1);
+    }
+    if (!name.empty()) {
+      names.push_back(name);
+    }
+  }
+  if (names.empty()) {
+    find_subfolders(split_folder, &names);
+  }
+
+  vector<SequenceInfo> sequences(names.size());
+  for (size_t i = 0; i < names.size(); ++i) {
+    SequenceInfo& sequence = sequences[i];
+    sequence.name = names[i];
+    sequence.path = split_folder + "/" + names[i];
+    sequence.groundtruth_file = sequence.path + "/groundtruth.txt";
+    sequence.one_based = false;
+    sequence.frame_prefix = "";
+    sequence.num_digits = 8;
+    sequence.frame_suffix = ".jpg";
+    sequence.first_number = 1;
+  }
+
+  LoadSequences("got10k", split_folder, cache_folder, sequences);
+}
@@ -0,0 +1,20 @@
+#ifndef LOADER_GOT10K_H
+#define LOADER_GOT10K_H
+
+#include "sequence_loader.h"
+
+// Loads videos from one split (train, val or test) of the GOT-10k tracking dataset
+// (<sequence>/00000001.jpg, with groundtruth.txt next to the frames).
+// For the test split only the first frame is annotated.
+class LoaderGot10k : public SequenceLoader
+{
+public:
+  // Finds the sequences listed in list.txt (or all subfolders if there is no list);
+  // the groundtruth cache is kept in the temporary directory.
+  LoaderGot10k(const std::string& split_folder);
+
+  // As above, but keep the groundtruth cache in cache_folder.
+  LoaderGot10k(const std::string& split_folder, const std::string& cache_folder);
+};
+
+#endif // LOADER_GOT10K_H
@@ -1,8 +1,19 @@
 #include <tinyxml.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <map>
 
 #include "train/example_generator.h"
 #include "loader/loader_imagenet_det.h"
 #include "helper/helper.h"
+#include "helper/metrics.h"
+#include "helper/rng.h"
+#include "loader/image_cache.h"
+#include "loader/image_shards.h"
 
 using std::vector;
 using std::string;
@@ -17,10 +28,264 @@ const bool kDoTest = false;
 // then we will not be able to simulate object motion.
 const double kMaxRatio = 0.66;
 
+// Fixed seed for the random examples shown by the visualizations,
+// so that the same examples are shown on every run.
+const int kShowRandomSeed = 0;
+
+namespace {
+
+// Identifies an annotation index file (and its version).
+const uint32_t kIndexMagic = 0x47444931;  // "GDI1"
+
+// Modification time and number of entries of an annotation subfolder, to tell
+// whether a saved annotation index is still up to date.
+// (Adding, removing or renaming files changes both; annotation files that are
+// edited in place are not detected.)
+struct FolderStamp {
+  string name;
+  int64_t mtime;
+  uint64_t num_entries;
+};
+
+void GetFolderStamps(const string& annotations_folder, const vector<string>& subfolders,
+                     vector<FolderStamp>* stamps) {
+  stamps->resize(subfolders.size());
+  parallel_for(subfolders.size(), kNumScanThreads, [&](const size_t i) {
+    const bfs::path subfolder_path = bfs::path(annotations_folder) / subfolders[i];
+    FolderStamp& stamp = (*stamps)[i];
+    stamp.name = subfolders[i];
+    stamp.mtime = bfs::last_write_time(subfolder_path);
+    stamp.num_entries = std::distance(bfs::directory_iterator(subfolder_path),
+                                      bfs::directory_iterator());
+  });
+}
+
+// The index file for an annotation folder is named after a hash of its absolute path.
+string GetIndexFile(const string& index_folder, const string& annotations_folder) {
+  const string folder = bfs::absolute(annotations_folder).string();
+  char index_name[64];
+  sprintf(index_name, "imagenet_det_%016zx.index", std::hash<string>()(folder));
+  return (bfs::path(index_folder) / index_name).string();
+}
+
+template <typename T>
+void WriteValue(const T& value, FILE* file) {
+  fwrite(&value, sizeof(value), 1, file);
+}
+
+template <typename T>
+bool ReadValue(FILE* file, T* value) {
+  return fread(value, sizeof(*value), 1, file) == 1;
+}
+
+void WriteString(const string& value, FILE* file) {
+  WriteValue(static_cast<uint32_t>(value.size()), file);
+  fwrite(value.data(), 1, value.size(), file);
+}
+
+// Strings longer than max_length (e.g. the size of the file) are treated as corrupt.
+bool ReadString(FILE* file, const size_t max_length, string* value) {
+  uint32_t length;
+  if (!ReadValue(file, &length) || length > max_length) {
+    return false;
+  }
+  value->resize(length);
+  return length == 0 || fread(&(*value)[0], 1, length, file) == length;
+}
+
+// Index format: magic, kMaxRatio, annotation folder, the stamps of its subfolders,
+// a pool of the image folder names, and then for each image: the index of
+// its folder in the pool, its file name, and its annotations.
+void SaveIndex(const string& index_file, const string& annotations_folder,
+               const vector<FolderStamp>& stamps,
+               const vector<vector<Annotation> >& images) {
+  // Write to a temporary file first, so that a partly written index is never used.
+  // The file is named after the process, so that jobs started at the same time on the
+  // same annotations do not write into each other's file.
+  const string& temp_file = index_file + "." + std::to_string(getpid()) + ".tmp";
+  FILE* file = fopen(temp_file.c_str(), "wb");
+  if (!file) {
+    printf("Could not write annotation index %s\n", temp_file.c_str());
+    return;
+  }
+
+  WriteValue(kIndexMagic, file);
+  WriteValue(kMaxRatio, file);
+  WriteString(bfs::absolute(annotations_folder).string(), file);
+
+  WriteValue(static_cast<uint32_t>(stamps.size()), file);
+  for (size_t i = 0; i < stamps.size(); ++i) {
+    WriteString(stamps[i].name, file);
+    WriteValue(stamps[i].mtime, file);
+    WriteValue(stamps[i].num_entries, file);
+  }
+
+  // Pool the image folders, which are shared by many images.
+  vector<string> folders;
+  std::map<string, uint32_t> folder_ids;
+  vector<uint32_t> image_folder_ids(images.size());
+  for (size_t i = 0; i < images.size(); ++i) {
+    const string& image_path = images[i][0].image_path;
+    const string& folder = image_path.substr(0, image_path.rfind('/'));
+    std::map<string, uint32_t>::const_iterator it = folder_ids.find(folder);
+    if (it == folder_ids.end()) {
+      it = folder_ids.insert(std::make_pair(folder, folders.size())).first;
+      folders.push_back(folder);
+    }
+    image_folder_ids[i] = it->second;
+  }
+
+  WriteValue(static_cast<uint32_t>(folders.size()), file);
+  for (size_t i = 0; i < folders.size(); ++i) {
+    WriteString(folders[i], file);
+  }
+
+  WriteValue(static_cast<uint64_t>(images.size()), file);
+  for (size_t i = 0; i < images.size(); ++i) {
+    const vector<Annotation>& annotations = images[i];
+    const string& image_path = annotations[0].image_path;
+    WriteValue(image_folder_ids[i], file);
+    WriteString(image_path.substr(image_path.rfind('/') + 1), file);
+    WriteValue(static_cast<uint32_t>(annotations.size()), file);
+    for (size_t j = 0; j < annotations.size(); ++j) {
+      const Annotation& annotation = annotations[j];
+      WriteValue(annotation.bbox.x1_, file);
+      WriteValue(annotation.bbox.y1_, file);
+      WriteValue(annotation.bbox.x2_, file);
+      WriteValue(annotation.bbox.y2_, file);
+      WriteValue(static_cast<int32_t>(annotation.display_width_), file);
+      WriteValue(static_cast<int32_t>(annotation.display_height_), file);
+    }
+  }
+
+  const bool write_error = ferror(file);
+  fclose(file);
+  if (write_error || rename(temp_file.c_str(), index_file.c_str()) != 0) {
+    printf("Could not write annotation index %s\n", index_file.c_str());
+    remove(temp_file.c_str());
+    return;
+  }
+  printf("Saved annotation index to %s\n", index_file.c_str());
+}
+
+// Returns false if the index is missing, unreadable or out of date.
+bool LoadIndex(const string& index_file, const string& annotations_folder,
+               const vector<FolderStamp>& stamps,
+               vector<vector<Annotation> >* images) {
+  FILE* file = fopen(index_file.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  // The counts in the index are checked against the size of the file before anything
+  // is allocated for them, so that a truncated or corrupt index is rebuilt rather
+  // than running out of memory.
+  size_t file_size = 0;
+  if (fseek(file, 0, SEEK_END) == 0) {
+    const long end = ftell(file);
+    file_size = end > 0 ? end : 0;
+  }
+  rewind(file);
+
+  // Smallest size of an image (folder id, file name length, number of annotations),
+  // and size of an annotation (box and display size) in the index.
+  const size_t kMinImageBytes = 3 * sizeof(uint32_t);
+  const size_t kAnnotationBytes = 4 * sizeof(double) + 2 * sizeof(int32_t);
+
+  // Check that the index was made from the same annotations, with the same settings.
+  uint32_t magic;
+  double max_ratio;
+  string folder;
+  uint32_t num_stamps;
+  bool valid = ReadValue(file, &magic) && magic == kIndexMagic &&
+               ReadValue(file, &max_ratio) && max_ratio == kMaxRatio &&
+               ReadString(file, file_size, &folder) &&
+               folder == bfs::absolute(annotations_folder).string() &&
+               ReadValue(file, &num_stamps) && num_stamps == stamps.size();
+  for (size_t i = 0; valid && i < stamps.size(); ++i) {
+    FolderStamp stamp;
+    valid = ReadString(file, file_size, &stamp.name) && stamp.name == stamps[i].name &&
+            ReadValue(file, &stamp.mtime) && stamp.mtime == stamps[i].mtime &&
+            ReadValue(file, &stamp.num_entries) &&
+            stamp.num_entries == stamps[i].num_entries;
+  }
+
+  // Read the folder pool.
+  uint32_t num_folders = 0;
+  valid = valid && ReadValue(file, &num_folders) &&
+          num_folders <= file_size / sizeof(uint32_t);
+  vector<string> folders(valid ? num_folders : 0);
+  for (size_t i = 0; valid && i < folders.size(); ++i) {
+    valid = ReadString(file, file_size, &folders[i]);
+  }
+
+  // Read the annotations of each image.
+  uint64_t num_images = 0;
+  valid = valid && ReadValue(file, &num_images) && num_images <= file_size / kMinImageBytes;
+  vector<vector<Annotation> > loaded_images(valid ? num_images : 0);
+  for (size_t i = 0; valid && i < loaded_images.size(); ++i) {
+    uint32_t folder_id;
+    string filename;
+    uint32_t num_annotations;
+    valid = ReadValue(file, &folder_id) && folder_id < folders.size() &&
+            ReadString(file, file_size, &filename) &&
+            ReadValue(file, &num_annotations) &&
+            num_annotations <= file_size / kAnnotationBytes;
+    if (!valid) {
+      break;
+    }
+
+    const string& image_path = folders[folder_id] + "/" + filename;
+    vector<Annotation>& annotations = loaded_images[i];
+    annotations.resize(num_annotations);
+    for (size_t j = 0; valid && j < annotations.size(); ++j) {
+      Annotation& annotation = annotations[j];
+      int32_t display_width, display_height;
+      valid = ReadValue(file, &annotation.bbox.x1_) &&
+              ReadValue(file, &annotation.bbox.y1_) &&
+              ReadValue(file, &annotation.bbox.x2_) &&
+              ReadValue(file, &annotation.bbox.y2_) &&
+              ReadValue(file, &display_width) &&
+              ReadValue(file, &display_height);
+      annotation.image_path = image_path;
+      annotation.display_width_ = display_width;
+      annotation.display_height_ = display_height;
+    }
+  }
+  fclose(file);
+
+  if (!valid) {
+    printf("Annotation index %s is out of date\n", index_file.c_str());
+    return false;
+  }
+
+  images->swap(loaded_images);
+  return true;
+}
+
+} // namespace
+
 LoaderImagenetDet::LoaderImagenetDet(const std::string& image_folder,
                                      const std::string& annotations_folder)
-  : path_(image_folder)
+  : path_(image_folder),
+    image_shards_(NULL),
+    image_cache_(NULL)
+{
+  LoadAnnotations(annotations_folder, bfs::temp_directory_path().string());
+}
+
+LoaderImagenetDet::LoaderImagenetDet(const std::string& image_folder,
+                                     const std::string& annotations_folder,
+                                     const std::string& index_folder)
+  : path_(image_folder),
+    image_shards_(NULL),
+    image_cache_(NULL)
 {
+  LoadAnnotations(annotations_folder, index_folder);
+}
+
+void LoaderImagenetDet::LoadAnnotations(const std::string& annotations_folder,
+                                        const std::string& index_folder) {
   if (!bfs::is_directory(annotations_folder)) {
     printf("Error - %s is not a valid directory!\n", annotations_folder.c_str());
     return;
@@ -35,54 +300,72 @@ LoaderImagenetDet::LoaderImagenetDet(const std::string& image_folder,
   const int max_subfolders = kDoTest ? 1 : subfolders.size();
 
   printf("Found %zu subfolders...\n", subfolders.size());
-  printf("Loading images, please wait...\n");
-
-  // Iterate over all subfolders.
-  for (size_t i = 0; i < max_subfolders; ++i) {
-    // Every 100 iterations, print an update.
-    if (i % 10 == 0 && i > 0) {
-      printf("Loaded %zu subfolders\n", i);
+  subfolders.resize(std::min(subfolders.size(), static_cast<size_t>(max_subfolders)));
+
+  // Use the saved annotations if none of the subfolders have changed.
+  vector<FolderStamp> stamps;
+  GetFolderStamps(annotations_folder, subfolders, &stamps);
+  const string& index_file = GetIndexFile(index_folder, annotations_folder);
+  if (LoadIndex(index_file, annotations_folder, stamps, &images_)) {
+    for (size_t i = 0; i < images_.size(); ++i) {
+      num_annotations += images_[i].size();
     }
-    const string& subfolder_name = subfolders[i];
-    const string& subfolder_path = annotations_folder + "/" + subfolder_name;
-
-    //printf("Loading subfolder: %s\n", subfolder_name.c_str());
-
-    // Find the annotation files.
-    const boost::regex annotation_filter(".*\\.xml");
-    vector<string> annotation_files;
-    find_matching_files(subfolder_path, annotation_filter, &annotation_files);
+    printf("Loaded %zu annotations from %zu images from %s\n", num_annotations,
+           images_.size(), index_file.c_str());
+    return;
+  }
 
-    //printf("Found %zu annotations\n", annotation_files.size());
+  printf("Loading images, please wait...\n");
 
-    // Iterate over all annotation files.
-    for (size_t j = 0; j < annotation_files.size(); ++j) {
-      const string& annotation_file = annotation_files[j];
+  // Find the annotation files of all subfolders, scanning them in parallel.
+  vector<vector<string> > annotation_files(subfolders.size());
+  parallel_for(subfolders.size(), kNumScanThreads, [&](const size_t i) {
+    find_files_with_extension(annotations_folder + "/" + subfolders[i], ".xml",
+                              &annotation_files[i]);
+  });
+
+  // List the annotation files in order (sorted by subfolder, then by file name).
+  vector<string> annotation_paths;
+  for (size_t i = 0; i < subfolders.size(); ++i) {
+    const string& subfolder_path = annotations_folder + "/" + subfolders[i];
+    for (size_t j = 0; j < annotation_files[i].size(); ++j) {
+      annotation_paths.push_back(subfolder_path + "/" + annotation_files[i][j]);
+    }
+  }
 
-      const string& full_path = subfolder_path + "/" + annotation_file;
+  // Read the annotations, parsing the files in parallel.
+  vector<vector<Annotation> > file_annotations(annotation_paths.size());
+  std::atomic<size_t> num_files_loaded(0);
+  parallel_for(annotation_paths.size(), kNumScanThreads, [&](const size_t i) {
+    LoadAnnotationFile(annotation_paths[i], &file_annotations[i]);
 
-      // Read the annotations.
-      //printf("Processing annotation file: %s\n", full_path.c_str());
-      vector<Annotation> annotations;
-      LoadAnnotationFile(full_path, &annotations);
+    // Every 10000 files, print an update.
+    const size_t num_loaded = ++num_files_loaded;
+    if (num_loaded % 10000 == 0) {
+      printf("Loaded %zu of %zu annotation files\n", num_loaded, annotation_paths.size());
+    }
+  });
 
-      if (annotations.size() == 0) {
-        continue;
-      }
+  // Save the annotations, in the same order as the files.
+  for (size_t i = 0; i < file_annotations.size(); ++i) {
+    if (file_annotations[i].size() == 0) {
+      continue;
+    }
 
-      // Count the number of annotations.
-      //printf("Found %zu annotations\n", annotations.size());
-      num_annotations += annotations.size();
+    // Count the number of annotations.
+    num_annotations += file_annotations[i].size();
 
-      // Save the annotations.
-      images_.push_back(annotations);
-    } // Process all annotations in a subfolder.
-  } // Process all subfolders.
+    images_.push_back(vector<Annotation>());
+    images_.back().swap(file_annotations[i]);
+  }
   printf("Found %zu annotations from %zu images\n", num_annotations, images_.size());
+
+  // Save the annotations, to load them faster next time.
+  SaveIndex(index_file, annotations_folder, stamps, images_);
 }
 
 void LoaderImagenetDet::LoadAnnotationFile(const string& annotation_file,
-                                           vector<Annotation>* image_annotations) {
+                                           vector<Annotation>* image_annotations) const {
   // Open the annotation file.
   TiXmlDocument document(annotation_file.c_str());
   document.LoadFile();
@@ -293,13 +576,32 @@ void LoaderImagenetDet::LoadImage(const size_t image_num,
   const Annotation& annotation = annotations[annotation_num];
 
   // Load the specified image (using the file-path contained within the annotation).
-  const string& image_file = path_ + "/" + annotation.image_path + ".JPEG";
-  *image = cv::imread(image_file.c_str());
+  double scale;
+  LoadImageFile(annotation, image, &scale);
+}
+
+string LoaderImagenetDet::get_image_file(const Annotation& annotation) const {
+  return path_ + "/" + annotation.image_path + ".JPEG";
+}
+
+void LoaderImagenetDet::LoadImageFile(const Annotation& annotation,
+                                      cv::Mat* image, double* scale) const {
+  const string& image_file = get_image_file(annotation);
+  *scale = 1;
+  if (image_shards_ && image_shards_->LoadImage(image_file, image, scale)) {
+    return;
+  }
+
+  if (image_cache_) {
+    image_cache_->LoadImage(image_file, image, scale);
+  } else {
+    *image = cv::imread(image_file.c_str());
+    CountDecodedImage(image->total() * image->elemSize());
+  }
 
   // Check that we were able to load the image.
   if (!image->data) {
     printf("Could not open or find image %s\n", image_file.c_str());
-    return;
   }
 }
 
@@ -312,12 +614,9 @@ void LoaderImagenetDet::LoadAnnotation(const size_t image_num,
   const Annotation& annotation = annotations[annotation_num];
 
   // Load the specified image.
-  const string& image_file = path_ + "/" + annotation.image_path + ".JPEG";
-  *image = cv::imread(image_file.c_str());
-
-  // Check that we were able to load the image.
+  double scale;
+  LoadImageFile(annotation, image, &scale);
   if (!image->data) {
-    printf("Could not open or find image %s\n", image_file.c_str());
     return;
   }
 
@@ -325,15 +624,19 @@ void LoaderImagenetDet::LoadAnnotation(const size_t image_num,
   // downsampled for visualization).  Usually this value will be 1.
   double factor = 1;
   if (image->rows != annotation.display_height_ || image->cols != annotation.display_width_) {
-    printf("Image: %zu %zu %s\n", image_num, annotation_num, image_file.c_str());
-    printf("Image size: %d %d\n", image->rows, image->cols);
-    printf("Display size: %d %d\n", annotation.display_height_,
-           annotation.display_width_);
-
     // Check that the aspect ratio was preserved for annotation.
     factor = static_cast<double>(image->rows) / static_cast<double>(annotation.display_height_);
     const double factor2 = static_cast<double>(image->cols) / static_cast<double>(annotation.display_width_);
-    printf("Factor: %lf %lf\n", factor, factor2);
+
+    // Images that were downscaled when packed into shards are expected to differ.
+    if (scale == 1) {
+      const string& image_file = get_image_file(annotation);
+      printf("Image: %zu %zu %s\n", image_num, annotation_num, image_file.c_str());
+      printf("Image size: %d %d\n", image->rows, image->cols);
+      printf("Display size: %d %d\n", annotation.display_height_,
+             annotation.display_width_);
+      printf("Factor: %lf %lf\n", factor, factor2);
+    }
   }
 
   // Scale the bounding box by the ratio of the the image size to the display size.
@@ -345,15 +648,16 @@ void LoaderImagenetDet::LoadAnnotation(const size_t image_num,
 }
 
 void LoaderImagenetDet::ShowAnnotationsRand() const {
+  Rng rng(kShowRandomSeed);
   while (true) {
     // Choose a random image.
-    const int image_num = rand() % images_.size();
+    const int image_num = rng.UniformInt(images_.size());
 
     // Get the annotations for this image.
     const std::vector<Annotation>& annotations = images_[image_num];
 
     // Choose a random annotation.
-    const int annotation_num = rand() % annotations.size();
+    const int annotation_num = rng.UniformInt(annotations.size());
 
     // Load the image and annotation.
     cv::Mat image;
@@ -377,6 +681,7 @@ void LoaderImagenetDet::ShowAnnotationsShift() const {
   // This will be used to artificially shift the crops around the annotations, creating an
   // apparent motion (via translation and scale change).
   ExampleGenerator example_generator(5, 5, -0.4, 0.4);
+  Rng rng(kShowRandomSeed);
 
   const bool save_images = false;
 
@@ -419,7 +724,7 @@ void LoaderImagenetDet::ShowAnnotationsShift() const {
       const bool visualize = true;
       const int kNumShifts = 1;
       for (int k = 0; k < kNumShifts; ++k) {
-        example_generator.MakeTrainingExampleBBShift(visualize, &image_rand_focus,
+        example_generator.MakeTrainingExampleBBShift(visualize, &rng, &image_rand_focus,
                                                      &target_pad, &bbox_gt_scaled);
       }
     }
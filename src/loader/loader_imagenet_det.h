@@ -3,6 +3,9 @@
 
 #include "helper/bounding_box.h"
 
+class ImageCache;
+class ImageShards;
+
 // An image annotation.
 struct Annotation {
   // Relative path of the image files (must be appended to path).
@@ -21,9 +24,17 @@ class LoaderImagenetDet
 {
 public:
   // Load all annotations.
+  // Parsing all of the annotation files is slow, so the annotations are saved to a
+  // binary index in the temporary directory, and later runs load them from there
+  // unless the annotation folders have changed since (see index_folder below).
   LoaderImagenetDet(const std::string& image_folder,
                     const std::string& annotations_folder);
 
+  // As above, but keep the annotation index in index_folder.
+  LoaderImagenetDet(const std::string& image_folder,
+                    const std::string& annotations_folder,
+                    const std::string& index_folder);
+
   // Load the specified image.
   void LoadImage(const size_t image_num, cv::Mat* image) const;
 
@@ -53,16 +64,42 @@ public:
     return images_;
   }
 
+  // Load the images from packed shards when they are there (see loader/image_shards.h).
+  void set_image_shards(const ImageShards* image_shards) { image_shards_ = image_shards; }
+
+  // Load the images (that are not in the shards) through the given cache of decoded
+  // images, which may be shared with other loaders and threads.
+  // If the cache downscales the images, the annotations are scaled to match.
+  void set_image_cache(ImageCache* image_cache) { image_cache_ = image_cache; }
+
+  // Path of the image file for the given annotation.
+  std::string get_image_file(const Annotation& annotation) const;
+
 private:
+  // Load the annotations, from the index in index_folder if it is up to date.
+  void LoadAnnotations(const std::string& annotations_folder,
+                       const std::string& index_folder);
+
+  // Load the image for the given annotation, from the shards or the cache if possible.
+  // scale is set to the size of the loaded image relative to the original image file.
+  void LoadImageFile(const Annotation& annotation, cv::Mat* image, double* scale) const;
+
   // Read the annotation file, convert to bounding box format, and save.
+  // Safe to call from several threads at once.
   void LoadAnnotationFile(const std::string& annotation_file,
-                          std::vector<Annotation>* image_annotations);
+                          std::vector<Annotation>* image_annotations) const;
 
   // Path to the folder containing the image files.
   std::string path_;
 
   // All annotations for all images.
   std::vector<std::vector<Annotation> > images_;
+
+  // Optional packed images (not owned).
+  const ImageShards* image_shards_;
+
+  // Optional cache of decoded images (not owned).
+  ImageCache* image_cache_;
 };
 
 #endif // LOADER_IMAGENET_DET_H
@@ -0,0 +1,48 @@
+#include "loader_lasot.h"
+
+#include "helper/helper.h"
+
+using std::string;
+using std::vector;
+namespace bfs = boost::filesystem;
+
+LoaderLasot::LoaderLasot(const string& lasot_folder)
+  : LoaderLasot(lasot_folder, bfs::temp_directory_path().string())
+{
+}
+
+LoaderLasot::LoaderLasot(const string& lasot_folder, const string& cache_folder)
+{
+  if (!bfs::is_directory(lasot_folder)) {
+    printf("Error - %s is not a valid directory!\n", lasot_folder.c_str());
+    return;
+  }
+
+  // Find the categories, and then the sequences of each category (only folders are
+  // listed, not the frames).
+  vector<string> categories;
+  find_subfolders(lasot_folder, &categories);
+
+  vector<vector<string> > category_sequences(categories.size());
+  parallel_for(categories.size(), kNumScanThreads, [&](const size_t i) {
+    find_subfolders(lasot_folder + "/" + categories[i], &category_sequences[i]);
+  });
+
+  vector<SequenceInfo> sequences;
+  for (size_t i = 0; i < categories.size(); ++i) {
+    for (size_t j = 0; j < category_sequences[i].size(); ++j) {
+      SequenceInfo sequence;
+      sequence.name = category_sequences[i][j];
+      sequence.path = lasot_folder + "/" + categories[i] + "/" + sequence.name;
+      sequence.groundtruth_file = sequence.path + "/groundtruth.txt";
+      sequence.one_based = true;
+      sequence.frame_prefix = "img/";
+      sequence.num_digits = 8;
+      sequence.frame_suffix = ".jpg";
+      sequence.first_number = 1;
+      sequences.push_back(sequence);
+    }
+  }
+
+  LoadSequences("lasot", lasot_folder, cache_folder, sequences);
+}
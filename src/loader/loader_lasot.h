@@ -0,0 +1,18 @@
+#ifndef LOADER_LASOT_H
+#define LOADER_LASOT_H
+
+#include "sequence_loader.h"
+
+// Loads videos from the LaSOT tracking dataset
+// (<category>/<category>-<n>/img/00000001.jpg, with groundtruth.txt next to img).
+class LoaderLasot : public SequenceLoader
+{
+public:
+  // Finds all sequences; the groundtruth cache is kept in the temporary directory.
+  LoaderLasot(const std::string& lasot_folder);
+
+  // As above, but keep the groundtruth cache in cache_folder.
+  LoaderLasot(const std::string& lasot_folder, const std::string& cache_folder);
+};
+
+#endif // LOADER_LASOT_H
@@ -0,0 +1,57 @@
+#include "loader_otb.h"
+
+#include "helper/helper.h"
+
+using std::string;
+using std::vector;
+namespace bfs = boost::filesystem;
+
+LoaderOtb::LoaderOtb(const string& otb_folder)
+  : LoaderOtb(otb_folder, bfs::temp_directory_path().string())
+{
+}
+
+LoaderOtb::LoaderOtb(const string& otb_folder, const string& cache_folder)
+{
+  if (!bfs::is_directory(otb_folder)) {
+    printf("Error - %s is not a valid directory!\n", otb_folder.c_str());
+    return;
+  }
+
+  vector<string> names;
+  find_subfolders(otb_folder, &names);
+
+  vector<SequenceInfo> sequences;
+  for (size_t i = 0; i < names.size(); ++i) {
+    SequenceInfo sequence;
+    sequence.path = otb_folder + "/" + names[i];
+    sequence.one_based = true;
+    sequence.frame_prefix = "img/";
+    sequence.num_digits = 4;
+    sequence.frame_suffix = ".jpg";
+    sequence.first_number = 1;
+
+    // A few sequences start later or are numbered with more digits; the numbering of
+    // those is found from the frame files when the groundtruth is first parsed.
+    const string& groundtruth_file = sequence.path + "/groundtruth_rect.txt";
+    if (bfs::exists(groundtruth_file)) {
+      sequence.name = names[i];
+      sequence.groundtruth_file = groundtruth_file;
+      sequences.push_back(sequence);
+      continue;
+    }
+
+    // One groundtruth file per target.
+    for (int target = 1; ; ++target) {
+      const string& target_suffix = "." + std::to_string(target);
+      sequence.groundtruth_file = sequence.path + "/groundtruth_rect" + target_suffix + ".txt";
+      if (!bfs::exists(sequence.groundtruth_file)) {
+        break;
+      }
+      sequence.name = names[i] + target_suffix;
+      sequences.push_back(sequence);
+    }
+  }
+
+  LoadSequences("otb", otb_folder, cache_folder, sequences);
+}
@@ -0,0 +1,20 @@
+#ifndef LOADER_OTB_H
+#define LOADER_OTB_H
+
+#include "sequence_loader.h"
+
+// Loads videos from the OTB tracking dataset
+// (<sequence>/img/0001.jpg, with groundtruth_rect.txt next to img).
+// Sequences with several targets (groundtruth_rect.1.txt, groundtruth_rect.2.txt, ...)
+// give one video per target, named <sequence>.1, <sequence>.2, ...
+class LoaderOtb : public SequenceLoader
+{
+public:
+  // Finds all sequences; the groundtruth cache is kept in the temporary directory.
+  LoaderOtb(const std::string& otb_folder);
+
+  // As above, but keep the groundtruth cache in cache_folder.
+  LoaderOtb(const std::string& otb_folder, const std::string& cache_folder);
+};
+
+#endif // LOADER_OTB_H
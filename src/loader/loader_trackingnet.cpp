@@ -0,0 +1,56 @@
+#include "loader_trackingnet.h"
+
+#include "helper/helper.h"
+
+using std::string;
+using std::vector;
+namespace bfs = boost::filesystem;
+
+LoaderTrackingNet::LoaderTrackingNet(const string& trackingnet_folder)
+  : LoaderTrackingNet(trackingnet_folder, bfs::temp_directory_path().string())
+{
+}
+
+LoaderTrackingNet::LoaderTrackingNet(const string& trackingnet_folder,
+                                     const string& cache_folder)
+{
+  if (!bfs::is_directory(trackingnet_folder)) {
+    printf("Error - %s is not a valid directory!\n", trackingnet_folder.c_str());
+    return;
+  }
+
+  // Find the chunks, and the sequences of each chunk from its annotation files
+  // (the frame folders are not listed).
+  vector<string> chunks;
+  find_subfolders(trackingnet_folder, &chunks);
+
+  vector<vector<string> > chunk_annotations(chunks.size());
+  parallel_for(chunks.size(), kNumScanThreads, [&](const size_t i) {
+    const string& anno_folder = trackingnet_folder + "/" + chunks[i] + "/anno";
+    if (bfs::is_directory(anno_folder)) {
+      find_files_with_extension(anno_folder, ".txt", &chunk_annotations[i]);
+    }
+  });
+
+  vector<SequenceInfo> sequences;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    const string& chunk_folder = trackingnet_folder + "/" + chunks[i];
+    for (size_t j = 0; j < chunk_annotations[i].size(); ++j) {
+      const string& annotation_file = chunk_annotations[i][j];
+      const string& name = annotation_file.substr(0, annotation_file.size() - 4);
+
+      SequenceInfo sequence;
+      sequence.name = chunks[i] + "/" + name;
+      sequence.path = chunk_folder + "/frames/" + name;
+      sequence.groundtruth_file = chunk_folder + "/anno/" + annotation_file;
+      sequence.one_based = false;
+      sequence.frame_prefix = "";
+      sequence.num_digits = 1;
+      sequence.frame_suffix = ".jpg";
+      sequence.first_number = 0;
+      sequences.push_back(sequence);
+    }
+  }
+
+  LoadSequences("trackingnet", trackingnet_folder, cache_folder, sequences);
+}
@@ -0,0 +1,20 @@
+#ifndef LOADER_TRACKINGNET_H
+#define LOADER_TRACKINGNET_H
+
+#include "sequence_loader.h"
+
+// Loads videos from the TrackingNet tracking dataset, which is split into chunks
+// (TRAIN_0, ..., TEST), each with frames/<sequence>/0.jpg and anno/<sequence>.txt.
+// For the test chunk only the first frame is annotated.
+class LoaderTrackingNet : public SequenceLoader
+{
+public:
+  // Finds the sequences of all chunks in trackingnet_folder;
+  // the groundtruth cache is kept in the temporary directory.
+  LoaderTrackingNet(const std::string& trackingnet_folder);
+
+  // As above, but keep the groundtruth cache in cache_folder.
+  LoaderTrackingNet(const std::string& trackingnet_folder, const std::string& cache_folder);
+};
+
+#endif // LOADER_TRACKINGNET_H
@@ -5,6 +5,7 @@
 #include <opencv2/highgui/highgui.hpp>
 
 #include "helper/helper.h"
+#include "loader/video_file_reader.h"
 
 using std::string;
 using std::vector;
@@ -12,6 +13,59 @@ namespace bfs = boost::filesystem;
 
 const bool kDoTest = false;
 
+namespace {
+
+// Read the annotations for one video, and find its image files.
+void LoadVideo(const string& video_path, Video* video) {
+  video->path = video_path;
+
+  // Find all image files (or read the frames from a video file next to the folder,
+  // which then only holds the annotations).
+  string video_file;
+  if (FindVideoFile(video_path, &video_file)) {
+    video->set_video_file(video_file);
+  } else {
+    vector<string> image_files;
+    find_files_with_extension(video_path, ".jpg", &image_files);
+    video->all_frames = FrameList(image_files);
+  }
+
+  // Open the annotation file.
+  const string& bbox_groundtruth_path = video_path + "/groundtruth.txt";
+  FILE* bbox_groundtruth_file_ptr = fopen(bbox_groundtruth_path.c_str(), "r");
+  int frame_num = 0;
+  double Ax, Ay, Bx, By, Cx, Cy, Dx, Dy;
+  vector<Frame> frames;
+
+  while (true) {
+    // Read the annotation data.
+    const int status = fscanf(bbox_groundtruth_file_ptr, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n",
+                 &Ax, &Ay, &Bx, &By, &Cx, &Cy, &Dx, &Dy);
+    if (status == EOF) {
+      break;
+    }
+
+    // Convert to bounding box format.
+    Frame frame;
+    frame.frame_num = frame_num;
+    BoundingBox& bbox = frame.bbox;
+    bbox.x1_ = std::min(Ax, std::min(Bx, std::min(Cx, Dx))) - 1;
+    bbox.y1_ = std::min(Ay, std::min(By, std::min(Cy, Dy))) - 1;
+    bbox.x2_ = std::max(Ax, std::max(Bx, std::max(Cx, Dx))) - 1;
+    bbox.y2_ = std::max(Ay, std::max(By, std::max(Cy, Dy))) - 1;
+
+    // Increment the frame number.
+    frame_num++;
+
+    frames.push_back(frame);
+  } // Process annotation file
+  fclose(bbox_groundtruth_file_ptr);
+
+  video->annotations = FrameAnnotations(frames);
+}
+
+} // namespace
+
 LoaderVOT::LoaderVOT(const std::string& vot_folder)
 {
   if (!bfs::is_directory(vot_folder)) {
@@ -24,48 +78,14 @@ LoaderVOT::LoaderVOT(const std::string& vot_folder)
   find_subfolders(vot_folder, &videos);
 
   printf("Found %zu videos...\n", videos.size());
+
+  // Load the videos in parallel, keeping them in (sorted) order.
+  videos_.resize(videos.size());
+  parallel_for(videos.size(), kNumScanThreads, [&](const size_t i) {
+    LoadVideo(vot_folder + "/" + videos[i], &videos_[i]);
+  });
+
   for (size_t i = 0; i < videos.size(); ++i) {
-    const string& video_name = videos[i];
-    const string& video_path = vot_folder + "/" + video_name;
-
-    printf("Loading video: %s\n", video_name.c_str());
-
-    Video video;
-    video.path = video_path;
-
-    // Find all image files
-    const boost::regex image_filter(".*\\.jpg");
-    find_matching_files(video_path, image_filter, &video.all_frames);
-
-    // Open the annotation file.
-    const string& bbox_groundtruth_path = video_path + "/groundtruth.txt";
-    FILE* bbox_groundtruth_file_ptr = fopen(bbox_groundtruth_path.c_str(), "r");
-    int frame_num = 0;
-    double Ax, Ay, Bx, By, Cx, Cy, Dx, Dy;
-
-    while (true) {
-      // Read the annotation data.
-      const int status = fscanf(bbox_groundtruth_file_ptr, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf\n",
-                   &Ax, &Ay, &Bx, &By, &Cx, &Cy, &Dx, &Dy);
-      if (status == EOF) {
-        break;
-      }
-
-      // Convert to bounding box format.
-      Frame frame;
-      frame.frame_num = frame_num;
-      BoundingBox& bbox = frame.bbox;
-      bbox.x1_ = std::min(Ax, std::min(Bx, std::min(Cx, Dx))) - 1;
-      bbox.y1_ = std::min(Ay, std::min(By, std::min(Cy, Dy))) - 1;
-      bbox.x2_ = std::max(Ax, std::max(Bx, std::max(Cx, Dx))) - 1;
-      bbox.y2_ = std::max(Ay, std::max(By, std::max(Cy, Dy))) - 1;
-
-      // Increment the frame number.
-      frame_num++;
-
-      video.annotations.push_back(frame);
-    } // Process annotation file
-    fclose(bbox_groundtruth_file_ptr);
-    videos_.push_back(video);
-  } // Process all videos
+    printf("Loaded video: %s\n", videos[i].c_str());
+  }
 }
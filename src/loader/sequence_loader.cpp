@@ -0,0 +1,462 @@
+#include "sequence_loader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include "helper/helper.h"
+
+using std::string;
+using std::vector;
+namespace bfs = boost::filesystem;
+
+namespace {
+
+// Identifies a groundtruth cache file (and its version).
+const uint32_t kCacheMagic = 0x47535132;  // "GSQ2"
+
+// Modification time and size of a groundtruth file, to tell whether the cache is still
+// up to date.
+struct FileStamp {
+  int64_t mtime;
+  uint64_t num_bytes;
+};
+
+// What the cache records for each sequence.
+struct SequenceRecord {
+  string name;
+  FileStamp stamp;
+
+  // Frame numbering (see SequenceInfo).
+  int32_t num_digits;
+  int32_t first_number;
+  uint32_t num_frames;
+
+  // Range of the annotations of this sequence in the columns.
+  uint64_t first_annotation;
+  uint32_t num_annotations;
+};
+
+// Annotations of all sequences, one column per field.
+struct Columns {
+  vector<int32_t> frame_nums;
+  vector<float> x1;
+  vector<float> y1;
+  vector<float> x2;
+  vector<float> y2;
+};
+
+// A memory-mapped cache file, unmapped when the last video that uses it is destroyed.
+struct MappedFile {
+  MappedFile() : data(NULL), num_bytes(0) { }
+
+  ~MappedFile() {
+    if (data) {
+      munmap(const_cast<char*>(data), num_bytes);
+    }
+  }
+
+  const char* data;
+  size_t num_bytes;
+};
+
+FileStamp GetStamp(const string& file) {
+  FileStamp stamp;
+  boost::system::error_code error;
+  stamp.mtime = bfs::last_write_time(file, error);
+  stamp.num_bytes = error ? 0 : bfs::file_size(file, error);
+  if (error) {
+    stamp.mtime = 0;
+    stamp.num_bytes = 0;
+  }
+  return stamp;
+}
+
+// The cache file for a dataset folder is named after a hash of its absolute path.
+string GetCacheFile(const string& cache_folder, const string& dataset_name,
+                    const string& dataset_folder) {
+  const string folder = bfs::absolute(dataset_folder).string();
+  char cache_name[64];
+  snprintf(cache_name, sizeof(cache_name), "_%016zx.gt", std::hash<string>()(folder));
+  return (bfs::path(cache_folder) / (dataset_name + cache_name)).string();
+}
+
+template <typename T>
+void WriteValue(const T& value, FILE* file) {
+  fwrite(&value, sizeof(value), 1, file);
+}
+
+template <typename T>
+bool ReadValue(FILE* file, T* value) {
+  return fread(value, sizeof(*value), 1, file) == 1;
+}
+
+void WriteString(const string& value, FILE* file) {
+  WriteValue(static_cast<uint32_t>(value.size()), file);
+  fwrite(value.data(), 1, value.size(), file);
+}
+
+bool ReadString(FILE* file, string* value) {
+  uint32_t length;
+  if (!ReadValue(file, &length)) {
+    return false;
+  }
+  value->resize(length);
+  return length == 0 || fread(&(*value)[0], 1, length, file) == length;
+}
+
+template <typename T>
+void WriteColumn(const vector<T>& column, FILE* file) {
+  if (!column.empty()) {
+    fwrite(&column[0], sizeof(T), column.size(), file);
+  }
+}
+
+// The columns start at the first multiple of 8 bytes after the header.
+size_t AlignOffset(const size_t offset) {
+  return (offset + 7) & ~static_cast<size_t>(7);
+}
+
+// Parse the groundtruth of a sequence into columns, with the frame numbers counting
+// from 0 at the first line, and the coordinates starting from 0 (subtracting 1 if
+// one_based).  Lines with a missing, NaN or empty box (the target is not visible)
+// are not annotated, but still count as frames.
+// Returns the number of lines.
+size_t ReadGroundtruth(const string& groundtruth_file, const bool one_based,
+                       Columns* columns) {
+  FILE* file = fopen(groundtruth_file.c_str(), "r");
+  if (!file) {
+    printf("Error - could not open %s\n", groundtruth_file.c_str());
+    return 0;
+  }
+
+  size_t num_lines = 0;
+  char line[1024];
+  while (fgets(line, sizeof(line), file)) {
+    // Values may be separated by commas, tabs or spaces, depending on the dataset.
+    double values[4];
+    int num_values = 0;
+    char* position = line;
+    while (num_values < 4) {
+      while (*position == ',' || *position == ' ' || *position == '\t') {
+        ++position;
+      }
+      char* end;
+      values[num_values] = strtod(position, &end);
+      if (end == position) {
+        break;
+      }
+      num_values++;
+      position = end;
+    }
+
+    // Skip blank lines.
+    if (num_values == 0 && (*position == '\0' || *position == '\n' || *position == '\r')) {
+      continue;
+    }
+
+    const int frame_num = num_lines;
+    num_lines++;
+
+    if (num_values < 4 || !std::isfinite(values[0]) || !std::isfinite(values[1]) ||
+        !std::isfinite(values[2]) || !std::isfinite(values[3]) ||
+        values[2] <= 0 || values[3] <= 0) {
+      continue;
+    }
+
+    const double x = one_based ? values[0] - 1 : values[0];
+    const double y = one_based ? values[1] - 1 : values[1];
+    columns->frame_nums.push_back(frame_num);
+    columns->x1.push_back(x);
+    columns->y1.push_back(y);
+    columns->x2.push_back(x + values[2]);
+    columns->y2.push_back(y + values[3]);
+  }
+  fclose(file);
+
+  return num_lines;
+}
+
+// List the frame files of a sequence to find how they are numbered.
+// Only needed if the numbering differs from the usual one for the dataset,
+// or if the groundtruth does not tell how many frames there are.
+// Returns the number of frame files.
+size_t FindFrameNumbering(const SequenceInfo& sequence, int32_t* num_digits,
+                          int32_t* first_number) {
+  const size_t slash = sequence.frame_prefix.rfind('/');
+  const string& prefix_folder =
+      slash == string::npos ? "" : sequence.frame_prefix.substr(0, slash);
+  const string& name_prefix =
+      slash == string::npos ? sequence.frame_prefix : sequence.frame_prefix.substr(slash + 1);
+
+  vector<string> frame_files;
+  find_files_with_extension(bfs::path(sequence.path) / prefix_folder, sequence.frame_suffix,
+                            &frame_files);
+  if (frame_files.empty()) {
+    return 0;
+  }
+
+  // The file names sort in numeric order if they are zero-padded, so the first name
+  // has the first number (unpadded numbers do not depend on num_digits).
+  const string& first_name = frame_files[0];
+  const size_t digits_length =
+      first_name.size() - name_prefix.size() - sequence.frame_suffix.size();
+  *num_digits = digits_length;
+  *first_number = atoi(first_name.substr(name_prefix.size(), digits_length).c_str());
+  return frame_files.size();
+}
+
+// Parse the groundtruth of all sequences (in parallel).
+void BuildCache(const vector<SequenceInfo>& sequences, const vector<FileStamp>& stamps,
+                vector<SequenceRecord>* records, Columns* columns) {
+  printf("Parsing the groundtruth of %zu sequences...\n", sequences.size());
+
+  records->resize(sequences.size());
+  vector<Columns> sequence_columns(sequences.size());
+  parallel_for(sequences.size(), kNumScanThreads, [&](const size_t i) {
+    const SequenceInfo& sequence = sequences[i];
+    SequenceRecord& record = (*records)[i];
+    record.name = sequence.name;
+    record.stamp = stamps[i];
+    record.num_digits = sequence.num_digits;
+    record.first_number = sequence.first_number;
+
+    const size_t num_lines = ReadGroundtruth(sequence.groundtruth_file, sequence.one_based,
+                                             &sequence_columns[i]);
+    record.num_frames = num_lines;
+
+    // Check that the first frame exists, so that the frames are only listed if
+    // they are numbered differently.  Test sets only have the groundtruth of
+    // the first frame, in which case the frames are counted.
+    string first_frame = sequence.path + "/" + sequence.frame_prefix;
+    char number[16];
+    snprintf(number, sizeof(number), "%0*d", sequence.num_digits, sequence.first_number);
+    first_frame += number;
+    first_frame += sequence.frame_suffix;
+    if (num_lines <= 1 || !bfs::exists(first_frame)) {
+      const size_t num_frame_files =
+          FindFrameNumbering(sequence, &record.num_digits, &record.first_number);
+      if (num_lines <= 1) {
+        record.num_frames = num_frame_files;
+      }
+    }
+  });
+
+  // Concatenate the columns of the sequences, in order.
+  for (size_t i = 0; i < sequences.size(); ++i) {
+    const Columns& sequence = sequence_columns[i];
+    SequenceRecord& record = (*records)[i];
+    record.first_annotation = columns->frame_nums.size();
+    record.num_annotations = sequence.frame_nums.size();
+    columns->frame_nums.insert(columns->frame_nums.end(), sequence.frame_nums.begin(),
+                               sequence.frame_nums.end());
+    columns->x1.insert(columns->x1.end(), sequence.x1.begin(), sequence.x1.end());
+    columns->y1.insert(columns->y1.end(), sequence.y1.begin(), sequence.y1.end());
+    columns->x2.insert(columns->x2.end(), sequence.x2.begin(), sequence.x2.end());
+    columns->y2.insert(columns->y2.end(), sequence.y2.begin(), sequence.y2.end());
+  }
+}
+
+// Cache format: magic, dataset folder, the record of each sequence, the number of
+// annotations, and then (aligned to 8 bytes) the columns: frame numbers, x1, y1, x2, y2.
+void SaveCache(const string& cache_file, const string& dataset_folder,
+               const vector<SequenceRecord>& records, const Columns& columns) {
+  // Write to a temporary file first, so that a partly written cache is never used.
+  // The file is named after the process, so that jobs started at the same time on the
+  // same dataset do not write into each other's file.
+  const string& temp_file = cache_file + "." + std::to_string(getpid()) + ".tmp";
+  FILE* file = fopen(temp_file.c_str(), "wb");
+  if (!file) {
+    printf("Could not write groundtruth cache %s\n", temp_file.c_str());
+    return;
+  }
+
+  WriteValue(kCacheMagic, file);
+  WriteString(bfs::absolute(dataset_folder).string(), file);
+
+  WriteValue(static_cast<uint32_t>(records.size()), file);
+  for (size_t i = 0; i < records.size(); ++i) {
+    const SequenceRecord& record = records[i];
+    WriteString(record.name, file);
+    WriteValue(record.stamp.mtime, file);
+    WriteValue(record.stamp.num_bytes, file);
+    WriteValue(record.num_digits, file);
+    WriteValue(record.first_number, file);
+    WriteValue(record.num_frames, file);
+    WriteValue(record.first_annotation, file);
+    WriteValue(record.num_annotations, file);
+  }
+  WriteValue(static_cast<uint64_t>(columns.frame_nums.size()), file);
+
+  const long header_bytes = ftell(file);
+  for (size_t i = header_bytes; i < AlignOffset(header_bytes); ++i) {
+    fputc(0, file);
+  }
+  WriteColumn(columns.frame_nums, file);
+  WriteColumn(columns.x1, file);
+  WriteColumn(columns.y1, file);
+  WriteColumn(columns.x2, file);
+  WriteColumn(columns.y2, file);
+
+  const bool write_error = ferror(file);
+  fclose(file);
+  if (write_error || rename(temp_file.c_str(), cache_file.c_str()) != 0) {
+    printf("Could not write groundtruth cache %s\n", cache_file.c_str());
+    remove(temp_file.c_str());
+    return;
+  }
+  printf("Saved groundtruth cache to %s\n", cache_file.c_str());
+}
+
+// Read the records and map the columns of the cache.
+// Returns false if the cache is missing, unreadable or out of date.
+bool LoadCache(const string& cache_file, const string& dataset_folder,
+               const vector<SequenceInfo>& sequences, const vector<FileStamp>& stamps,
+               vector<SequenceRecord>* records, AnnotationColumns* columns,
+               boost::shared_ptr<const void>* storage) {
+  FILE* file = fopen(cache_file.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  // Check that the cache was made from the same sequences and groundtruth files.
+  uint32_t magic;
+  string folder;
+  uint32_t num_records;
+  bool valid = ReadValue(file, &magic) && magic == kCacheMagic &&
+               ReadString(file, &folder) &&
+               folder == bfs::absolute(dataset_folder).string() &&
+               ReadValue(file, &num_records) && num_records == sequences.size();
+
+  records->resize(sequences.size());
+  for (size_t i = 0; valid && i < sequences.size(); ++i) {
+    SequenceRecord& record = (*records)[i];
+    valid = ReadString(file, &record.name) && record.name == sequences[i].name &&
+            ReadValue(file, &record.stamp.mtime) && record.stamp.mtime == stamps[i].mtime &&
+            ReadValue(file, &record.stamp.num_bytes) &&
+            record.stamp.num_bytes == stamps[i].num_bytes &&
+            ReadValue(file, &record.num_digits) &&
+            ReadValue(file, &record.first_number) &&
+            ReadValue(file, &record.num_frames) &&
+            ReadValue(file, &record.first_annotation) &&
+            ReadValue(file, &record.num_annotations);
+  }
+
+  uint64_t num_annotations = 0;
+  valid = valid && ReadValue(file, &num_annotations);
+  const size_t columns_offset = valid ? AlignOffset(ftell(file)) : 0;
+  fclose(file);
+
+  for (size_t i = 0; valid && i < records->size(); ++i) {
+    const SequenceRecord& record = (*records)[i];
+    valid = record.first_annotation + record.num_annotations <= num_annotations;
+  }
+  if (!valid) {
+    return false;
+  }
+
+  // Map the columns; their pages are read from disk when the annotations are used.
+  const size_t num_bytes = columns_offset + num_annotations * (sizeof(int32_t) + 4 * sizeof(float));
+  boost::shared_ptr<MappedFile> mapped_file(new MappedFile());
+  const int fd = open(cache_file.c_str(), O_RDONLY);
+  struct stat cache_stat;
+  if (fd < 0 || fstat(fd, &cache_stat) != 0 || cache_stat.st_size < 0 ||
+      static_cast<size_t>(cache_stat.st_size) < num_bytes) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+  const size_t file_size = static_cast<size_t>(cache_stat.st_size);
+  void* data = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    printf("Error - could not map %s\n", cache_file.c_str());
+    return false;
+  }
+  mapped_file->data = static_cast<const char*>(data);
+  mapped_file->num_bytes = file_size;
+
+  const char* column = mapped_file->data + columns_offset;
+  columns->frame_nums = reinterpret_cast<const int32_t*>(column);
+  column += num_annotations * sizeof(int32_t);
+  const float* x1 = reinterpret_cast<const float*>(column);
+  columns->x1 = x1;
+  columns->y1 = x1 + num_annotations;
+  columns->x2 = x1 + 2 * num_annotations;
+  columns->y2 = x1 + 3 * num_annotations;
+  columns->size = num_annotations;
+
+  *storage = mapped_file;
+  return true;
+}
+
+} // namespace
+
+SequenceLoader::SequenceLoader()
+{
+}
+
+void SequenceLoader::LoadSequences(const string& dataset_name, const string& dataset_folder,
+                                   const string& cache_folder,
+                                   const vector<SequenceInfo>& sequences) {
+  // Stat the groundtruth files (in parallel, since this is most of the time taken
+  // when the cache is up to date).
+  vector<FileStamp> stamps(sequences.size());
+  parallel_for(sequences.size(), kNumScanThreads, [&](const size_t i) {
+    stamps[i] = GetStamp(sequences[i].groundtruth_file);
+  });
+
+  const string& cache_file = GetCacheFile(cache_folder, dataset_name, dataset_folder);
+  vector<SequenceRecord> records;
+  AnnotationColumns columns;
+  boost::shared_ptr<const void> storage;
+  if (LoadCache(cache_file, dataset_folder, sequences, stamps, &records, &columns, &storage)) {
+    printf("Loaded groundtruth from %s\n", cache_file.c_str());
+  } else {
+    boost::shared_ptr<Columns> parsed_columns(new Columns());
+    BuildCache(sequences, stamps, &records, parsed_columns.get());
+    SaveCache(cache_file, dataset_folder, records, *parsed_columns);
+
+    // Use the cache that was just saved, so that the memory is the same as on later
+    // runs; if it could not be saved, use the parsed columns directly.
+    if (!LoadCache(cache_file, dataset_folder, sequences, stamps, &records, &columns,
+                   &storage)) {
+      columns.frame_nums = parsed_columns->frame_nums.data();
+      columns.x1 = parsed_columns->x1.data();
+      columns.y1 = parsed_columns->y1.data();
+      columns.x2 = parsed_columns->x2.data();
+      columns.y2 = parsed_columns->y2.data();
+      columns.size = parsed_columns->frame_nums.size();
+      storage = parsed_columns;
+    }
+  }
+
+  videos_.resize(sequences.size());
+  for (size_t i = 0; i < sequences.size(); ++i) {
+    const SequenceInfo& sequence = sequences[i];
+    const SequenceRecord& record = records[i];
+
+    Video& video = videos_[i];
+    video.path = sequence.path;
+    video.all_frames = FrameList(sequence.frame_prefix, record.num_digits, sequence.frame_suffix,
+                                 record.first_number, record.num_frames);
+
+    AnnotationColumns video_columns;
+    video_columns.frame_nums = columns.frame_nums + record.first_annotation;
+    video_columns.x1 = columns.x1 + record.first_annotation;
+    video_columns.y1 = columns.y1 + record.first_annotation;
+    video_columns.x2 = columns.x2 + record.first_annotation;
+    video_columns.y2 = columns.y2 + record.first_annotation;
+    video_columns.size = record.num_annotations;
+    video.annotations = FrameAnnotations(video_columns, storage);
+  }
+
+  printf("Loaded %zu %s sequences\n", videos_.size(), dataset_name.c_str());
+}
@@ -0,0 +1,53 @@
+#ifndef SEQUENCE_LOADER_H
+#define SEQUENCE_LOADER_H
+
+#include <string>
+#include <vector>
+
+#include "loader/video_loader.h"
+
+// Where to find the frames and groundtruth of one sequence of a dataset whose frames
+// are numbered consecutively (e.g. img/00000001.jpg, img/00000002.jpg, ...).
+struct SequenceInfo {
+  // Name of the sequence (unique within the dataset).
+  std::string name;
+
+  // Folder that the frame names are relative to.
+  std::string path;
+
+  // Text file with one box (x, y, width, height) per line, for consecutive frames
+  // starting from the first one.
+  std::string groundtruth_file;
+
+  // Whether the groundtruth coordinates start from 1 (OTB and LaSOT, whose toolkits
+  // are in MATLAB) rather than from 0 (GOT-10k and TrackingNet).  They are converted
+  // to start from 0, like the boxes of the other loaders.
+  bool one_based;
+
+  // The frames are named frame_prefix + number + frame_suffix, with the number
+  // zero-padded to num_digits digits and counting up from first_number.
+  // If there is no frame with first_number, the numbering is found from the frame files.
+  std::string frame_prefix;
+  int num_digits;
+  std::string frame_suffix;
+  int first_number;
+};
+
+// Base class for loaders of large datasets, which are cheap to construct.
+// The frame files are not listed; their names are generated from the naming pattern.
+// The groundtruth of all sequences is parsed once into a binary cache of columns,
+// which is then memory-mapped and shared by the videos, so only what is used is read.
+class SequenceLoader : public VideoLoader
+{
+protected:
+  SequenceLoader();
+
+  // Create a video for each of the sequences.  The groundtruth cache is kept in
+  // cache_folder, named after dataset_name and a hash of dataset_folder, and is
+  // rebuilt whenever a groundtruth file has changed.
+  void LoadSequences(const std::string& dataset_name, const std::string& dataset_folder,
+                     const std::string& cache_folder,
+                     const std::vector<SequenceInfo>& sequences);
+};
+
+#endif // SEQUENCE_LOADER_H
@@ -0,0 +1,380 @@
+#include "synthetic_video.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include <boost/filesystem.hpp>
+
+namespace bfs = boost::filesystem;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Standard deviation of the change in the direction of motion per frame, in radians.
+const double kTurnSigma = 0.1;
+
+// Range of the period of the size change, in frames.
+const double kMinScalePeriod = 40;
+const double kMaxScalePeriod = 120;
+
+// Number of frames that an occluder takes to pass in front of the target.
+const int kOcclusionFrames = 20;
+
+// Size of the occluder, relative to the target.
+const double kOccluderWidth = 0.5;
+const double kOccluderHeight = 1.4;
+
+// Name of the image subfolder (and annotation subfolder) written for ImageNet DET.
+const char kImagenetFolder[] = "synthetic";
+
+// Make a smooth random texture of the given size.
+void MakeTexture(const int width, const int height, cv::RNG* rng, cv::Mat* texture) {
+  cv::Mat noise(height, width, CV_8UC3);
+  rng->fill(noise, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+  cv::GaussianBlur(noise, *texture, cv::Size(5, 5), 0);
+}
+
+// Draw the texture resized to the given rectangle, clipped to the image.
+void DrawTexture(const cv::Mat& texture, const cv::Rect& rect, cv::Mat* image) {
+  const cv::Rect visible = rect & cv::Rect(0, 0, image->cols, image->rows);
+  if (visible.area() == 0) {
+    return;
+  }
+  cv::Mat texture_resized;
+  cv::resize(texture, texture_resized, rect.size());
+  const cv::Rect texture_visible(visible.x - rect.x, visible.y - rect.y,
+                                 visible.width, visible.height);
+  cv::Mat image_location = (*image)(visible);
+  texture_resized(texture_visible).copyTo(image_location);
+}
+
+// Generates the frames of one synthetic video, in order.
+class SyntheticVideoGenerator
+{
+public:
+  SyntheticVideoGenerator(const SyntheticVideoOptions& options, const int seed);
+
+  // Generate the next frame, with the box of the target.
+  void NextFrame(cv::Mat* image, BoundingBox* bbox);
+
+private:
+  // Get the size of the target in the given frame.
+  void GetTargetSize(const int frame_num, int* width, int* height) const;
+
+  // Get the rectangle of the occluder in the given frame for a target at target_rect,
+  // or return false if no occluder passes in that frame.
+  bool GetOccluder(const int frame_num, const cv::Rect& target_rect,
+                   cv::Rect* occluder_rect) const;
+
+  SyntheticVideoOptions options_;
+  cv::RNG rng_;
+
+  cv::Mat background_;
+  cv::Mat target_;
+  cv::Mat occluder_;
+
+  // Period (in frames) and phase of the size change.
+  double scale_period_;
+  double scale_phase_;
+
+  // First frame of each pass of the occluder.
+  vector<int> occlusion_starts_;
+
+  // Center of the target and direction of its motion.
+  double center_x_;
+  double center_y_;
+  double direction_;
+
+  int frame_num_;
+};
+
+SyntheticVideoGenerator::SyntheticVideoGenerator(const SyntheticVideoOptions& options,
+                                                 const int seed)
+  : options_(options),
+    rng_(static_cast<uint64>(seed)),
+    frame_num_(0)
+{
+  MakeTexture(options.width, options.height, &rng_, &background_);
+
+  // Make the target brighter than the background so that it is easy to track,
+  // and the occluder darker, so that it is easy to tell apart from the target.
+  const int texture_width = std::max(1, static_cast<int>(options.target_width * 2));
+  const int texture_height = std::max(1, static_cast<int>(options.target_height * 2));
+  MakeTexture(texture_width, texture_height, &rng_, &target_);
+  target_.convertTo(target_, -1, 0.5, 128);
+  MakeTexture(texture_width, texture_height, &rng_, &occluder_);
+  occluder_.convertTo(occluder_, -1, 0.5, 0);
+
+  scale_period_ = rng_.uniform(kMinScalePeriod, kMaxScalePeriod);
+  scale_phase_ = rng_.uniform(0., 2 * M_PI);
+
+  // Spread the passes of the occluder evenly over the video.
+  const int occlusion_frames = std::min(kOcclusionFrames, options.num_frames);
+  const int num_occlusions = static_cast<int>(
+      options.occlusion * options.num_frames / occlusion_frames + 0.5);
+  for (int i = 0; i < num_occlusions; ++i) {
+    const int start = static_cast<int>((i + 0.5) * options.num_frames / num_occlusions) -
+        occlusion_frames / 2;
+    occlusion_starts_.push_back(
+        std::max(0, std::min(start, options.num_frames - occlusion_frames)));
+  }
+
+  // Start at a random position, inside the frame even at the largest target size.
+  const double max_scale = 1 + options.scale_change;
+  const double margin_x = std::min(options.target_width * max_scale, 1. * options.width) / 2;
+  const double margin_y = std::min(options.target_height * max_scale, 1. * options.height) / 2;
+  center_x_ = rng_.uniform(margin_x, options.width - margin_x + 1e-6);
+  center_y_ = rng_.uniform(margin_y, options.height - margin_y + 1e-6);
+  direction_ = rng_.uniform(0., 2 * M_PI);
+}
+
+void SyntheticVideoGenerator::GetTargetSize(const int frame_num, int* width,
+                                            int* height) const {
+  const double scale = 1 + options_.scale_change *
+      sin(2 * M_PI * frame_num / scale_period_ + scale_phase_);
+  *width = std::max(1, std::min(options_.width,
+                                static_cast<int>(options_.target_width * scale)));
+  *height = std::max(1, std::min(options_.height,
+                                 static_cast<int>(options_.target_height * scale)));
+}
+
+bool SyntheticVideoGenerator::GetOccluder(const int frame_num, const cv::Rect& target_rect,
+                                          cv::Rect* occluder_rect) const {
+  const int occlusion_frames = std::min(kOcclusionFrames, options_.num_frames);
+  for (size_t i = 0; i < occlusion_starts_.size(); ++i) {
+    const int start = occlusion_starts_[i];
+    if (frame_num < start || frame_num >= start + occlusion_frames) {
+      continue;
+    }
+
+    // Pass from the left of the target to its right.
+    const double progress = static_cast<double>(frame_num - start) /
+        std::max(1, occlusion_frames - 1);
+    const int width = std::max(1, static_cast<int>(target_rect.width * kOccluderWidth));
+    const int height = std::max(1, static_cast<int>(target_rect.height * kOccluderHeight));
+    const int x = target_rect.x - width +
+        static_cast<int>(progress * (target_rect.width + width));
+    const int y = target_rect.y + target_rect.height / 2 - height / 2;
+    *occluder_rect = cv::Rect(x, y, width, height);
+    return true;
+  }
+  return false;
+}
+
+void SyntheticVideoGenerator::NextFrame(cv::Mat* image, BoundingBox* bbox) {
+  int width;
+  int height;
+  GetTargetSize(frame_num_, &width, &height);
+
+  // Move the target (after the first frame), turning a little at random
+  // and bouncing off the edges of the frame.
+  if (frame_num_ > 0) {
+    direction_ += rng_.gaussian(kTurnSigma);
+    center_x_ += options_.speed * cos(direction_);
+    center_y_ += options_.speed * sin(direction_);
+  }
+  if (center_x_ - width / 2. < 0 || center_x_ + width / 2. > options_.width) {
+    center_x_ = std::max(width / 2., std::min(options_.width - width / 2., center_x_));
+    direction_ = M_PI - direction_;
+  }
+  if (center_y_ - height / 2. < 0 || center_y_ + height / 2. > options_.height) {
+    center_y_ = std::max(height / 2., std::min(options_.height - height / 2., center_y_));
+    direction_ = -direction_;
+  }
+
+  const int x1 = std::max(0, std::min(options_.width - width,
+                                      static_cast<int>(center_x_ - width / 2.)));
+  const int y1 = std::max(0, std::min(options_.height - height,
+                                      static_cast<int>(center_y_ - height / 2.)));
+  const cv::Rect target_rect(x1, y1, width, height);
+
+  *image = background_.clone();
+  DrawTexture(target_, target_rect, image);
+
+  // The occluder covers part of the target, whose box stays annotated in full.
+  cv::Rect occluder_rect;
+  if (GetOccluder(frame_num_, target_rect, &occluder_rect)) {
+    DrawTexture(occluder_, occluder_rect, image);
+  }
+
+  bbox->x1_ = x1;
+  bbox->y1_ = y1;
+  bbox->x2_ = x1 + width;
+  bbox->y2_ = y1 + height;
+
+  frame_num_++;
+}
+
+// Name of the file of the given frame (numbered from 0), as in ALOV and VOT.
+string GetFrameName(const int frame_num, const char* extension) {
+  char frame_name[32];
+  sprintf(frame_name, "%08d%s", frame_num + 1, extension);
+  return frame_name;
+}
+
+// Write the frames of a synthetic video as jpg files to video_folder, and return
+// the boxes of the target.
+void WriteVideoFrames(const SyntheticVideoOptions& options, const int seed,
+                      const string& video_folder, vector<BoundingBox>* bboxes) {
+  bfs::create_directories(video_folder);
+  SyntheticVideoGenerator generator(options, seed);
+  for (int frame_num = 0; frame_num < options.num_frames; ++frame_num) {
+    cv::Mat image;
+    BoundingBox bbox;
+    generator.NextFrame(&image, &bbox);
+    cv::imwrite(video_folder + "/" + GetFrameName(frame_num, ".jpg"), image);
+    bboxes->push_back(bbox);
+  }
+}
+
+// Write the corners of the box as 1-based coordinates (as in the ALOV and VOT annotations),
+// separated by separator.
+void WriteCorners(const BoundingBox& bbox, const char separator, FILE* file) {
+  const double x1 = bbox.x1_ + 1;
+  const double y1 = bbox.y1_ + 1;
+  const double x2 = bbox.x2_ + 1;
+  const double y2 = bbox.y2_ + 1;
+  fprintf(file, "%.2lf%c%.2lf%c%.2lf%c%.2lf%c%.2lf%c%.2lf%c%.2lf%c%.2lf\n",
+          x1, separator, y2, separator, x1, separator, y1, separator,
+          x2, separator, y1, separator, x2, separator, y2);
+}
+
+} // namespace
+
+SyntheticVideoOptions::SyntheticVideoOptions()
+  : width(320),
+    height(240),
+    num_frames(100),
+    target_width(60),
+    target_height(40),
+    speed(3),
+    scale_change(0.25),
+    occlusion(0),
+    seed(42)
+{
+}
+
+void MakeSyntheticVideo(const SyntheticVideoOptions& options, const string& video_name,
+                        Video* video) {
+  boost::shared_ptr<vector<cv::Mat> > images(new vector<cv::Mat>(options.num_frames));
+  vector<Frame> frames(options.num_frames);
+  SyntheticVideoGenerator generator(options, options.seed);
+  for (int frame_num = 0; frame_num < options.num_frames; ++frame_num) {
+    frames[frame_num].frame_num = frame_num;
+    generator.NextFrame(&(*images)[frame_num], &frames[frame_num].bbox);
+  }
+
+  video->path = video_name;
+  video->set_images(images);
+  video->annotations = FrameAnnotations(frames);
+}
+
+void MakeSyntheticVideos(const SyntheticVideoOptions& options, const int num_videos,
+                         vector<Video>* videos) {
+  for (int i = 0; i < num_videos; ++i) {
+    SyntheticVideoOptions video_options = options;
+    video_options.seed = options.seed + i;
+    char video_name[32];
+    sprintf(video_name, "synthetic/video%05d", i + 1);
+    Video video;
+    MakeSyntheticVideo(video_options, video_name, &video);
+    videos->push_back(video);
+  }
+}
+
+void WriteSyntheticAlov(const SyntheticVideoOptions& options, const int num_categories,
+                        const int num_videos, const int annotation_interval,
+                        const string& videos_folder, const string& annotations_folder) {
+  const int interval = std::max(1, annotation_interval);
+  for (int i = 0; i < num_videos; ++i) {
+    // Deal the videos out to the categories, e.g. 01-Synthetic/01-Synthetic_video00001.
+    char category[32];
+    sprintf(category, "%02d-Synthetic", i % num_categories + 1);
+    char video_name[64];
+    sprintf(video_name, "%s_video%05d", category, i / num_categories + 1);
+
+    vector<BoundingBox> bboxes;
+    WriteVideoFrames(options, options.seed + i, videos_folder + "/" + category + "/" + video_name,
+                     &bboxes);
+
+    const string category_annotations = annotations_folder + "/" + category;
+    bfs::create_directories(category_annotations);
+    const string annotation_file = category_annotations + "/" + video_name + ".ann";
+    FILE* file = fopen(annotation_file.c_str(), "w");
+    if (!file) {
+      printf("Error - could not write %s\n", annotation_file.c_str());
+      return;
+    }
+    for (size_t frame_num = 0; frame_num < bboxes.size(); frame_num += interval) {
+      fprintf(file, "%zu ", frame_num + 1);
+      WriteCorners(bboxes[frame_num], ' ', file);
+    }
+    fclose(file);
+    printf("Wrote synthetic video %s\n", video_name);
+  }
+}
+
+void WriteSyntheticVot(const SyntheticVideoOptions& options, const int num_videos,
+                       const string& vot_folder) {
+  for (int i = 0; i < num_videos; ++i) {
+    char video_name[32];
+    sprintf(video_name, "synthetic%03d", i + 1);
+    const string video_folder = vot_folder + "/" + video_name;
+
+    vector<BoundingBox> bboxes;
+    WriteVideoFrames(options, options.seed + i, video_folder, &bboxes);
+
+    const string groundtruth_file = video_folder + "/groundtruth.txt";
+    FILE* file = fopen(groundtruth_file.c_str(), "w");
+    if (!file) {
+      printf("Error - could not write %s\n", groundtruth_file.c_str());
+      return;
+    }
+    for (size_t frame_num = 0; frame_num < bboxes.size(); ++frame_num) {
+      WriteCorners(bboxes[frame_num], ',', file);
+    }
+    fclose(file);
+    printf("Wrote synthetic video %s\n", video_name);
+  }
+}
+
+void WriteSyntheticImagenetDet(const SyntheticVideoOptions& options, const int num_images,
+                               const string& images_folder,
+                               const string& annotations_folder) {
+  const string image_subfolder = images_folder + "/" + kImagenetFolder;
+  const string annotation_subfolder = annotations_folder + "/" + kImagenetFolder;
+  bfs::create_directories(image_subfolder);
+  bfs::create_directories(annotation_subfolder);
+
+  for (int i = 0; i < num_images; ++i) {
+    // Each image is the first frame of a video with its own seed, so the images differ.
+    cv::Mat image;
+    BoundingBox bbox;
+    SyntheticVideoGenerator generator(options, options.seed + i);
+    generator.NextFrame(&image, &bbox);
+
+    const string image_name = GetFrameName(i, "");
+    cv::imwrite(image_subfolder + "/" + image_name + ".JPEG", image);
+
+    const string annotation_file = annotation_subfolder + "/" + image_name + ".xml";
+    FILE* file = fopen(annotation_file.c_str(), "w");
+    if (!file) {
+      printf("Error - could not write %s\n", annotation_file.c_str());
+      return;
+    }
+    fprintf(file, "<annotation>\n");
+    fprintf(file, "  <folder>%s</folder>\n", kImagenetFolder);
+    fprintf(file, "  <filename>%s</filename>\n", image_name.c_str());
+    fprintf(file, "  <size><width>%d</width><height>%d</height></size>\n",
+            image.cols, image.rows);
+    fprintf(file, "  <object><bndbox><xmin>%d</xmin><xmax>%d</xmax>"
+            "<ymin>%d</ymin><ymax>%d</ymax></bndbox></object>\n",
+            static_cast<int>(bbox.x1_), static_cast<int>(bbox.x2_),
+            static_cast<int>(bbox.y1_), static_cast<int>(bbox.y2_));
+    fprintf(file, "</annotation>\n");
+    fclose(file);
+  }
+  printf("Wrote %d synthetic images to %s\n", num_images, image_subfolder.c_str());
+}
@@ -0,0 +1,77 @@
+#ifndef SYNTHETIC_VIDEO_H
+#define SYNTHETIC_VIDEO_H
+
+#include <string>
+#include <vector>
+
+#include "loader/video.h"
+
+// Synthetic tracking data, so that the loaders, the tracker, training and the
+// benchmarks can run without downloading any dataset: a textured target moving
+// and changing size over a textured background, sometimes partly covered by an
+// occluder passing in front of it, with the target's box annotated in every frame.
+// The videos are generated from a seed, so they are identical on every run.
+
+// Parameters of the synthetic videos.
+struct SyntheticVideoOptions {
+  // The defaults make short, small videos with moderate motion.
+  SyntheticVideoOptions();
+
+  // Size of the frames.
+  int width;
+  int height;
+
+  // Number of frames of each video.
+  int num_frames;
+
+  // Size of the target in the first frame.
+  double target_width;
+  double target_height;
+
+  // Distance that the target moves per frame, in pixels.
+  double speed;
+
+  // Largest change of the target size, relative to its initial size (e.g. 0.25 for
+  // sizes between 75% and 125%).
+  double scale_change;
+
+  // Fraction of the frames in which an occluder passes in front of the target.
+  double occlusion;
+
+  // Seed of the first video; each further video uses the next seed, so the videos differ.
+  int seed;
+};
+
+// Generate a synthetic video in memory and return it: the frames are kept in
+// memory (see Video::set_images), so loading them does no decoding or disk access.
+// video->path is set to video_name, which only identifies the video.
+void MakeSyntheticVideo(const SyntheticVideoOptions& options, const std::string& video_name,
+                        Video* video);
+
+// Generate num_videos synthetic videos in memory (with seeds options.seed,
+// options.seed + 1, ...).
+void MakeSyntheticVideos(const SyntheticVideoOptions& options, const int num_videos,
+                         std::vector<Video>* videos);
+
+// Write num_videos synthetic videos in the layout of ALOV (see LoaderAlov), split
+// between num_categories categories: the frames as videos_folder/category/video/00000001.jpg, ...,
+// and every annotation_interval-th frame annotated in annotations_folder/category/video.ann.
+void WriteSyntheticAlov(const SyntheticVideoOptions& options, const int num_categories,
+                        const int num_videos, const int annotation_interval,
+                        const std::string& videos_folder,
+                        const std::string& annotations_folder);
+
+// Write num_videos synthetic videos in the layout of VOT (see LoaderVOT): the frames as
+// vot_folder/video/00000001.jpg, ..., and all annotations in vot_folder/video/groundtruth.txt.
+void WriteSyntheticVot(const SyntheticVideoOptions& options, const int num_videos,
+                       const std::string& vot_folder);
+
+// Write num_images synthetic images in the layout of ImageNet DET (see LoaderImagenetDet):
+// the images as images_folder/synthetic/00000001.JPEG, ..., each with an XML annotation in
+// annotations_folder/synthetic/.  Each image is the first frame of a synthetic video
+// with its own seed.
+void WriteSyntheticImagenetDet(const SyntheticVideoOptions& options, const int num_images,
+                               const std::string& images_folder,
+                               const std::string& annotations_folder);
+
+#endif // SYNTHETIC_VIDEO_H
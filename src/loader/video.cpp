@@ -1,16 +1,203 @@
 #include "video.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include "helper/metrics.h"
+#include "helper/profiler.h"
+#include "loader/image_cache.h"
+#include "loader/image_shards.h"
+#include "loader/video_file_reader.h"
+
 using std::string;
 using std::vector;
 
-void Video::ShowVideo() const {
-  const string& video_path = path;
+namespace {
+
+// Scale the bounding box coordinates by the given factor.
+void ScaleBox(const double scale, BoundingBox* box) {
+  box->x1_ *= scale;
+  box->y1_ *= scale;
+  box->x2_ *= scale;
+  box->y2_ *= scale;
+}
+
+} // namespace
+
+FrameAnnotations::FrameAnnotations()
+  : frames_(new vector<Frame>()),
+    frame_annotations_(new vector<int>()),
+    columns_()
+{
+}
+
+FrameAnnotations::FrameAnnotations(const vector<Frame>& frames)
+  : frames_(new vector<Frame>(frames)),
+    columns_()
+{
+  // Find the annotation for each frame number (the first one, if there are several).
+  int max_frame_num = -1;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    max_frame_num = std::max(max_frame_num, frames[i].frame_num);
+  }
+  vector<int>* frame_annotations = new vector<int>(max_frame_num + 1, -1);
+  frame_annotations_.reset(frame_annotations);
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const int frame_num = frames[i].frame_num;
+    if (frame_num >= 0 && (*frame_annotations)[frame_num] < 0) {
+      (*frame_annotations)[frame_num] = i;
+    }
+  }
+}
+
+FrameAnnotations::FrameAnnotations(const AnnotationColumns& columns,
+                                   const boost::shared_ptr<const void>& storage)
+  : columns_(columns),
+    storage_(storage)
+{
+}
+
+Frame FrameAnnotations::operator[](const size_t i) const {
+  if (frames_) {
+    return (*frames_)[i];
+  }
+
+  Frame frame;
+  frame.frame_num = columns_.frame_nums[i];
+  frame.bbox.x1_ = columns_.x1[i];
+  frame.bbox.y1_ = columns_.y1[i];
+  frame.bbox.x2_ = columns_.x2[i];
+  frame.bbox.y2_ = columns_.y2[i];
+  return frame;
+}
 
-  const vector<string>& image_files = all_frames;
+int FrameAnnotations::Find(const int frame_num) const {
+  if (!frames_) {
+    // The frame numbers are sorted, so search for the first annotation of this frame.
+    const int32_t* end = columns_.frame_nums + columns_.size;
+    const int32_t* it = std::lower_bound(columns_.frame_nums, end, frame_num);
+    return (it != end && *it == frame_num) ? it - columns_.frame_nums : -1;
+  }
+
+  if (frame_num < 0 || frame_num >= frame_annotations_->size()) {
+    return -1;
+  }
+  return (*frame_annotations_)[frame_num];
+}
+
+Video::Video()
+  : image_cache_(NULL),
+    image_shards_(NULL)
+{
+}
+
+void Video::set_video_file(const string& video_file) {
+  video_file_.reset(new VideoFileReader(video_file));
+  if (all_frames.empty()) {
+    all_frames = FrameList("", 8, "", 0, video_file_->GetNumFrames());
+  }
+}
 
+void Video::set_images(const boost::shared_ptr<const vector<cv::Mat> >& images) {
+  images_ = images;
+  if (all_frames.empty()) {
+    all_frames = FrameList("", 8, ".png", 1, images->size());
+  }
+}
+
+void Video::GetImageFile(const int frame_num, string* image_file) const {
+  *image_file = path;
+  image_file->push_back('/');
+  all_frames.AppendName(frame_num, image_file);
+}
+
+void Video::LoadImage(const int frame_num, cv::Mat* image, double* scale) const {
+  PROFILE_ZONE("LoadImage");
+  *scale = 1;
+  if (images_) {
+    if (frame_num >= 0 && frame_num < images_->size()) {
+      *image = (*images_)[frame_num];
+    } else {
+      *image = cv::Mat();
+    }
+    return;
+  }
+
+  if (video_file_) {
+    if (!video_file_->ReadFrame(frame_num, image)) {
+      *image = cv::Mat();
+    }
+    return;
+  }
+
+  string image_file;
+  GetImageFile(frame_num, &image_file);
+  if (image_shards_ && image_shards_->LoadImage(image_file, image, scale)) {
+    return;
+  }
+
+  if (image_cache_) {
+    image_cache_->LoadImage(image_file, image, scale);
+  } else {
+    *image = cv::imread(image_file);
+    CountDecodedImage(image->total() * image->elemSize());
+  }
+}
+
+void Video::LoadReducedImage(const int frame_num, const int reduction, cv::Mat* image,
+                             double* scale) const {
+  PROFILE_ZONE("LoadReducedImage");
+  *scale = 1;
+  if (reduction <= 1 || images_ || video_file_ || image_shards_ || image_cache_) {
+    double image_scale;
+    LoadImage(frame_num, image, &image_scale);
+    return;
+  }
+
+  // Use the largest reduction that the decoder supports, up to the one requested.
+  int flags;
+  int decode_reduction;
+  if (reduction >= 8) {
+    flags = cv::IMREAD_REDUCED_COLOR_8;
+    decode_reduction = 8;
+  } else if (reduction >= 4) {
+    flags = cv::IMREAD_REDUCED_COLOR_4;
+    decode_reduction = 4;
+  } else {
+    flags = cv::IMREAD_REDUCED_COLOR_2;
+    decode_reduction = 2;
+  }
+
+  string image_file;
+  GetImageFile(frame_num, &image_file);
+  *image = cv::imread(image_file, flags);
+  CountDecodedImage(image->total() * image->elemSize());
+  *scale = 1.0 / decode_reduction;
+}
+
+double Video::GetImageScale(const int frame_num) const {
+  if (images_ || video_file_) {
+    return 1;
+  }
+
+  string image_file;
+  GetImageFile(frame_num, &image_file);
+  double scale = 1;
+  if (image_shards_ && image_shards_->GetScale(image_file, &scale)) {
+    return scale;
+  }
+
+  // The scale of an image downscaled by the cache is only known once it is decoded
+  // (usually it was, since the frame was just loaded).  Otherwise the annotation is
+  // left in the coordinates of the image file, rather than decoding the image here.
+  if (image_cache_ && image_cache_->GetScale(image_file, &scale)) {
+    return scale;
+  }
+  return 1;
+}
+
+void Video::ShowVideo() const {
   int annotated_frame_index = 0;
 
   // For the 0th annotation in this video, get the start and end frames.
@@ -20,8 +207,17 @@ void Video::ShowVideo() const {
   // Iterate over all frames in this video.
   for (size_t image_frame_num = start_frame; image_frame_num <= end_frame; ++image_frame_num) {
     // Load the image.
-    const string& image_file = video_path + "/" + image_files[image_frame_num];
-    cv::Mat image = cv::imread(image_file);
+    string image_file;
+    GetImageFile(image_frame_num, &image_file);
+    cv::Mat image;
+    if (images_ || video_file_) {
+      // Frames in memory or from the reader are shared, so draw on a copy.
+      double scale;
+      LoadImage(image_frame_num, &image, &scale);
+      image = image.clone();
+    } else {
+      image = cv::imread(image_file);
+    }
 
     // Get the frame number for the next annotation.
     const int annotated_frame_num = annotations[annotated_frame_index].frame_num;
@@ -31,7 +227,7 @@ void Video::ShowVideo() const {
     // Check if the annotation frame number corresponds to the image frame number.
     if (annotated_frame_num == image_frame_num) {
       // Draw the annotation on the image.
-      const BoundingBox& box = annotations[annotated_frame_index].bbox;
+      const BoundingBox box = annotations[annotated_frame_index].bbox;
       box.DrawBoundingBox(&image);
       has_bounding_box = true;
 
@@ -64,15 +260,14 @@ void Video::LoadAnnotation(const int annotation_index,
                           cv::Mat* image,
                           BoundingBox* box) const {
   // Get the annotation corresponding to this index.
-  const Frame& annotated_frame = annotations[annotation_index];
+  const Frame annotated_frame = annotations[annotation_index];
 
   // Get the frame number corresponding to this annotation.
   *frame_num = annotated_frame.frame_num;
 
   *box = annotated_frame.bbox;
 
-  const string& video_path = path;
-  const vector<string>& image_files = all_frames;
+  const FrameList& image_files = all_frames;
 
   if (image_files.empty()) {
     printf("Error - no image files for video at path: %s\n", path.c_str());
@@ -83,47 +278,53 @@ void Video::LoadAnnotation(const int annotation_index,
   }
 
   // Load the image corresponding to this annotation.
-  const string& image_file = video_path + "/" + image_files[*frame_num];
-  *image = cv::imread(image_file);
+  double scale;
+  LoadImage(*frame_num, image, &scale);
+  if (scale != 1) {
+    ScaleBox(scale, box);
+  }
 
   if (!image->data) {
+    string image_file;
+    GetImageFile(*frame_num, &image_file);
     printf("Could not find file: %s\n", image_file.c_str());
   }
 }
 
 bool Video::FindAnnotation(const int frame_num, BoundingBox* box) const {
-  // Iterate over all annotations.
-  for (size_t i = 0; i < annotations.size(); ++i) {
-    const Frame& frame = annotations[i];
-
-    // Check if the annotation frame matches the desired frame.
-    if (frame.frame_num == frame_num) {
-      // If we found a match, return the corresponding annotation.
-      *box = frame.bbox;
-      return true;
-    }
+  const int annotation_index = annotations.Find(frame_num);
+  if (annotation_index < 0) {
+    return false;
   }
 
-  return false;
+  // If we found a match, return the corresponding annotation.
+  *box = annotations[annotation_index].bbox;
+  return true;
 }
 
 bool Video::LoadFrame(const int frame_num, const bool draw_bounding_box,
                      const bool load_only_annotation, cv::Mat* image,
                      BoundingBox* box) const {
-  const string& video_path = path;
-  const vector<string>& image_files = all_frames;
-
   // Load the image for this frame.
+  double scale = 1;
   if (!load_only_annotation) {
-    const string& image_file = video_path + "/" + image_files[frame_num];
-    *image = cv::imread(image_file);
+    LoadImage(frame_num, image, &scale);
+  } else if (image_shards_ || image_cache_) {
+    scale = GetImageScale(frame_num);
   }
 
   // Find the annotation (if it exists) for the desired frame_num.
   const bool has_annotation = FindAnnotation(frame_num, box);
+  if (has_annotation && scale != 1) {
+    ScaleBox(scale, box);
+  }
 
   // Draw the annotation (if it exists) on the image.
   if (!load_only_annotation && has_annotation && draw_bounding_box) {
+    // Images from memory, the cache or the video file reader are shared, so draw on a copy.
+    if (images_ || image_cache_ || video_file_) {
+      *image = image->clone();
+    }
     box->DrawBoundingBox(image);
   }
 
@@ -1,7 +1,18 @@
 #ifndef VIDEO_H
 #define VIDEO_H
 
+#include <stdint.h>
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
 #include "helper/bounding_box.h"
+#include "loader/frame_list.h"
+
+class ImageCache;
+class ImageShards;
+class VideoFileReader;
 
 // An image frame and corresponding annotation.
 struct Frame {
@@ -9,9 +20,60 @@ struct Frame {
   BoundingBox bbox;
 };
 
+// Annotations stored column by column (e.g. in a memory-mapped file): annotation i
+// is of frame frame_nums[i], with the box (x1[i], y1[i], x2[i], y2[i]).
+// The frame numbers must be increasing.
+struct AnnotationColumns {
+  const int32_t* frame_nums;
+  const float* x1;
+  const float* y1;
+  const float* x2;
+  const float* y2;
+  size_t size;
+};
+
+// The annotations of a video, in order.  Like FrameList, the annotations cannot be
+// modified and copies share the same storage.  The annotation of a frame is found
+// in constant time (logarithmic time for annotations stored in columns).
+class FrameAnnotations
+{
+public:
+  // No annotations.
+  FrameAnnotations();
+
+  explicit FrameAnnotations(const std::vector<Frame>& frames);
+
+  // Use the annotations in the given columns, without copying them.
+  // The columns must stay valid for as long as storage (which owns them) is held.
+  FrameAnnotations(const AnnotationColumns& columns,
+                   const boost::shared_ptr<const void>& storage);
+
+  size_t size() const { return frames_ ? frames_->size() : columns_.size; }
+  bool empty() const { return size() == 0; }
+  Frame operator[](const size_t i) const;
+
+  // Get the index of the (first) annotation of the given frame number,
+  // or -1 if the frame is not annotated.
+  int Find(const int frame_num) const;
+
+private:
+  // Annotations stored as frames (NULL if they are stored in columns).
+  boost::shared_ptr<const std::vector<Frame> > frames_;
+
+  // For each frame number, the index of its first annotation, or -1 if the frame is not annotated.
+  boost::shared_ptr<const std::vector<int> > frame_annotations_;
+
+  // Annotations stored in columns, and the memory that holds them.
+  AnnotationColumns columns_;
+  boost::shared_ptr<const void> storage_;
+};
+
 // Container for video data and the corresponding frame annotations.
+// The frame names and annotations are shared between copies, so videos are cheap to copy.
 class Video {
 public:
+  Video();
+
   // For a given annotation index, get the corresponding frame number, image,
   // and bounding box.
   void LoadAnnotation(const int annotation_index, int* frame_num, cv::Mat* image,
@@ -31,29 +93,84 @@ public:
                 cv::Mat* image,
                 BoundingBox* box) const;
 
+  // Load the image of the given frame, decoded at 1 / reduction of the size of the
+  // image that LoadFrame loads (reduction is 1, 2, 4 or 8), and set scale to its
+  // size relative to that image.  Only image files read directly from disk can be
+  // decoded at a reduced size (JPEG files are then only partially decompressed);
+  // other frames are loaded at their usual size, with a scale of 1.
+  void LoadReducedImage(const int frame_num, const int reduction, cv::Mat* image,
+                        double* scale) const;
+
   // Show video with all annotations.
   void ShowVideo() const;
 
+  // Load the frames through the given cache of decoded images (which may be shared
+  // with other videos and threads), or directly from disk if image_cache is NULL.
+  // If the cache downscales the images, the annotations are scaled to match.
+  void set_image_cache(ImageCache* image_cache) { image_cache_ = image_cache; }
+
+  // Load the frames from packed shards when they are there (see loader/image_shards.h),
+  // scaling the annotations to match if the frames were downscaled when packed.
+  void set_image_shards(const ImageShards* image_shards) { image_shards_ = image_shards; }
+
+  // Read the frames from the given video file (frame i of the file is frame i of the
+  // video) instead of from image files.  If no frame names were given, all_frames
+  // is set to one name per frame of the file (used only to identify the frames).
+  void set_video_file(const std::string& video_file);
+
+  // Take the frames from memory (frame i is images[i]), e.g. for synthetic videos,
+  // so that loading them does no decoding.  The images are shared, not copied.
+  // If no frame names were given, all_frames is set to one name per image
+  // (used only to identify the frames).
+  void set_images(const boost::shared_ptr<const std::vector<cv::Mat> >& images);
+
   // Path to the folder containing the image files for this video.
   std::string path;
 
   // Name of all image files for this video (must be appended to path).
-  std::vector<std::string> all_frames;
+  FrameList all_frames;
 
   // Bounding box annotations for a subset of frames in this video.
-  // Note that the length of this vector may be different from the length of the vector of image filenames,
+  // Note that the number of annotations may be different from the number of image files,
   // if only a strict subset of video frames were labeled.
-  std::vector<Frame> annotations;
+  FrameAnnotations annotations;
 
 private:
   // For a given frame num, find an annotation if it exists, and return true.
   // Otherwise return false.
   bool FindAnnotation(const int frame_num, BoundingBox* box) const;
+
+  // Load the image file for the given frame number.
+  // scale is set to the size of the loaded image relative to the original image file
+  // (less than 1 if the frame was downscaled when packed into shards).
+  void LoadImage(const int frame_num, cv::Mat* image, double* scale) const;
+
+  // Get the scale of the image for the given frame number, without loading it.
+  // For a cache that downscales images, the scale is only known once the cache has
+  // decoded the image; before that, 1 is returned.
+  double GetImageScale(const int frame_num) const;
+
+  // Get the full path of the image file for the given frame number.
+  void GetImageFile(const int frame_num, std::string* image_file) const;
+
+  // Optional cache of decoded images (not owned).
+  ImageCache* image_cache_;
+
+  // Optional packed images (not owned).
+  const ImageShards* image_shards_;
+
+  // Reader for the video file that the frames come from (NULL for image files).
+  // Shared between copies of the video, so that they decode the file only once.
+  boost::shared_ptr<VideoFileReader> video_file_;
+
+  // Frames kept in memory (NULL for frames that are loaded from files).
+  boost::shared_ptr<const std::vector<cv::Mat> > images_;
 };
 
-// A collection of videos.
+// A collection of videos, stored consecutively in a list of videos.
 struct Category {
-  std::vector<Video> videos;
+  size_t first_video;
+  size_t num_videos;
 };
 
 #endif // VIDEO_H
@@ -0,0 +1,118 @@
+#include "video_file_reader.h"
+
+#include <boost/filesystem.hpp>
+
+#include "helper/metrics.h"
+
+using std::string;
+namespace bfs = boost::filesystem;
+
+namespace {
+
+// Containers that are recognized as videos.
+const char* const kVideoExtensions[] = { ".mp4", ".mkv", ".avi", ".mov" };
+
+// Number of recently decoded frames to keep.
+const size_t kNumRecentFrames = 16;
+
+// Frames up to this far ahead are reached by decoding forward instead of seeking
+// (seeking decodes from the previous keyframe anyway, so it only pays off for
+// frames more than about a group of pictures ahead).
+const int kMaxSkipFrames = 64;
+
+} // namespace
+
+VideoFileReader::VideoFileReader(const string& video_file)
+  : video_file_(video_file),
+    next_frame_(0)
+{
+}
+
+bool VideoFileReader::Open() {
+  if (capture_.isOpened()) {
+    return true;
+  }
+  next_frame_ = 0;
+  if (!capture_.open(video_file_)) {
+    printf("Error - could not open video %s\n", video_file_.c_str());
+    return false;
+  }
+  return true;
+}
+
+size_t VideoFileReader::GetNumFrames() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (capture_.isOpened()) {
+    const double num_frames = capture_.get(cv::CAP_PROP_FRAME_COUNT);
+    return num_frames > 0 ? static_cast<size_t>(num_frames) : 0;
+  }
+
+  // Only read the count from the container, and close the file again, so that loading
+  // a dataset does not keep a file and a decoder open for every video.
+  cv::VideoCapture capture;
+  if (!capture.open(video_file_)) {
+    printf("Error - could not open video %s\n", video_file_.c_str());
+    return 0;
+  }
+  const double num_frames = capture.get(cv::CAP_PROP_FRAME_COUNT);
+  capture.release();
+  return num_frames > 0 ? static_cast<size_t>(num_frames) : 0;
+}
+
+bool VideoFileReader::ReadFrame(const int frame_num, cv::Mat* image) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (size_t i = 0; i < recent_frames_.size(); ++i) {
+    if (recent_frames_[i].first == frame_num) {
+      *image = recent_frames_[i].second;
+      return true;
+    }
+  }
+
+  if (frame_num < 0 || !Open()) {
+    return false;
+  }
+
+  // Seek only if the frame is behind or far ahead of the decoder.
+  if (frame_num < next_frame_ || frame_num > next_frame_ + kMaxSkipFrames) {
+    if (!capture_.set(cv::CAP_PROP_POS_FRAMES, frame_num)) {
+      printf("Error - could not seek to frame %d of %s\n", frame_num, video_file_.c_str());
+      return false;
+    }
+    next_frame_ = frame_num;
+  }
+
+  // Decode forward to the frame, skipping the conversion of the frames in between.
+  while (next_frame_ < frame_num) {
+    if (!capture_.grab()) {
+      return false;
+    }
+    next_frame_++;
+  }
+
+  cv::Mat frame;
+  if (!capture_.read(frame) || !frame.data) {
+    return false;
+  }
+  next_frame_++;
+  CountDecodedImage(frame.total() * frame.elemSize());
+
+  recent_frames_.push_back(std::make_pair(frame_num, frame));
+  if (recent_frames_.size() > kNumRecentFrames) {
+    recent_frames_.pop_front();
+  }
+
+  *image = frame;
+  return true;
+}
+
+bool FindVideoFile(const string& frames_folder, string* video_file) {
+  for (size_t i = 0; i < sizeof(kVideoExtensions) / sizeof(kVideoExtensions[0]); ++i) {
+    const string& file = frames_folder + kVideoExtensions[i];
+    if (bfs::is_regular_file(file)) {
+      *video_file = file;
+      return true;
+    }
+  }
+  return false;
+}
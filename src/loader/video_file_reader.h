@@ -0,0 +1,56 @@
+#ifndef VIDEO_FILE_READER_H
+#define VIDEO_FILE_READER_H
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+// Reads the frames of a video file (e.g. H.264 in an MP4 or MKV container) through
+// cv::VideoCapture, as an alternative to a folder of image files.
+// Reading frames in increasing order decodes forward without seeking; reading a frame
+// far from the last one seeks (the decoder restarts from the nearest keyframe before it).
+// The most recently decoded frames are kept, so that reading nearby frames again
+// (e.g. pairs of frames for training) does not decode them again.
+// Thread-safe; the frames of one file are decoded one at a time.
+class VideoFileReader
+{
+public:
+  // The file is opened when the first frame is read.
+  VideoFileReader(const std::string& video_file);
+
+  // Number of frames in the file, according to the container.  If the file is not open
+  // for reading frames yet, it is opened only to read the count, and closed again.
+  size_t GetNumFrames();
+
+  // Decode the given frame (numbered from 0).  Returns false if it cannot be read.
+  // The returned image may be shared with the reader, so it must not be modified.
+  bool ReadFrame(const int frame_num, cv::Mat* image);
+
+  const std::string& get_video_file() const { return video_file_; }
+
+private:
+  // Open the file if it is not open.  Returns false if it cannot be opened.
+  bool Open();
+
+  std::string video_file_;
+  cv::VideoCapture capture_;
+
+  // Frame that capture_ will decode next.
+  int next_frame_;
+
+  // Most recently decoded frames (frame number, image), the most recent last.
+  std::deque<std::pair<int, cv::Mat> > recent_frames_;
+
+  // Protects all of the above.
+  std::mutex mutex_;
+};
+
+// Look for a video file that replaces the folder of image files frames_folder
+// (i.e. frames_folder + ".mp4", ".mkv", ...).  Returns false if there is none.
+bool FindVideoFile(const std::string& frames_folder, std::string* video_file);
+
+#endif // VIDEO_FILE_READER_H
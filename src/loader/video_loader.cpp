@@ -7,6 +7,7 @@
 #include "helper/helper.h"
 #include "helper/high_res_timer.h"
 #include "helper/image_proc.h"
+#include "helper/rng.h"
 #include "loader/loader_alov.h"
 #include "loader/loader_vot.h"
 #include "loader/loader_imagenet_det.h"
@@ -16,6 +17,10 @@ using std::string;
 using std::vector;
 namespace bfs = boost::filesystem;
 
+// Fixed seed for the random examples shown by the visualizations,
+// so that the same examples are shown on every run.
+const int kShowRandomSeed = 0;
+
 VideoLoader::VideoLoader() {
 }
 
@@ -44,7 +49,7 @@ void VideoLoader::ShowVideosShift() const {
     const string& video_path = video.path;
     printf("Showing video %zu: %s\n", video_index, video_path.c_str());
 
-    const std::vector<Frame>& annotations = video.annotations;
+    const FrameAnnotations& annotations = video.annotations;
 
     BoundingBox bbox_prev;
     cv::Mat image_prev;
@@ -53,10 +58,11 @@ void VideoLoader::ShowVideosShift() const {
     // This will be used to artificially shift the crops around the annotations, creating an
     // apparent motion (via translation and scale change).
     ExampleGenerator example_generator(1, 5, -0.4, 0.4);
+    Rng rng(kShowRandomSeed);
 
     // Iterate over all annotations.
     for (size_t frame_index = 0; frame_index < annotations.size(); ++frame_index) {
-      const Frame& frame = annotations[frame_index];
+      const Frame frame = annotations[frame_index];
 
       // Load image and bounding box.
       cv::Mat raw_image;
@@ -90,7 +96,7 @@ void VideoLoader::ShowVideosShift() const {
 
         for (int k = 0; k < kNumGeneratedExamples; ++k) {
           // Shift the cropped region to generate an apparent motion (translation and scale change) and visualize.
-          example_generator.MakeTrainingExampleBBShift(visualize, &image_rand_focus,
+          example_generator.MakeTrainingExampleBBShift(visualize, &rng, &image_rand_focus,
                                                        &target_pad, &bbox_gt_scaled);
         }
       }
@@ -26,7 +26,7 @@ public:
   // artificially shifted training data).
   void ShowVideosShift() const;
 
-  std::vector<Video> get_videos() const { return videos_; }
+  const std::vector<Video>& get_videos() const { return videos_; }
 
 protected:
   std::vector<Video> videos_;
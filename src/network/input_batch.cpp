@@ -0,0 +1,103 @@
+#include "input_batch.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+// Number of values per bounding box.
+const int kBBoxDims = 4;
+
+void GetInputMean(const cv::Size& input_geometry, cv::Mat* mean) {
+  // Set the mean image.
+  *mean = cv::Mat(input_geometry, CV_32FC3, cv::Scalar(104, 117, 123));
+}
+
+void PreprocessInput(const cv::Mat& img, const int num_channels,
+                     const cv::Size& input_geometry, const cv::Mat& mean,
+                     std::vector<cv::Mat>* input_channels) {
+  // Convert the input image to the input image format of the network.
+  cv::Mat sample;
+  if (img.channels() == 3 && num_channels == 1)
+    cv::cvtColor(img, sample, CV_BGR2GRAY);
+  else if (img.channels() == 4 && num_channels == 1)
+    cv::cvtColor(img, sample, CV_BGRA2GRAY);
+  else if (img.channels() == 4 && num_channels == 3)
+    cv::cvtColor(img, sample, CV_BGRA2BGR);
+  else if (img.channels() == 1 && num_channels == 3)
+    cv::cvtColor(img, sample, CV_GRAY2BGR);
+  else
+    sample = img;
+
+  // Convert the input image to the expected size.
+  cv::Mat sample_resized;
+  if (sample.size() != input_geometry)
+    cv::resize(sample, sample_resized, input_geometry);
+  else
+    sample_resized = sample;
+
+  // Convert the input image to the expected number of channels.
+  cv::Mat sample_float;
+  if (num_channels == 3)
+    sample_resized.convertTo(sample_float, CV_32FC3);
+  else
+    sample_resized.convertTo(sample_float, CV_32FC1);
+
+  // Subtract the image mean to try to make the input 0-mean.
+  cv::Mat sample_normalized;
+  cv::subtract(sample_float, mean, sample_normalized);
+
+  // This operation will write the separate BGR planes directly to the
+  // memory wrapped by the cv::Mat objects in input_channels.
+  cv::split(sample_normalized, *input_channels);
+}
+
+InputBatch::InputBatch(const int batch_size, const int num_channels,
+                       const cv::Size& input_geometry)
+  : batch_size_(batch_size),
+    num_channels_(num_channels),
+    input_geometry_(input_geometry),
+    images_(batch_size * num_channels * input_geometry.area()),
+    targets_(batch_size * num_channels * input_geometry.area()),
+    bboxes_gt_(batch_size * kBBoxDims),
+    num_examples_(0)
+{
+  GetInputMean(input_geometry_, &mean_);
+}
+
+void InputBatch::WrapSlot(const int slot, std::vector<float>* data,
+                          std::vector<cv::Mat>* channels) const {
+  const int channel_size = input_geometry_.area();
+  float* slot_data = &(*data)[slot * num_channels_ * channel_size];
+  for (int i = 0; i < num_channels_; ++i) {
+    cv::Mat channel(input_geometry_.height, input_geometry_.width, CV_32FC1, slot_data);
+    channels->push_back(channel);
+    slot_data += channel_size;
+  }
+}
+
+void InputBatch::Add(const cv::Mat& image, const cv::Mat& target,
+                     const BoundingBox& bbox_gt_scaled) {
+  if (is_full()) {
+    printf("Error - adding an example to a full batch of %d\n", batch_size_);
+    return;
+  }
+
+  const int slot = num_examples_;
+
+  // Convert the image and the target directly into their slots.
+  std::vector<cv::Mat> image_channels;
+  WrapSlot(slot, &images_, &image_channels);
+  PreprocessInput(image, num_channels_, input_geometry_, mean_, &image_channels);
+
+  std::vector<cv::Mat> target_channels;
+  WrapSlot(slot, &targets_, &target_channels);
+  PreprocessInput(target, num_channels_, input_geometry_, mean_, &target_channels);
+
+  // Set the ground-truth bounding box.
+  std::vector<float> bbox_vect;
+  bbox_gt_scaled.GetVector(&bbox_vect);
+  std::copy(bbox_vect.begin(), bbox_vect.end(), bboxes_gt_.begin() + slot * kBBoxDims);
+
+  num_examples_++;
+}
@@ -0,0 +1,65 @@
+#ifndef INPUT_BATCH_H
+#define INPUT_BATCH_H
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "helper/bounding_box.h"
+
+// Get the mean image, which is subtracted from the network inputs.
+void GetInputMean(const cv::Size& input_geometry, cv::Mat* mean);
+
+// Convert img to the input format of the network (num_channels channels of size
+// input_geometry, as 0-mean floats) and write each channel to input_channels,
+// which normally wrap the memory of the network input.
+void PreprocessInput(const cv::Mat& img, const int num_channels,
+                     const cv::Size& input_geometry, const cv::Mat& mean,
+                     std::vector<cv::Mat>* input_channels);
+
+// A batch of training examples, stored in the layout of the network input blobs
+// (example x channel x row x column, 0-mean floats).  Each example is converted
+// into its slot as soon as it is added, so the network can train on the batch
+// without any further preprocessing.
+class InputBatch
+{
+public:
+  InputBatch(const int batch_size, const int num_channels, const cv::Size& input_geometry);
+
+  // Convert the example to the network input format and store it in the next slot.
+  void Add(const cv::Mat& image, const cv::Mat& target, const BoundingBox& bbox_gt_scaled);
+
+  // Empty the batch, keeping its memory for the next examples.
+  void Clear() { num_examples_ = 0; }
+
+  bool is_full() const { return num_examples_ == batch_size_; }
+  int get_num_examples() const { return num_examples_; }
+  int get_batch_size() const { return batch_size_; }
+
+  // Network input data for the images, the targets, and the ground-truth
+  // bounding boxes (4 values per example).
+  const float* get_images() const { return &images_[0]; }
+  const float* get_targets() const { return &targets_[0]; }
+  const float* get_bboxes_gt() const { return &bboxes_gt_[0]; }
+
+private:
+  // Wrap each channel of the given slot of data in a cv::Mat.
+  void WrapSlot(const int slot, std::vector<float>* data,
+                std::vector<cv::Mat>* channels) const;
+
+  int batch_size_;
+  int num_channels_;
+  cv::Size input_geometry_;
+
+  // Mean image, used to make the input 0-mean.
+  cv::Mat mean_;
+
+  std::vector<float> images_;
+  std::vector<float> targets_;
+  std::vector<float> bboxes_gt_;
+
+  // Number of slots filled so far.
+  int num_examples_;
+};
+
+#endif // INPUT_BATCH_H
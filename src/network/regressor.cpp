@@ -1,6 +1,9 @@
 #include "regressor.h"
 
 #include "helper/high_res_timer.h"
+#include "helper/metrics.h"
+#include "helper/profiler.h"
+#include "network/input_batch.h"
 
 // Credits:
 // This file was mostly taken from:
@@ -82,7 +85,7 @@ void Regressor::SetupNetwork(const string& deploy_proto,
 
 void Regressor::SetMean() {
   // Set the mean image.
-  mean_ = cv::Mat(input_geometry_, CV_32FC3, cv::Scalar(104, 117, 123));
+  GetInputMean(input_geometry_, &mean_);
 }
 
 void Regressor::Init() {
@@ -107,6 +110,10 @@ void Regressor::Regress(const cv::Mat& image_curr,
 }
 
 void Regressor::Estimate(const cv::Mat& image, const cv::Mat& target, std::vector<float>* output) {
+  PROFILE_ZONE("Estimate");
+  static Counter* forwards = MetricsRegistry::Get()->GetCounter(
+      "goturn_regressor_forwards_total", "Forward passes of the tracking network.");
+  forwards->Increment();
   assert(net_->phase() == caffe::TEST);
 
   // Reshape the input blobs to be the appropriate size.
@@ -196,6 +203,14 @@ void Regressor::SetImages(const std::vector<cv::Mat>& images,
 void Regressor::Estimate(const std::vector<cv::Mat>& images,
                         const std::vector<cv::Mat>& targets,
                         std::vector<float>* output) {
+  PROFILE_ZONE("EstimateBatch");
+  static Counter* forwards = MetricsRegistry::Get()->GetCounter(
+      "goturn_regressor_forwards_total", "Forward passes of the tracking network.");
+  static Histogram* batch_sizes = MetricsRegistry::Get()->GetHistogram(
+      "goturn_regressor_batch_size", "Examples in each batched forward pass.",
+      Histogram::PowerOfTwoBuckets(1024));
+  forwards->Increment();
+  batch_sizes->Observe(images.size());
   assert(net_->phase() == caffe::TEST);
 
   // Set the inputs to the network.
@@ -283,90 +298,15 @@ void Regressor::WrapInputLayer(const size_t num_images,
 
 void Regressor::Preprocess(const cv::Mat& img,
                             std::vector<cv::Mat>* input_channels) {
-  // Convert the input image to the input image format of the network.
-  cv::Mat sample;
-  if (img.channels() == 3 && num_channels_ == 1)
-    cv::cvtColor(img, sample, CV_BGR2GRAY);
-  else if (img.channels() == 4 && num_channels_ == 1)
-    cv::cvtColor(img, sample, CV_BGRA2GRAY);
-  else if (img.channels() == 4 && num_channels_ == 3)
-    cv::cvtColor(img, sample, CV_BGRA2BGR);
-  else if (img.channels() == 1 && num_channels_ == 3)
-    cv::cvtColor(img, sample, CV_GRAY2BGR);
-  else
-    sample = img;
-
-  // Convert the input image to the expected size.
-  cv::Mat sample_resized;
-  if (sample.size() != input_geometry_)
-    cv::resize(sample, sample_resized, input_geometry_);
-  else
-    sample_resized = sample;
-
-  // Convert the input image to the expected number of channels.
-  cv::Mat sample_float;
-  if (num_channels_ == 3)
-    sample_resized.convertTo(sample_float, CV_32FC3);
-  else
-    sample_resized.convertTo(sample_float, CV_32FC1);
-
-  // Subtract the image mean to try to make the input 0-mean.
-  cv::Mat sample_normalized;
-  cv::subtract(sample_float, mean_, sample_normalized);
-
-  // This operation will write the separate BGR planes directly to the
-  // input layer of the network because it is wrapped by the cv::Mat
-  // objects in input_channels.
-  cv::split(sample_normalized, *input_channels);
-
-  /*CHECK(reinterpret_cast<float*>(input_channels->at(0).data)
-        == net_->input_blobs()[0]->cpu_data())
-    << "Input channels are not wrapping the input layer of the network.";*/
+  // Convert the input image to the input format of the network, writing the
+  // separate BGR planes directly to the input layer of the network (which is
+  // wrapped by the cv::Mat objects in input_channels).
+  PreprocessInput(img, num_channels_, input_geometry_, mean_, input_channels);
 }
 
 void Regressor::Preprocess(const std::vector<cv::Mat>& images,
                            std::vector<std::vector<cv::Mat> >* input_channels) {
   for (size_t i = 0; i < images.size(); ++i) {
-    const cv::Mat& img = images[i];
-
-    // Convert the input image to the input image format of the network.
-    cv::Mat sample;
-    if (img.channels() == 3 && num_channels_ == 1)
-      cv::cvtColor(img, sample, CV_BGR2GRAY);
-    else if (img.channels() == 4 && num_channels_ == 1)
-      cv::cvtColor(img, sample, CV_BGRA2GRAY);
-    else if (img.channels() == 4 && num_channels_ == 3)
-      cv::cvtColor(img, sample, CV_BGRA2BGR);
-    else if (img.channels() == 1 && num_channels_ == 3)
-      cv::cvtColor(img, sample, CV_GRAY2BGR);
-    else
-      sample = img;
-
-    // Convert the input image to the expected size.
-    cv::Mat sample_resized;
-    if (sample.size() != input_geometry_)
-      cv::resize(sample, sample_resized, input_geometry_);
-    else
-      sample_resized = sample;
-
-    // Convert the input image to the expected number of channels.
-    cv::Mat sample_float;
-    if (num_channels_ == 3)
-      sample_resized.convertTo(sample_float, CV_32FC3);
-    else
-      sample_resized.convertTo(sample_float, CV_32FC1);
-
-    // Subtract the image mean to try to make the input 0-mean.
-    cv::Mat sample_normalized;
-    cv::subtract(sample_float, mean_, sample_normalized);
-
-    // This operation will write the separate BGR planes directly to the
-    // input layer of the network because it is wrapped by the cv::Mat
-    // objects in input_channels.
-    cv::split(sample_normalized, (*input_channels)[i]);
-
-    /*CHECK(reinterpret_cast<float*>(input_channels->at(0).data)
-          == net_->input_blobs()[0]->cpu_data())
-      << "Input channels are not wrapping the input layer of the network.";*/
+    Preprocess(images[i], &(*input_channels)[i]);
   }
 }
@@ -37,6 +37,12 @@ class Regressor : public RegressorBase {
   // Returns: bbox, an estimated location of the target object in the current image.
   virtual void Regress(const cv::Mat& image_curr, const cv::Mat& image, const cv::Mat& target, BoundingBox* bbox);
 
+  // Number of channels and size of the input images.
+  int get_num_channels() const { return num_channels_; }
+  const cv::Size& get_input_geometry() const { return input_geometry_; }
+
+  virtual cv::Size get_input_size() const { return input_geometry_; }
+
 protected:
   // Set the network inputs.
   void SetImages(const std::vector<cv::Mat>& images,
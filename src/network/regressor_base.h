@@ -26,6 +26,10 @@ public:
   // Called at the beginning of tracking a new object to initialize the network.
   virtual void Init() { }
 
+  // Size of the images that the network takes as input, if the inputs are resized
+  // to a fixed size (empty otherwise).  Crops can be made at this size directly.
+  virtual cv::Size get_input_size() const { return cv::Size(); }
+
   //virtual boost::shared_ptr<caffe::Net<float> > get_net() { return net_; }
 
 protected:
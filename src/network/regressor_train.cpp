@@ -1,5 +1,8 @@
 #include "regressor_train.h"
 
+#include "helper/high_res_timer.h"
+#include "helper/profiler.h"
+
 const int kNumInputs = 3;
 const bool kDoTrain = true;
 
@@ -87,10 +90,54 @@ void RegressorTrain::Train(const std::vector<cv::Mat>& images,
   Step();
 }
 
+void RegressorTrain::Train(const InputBatch& batch) {
+  assert(net_->phase() == caffe::TRAIN);
+
+  if (!batch.is_full()) {
+    printf("Error - training on a batch with %d of %d examples\n",
+           batch.get_num_examples(), batch.get_batch_size());
+  }
+
+  const size_t num_images = batch.get_num_examples();
+
+  // Set network inputs to the appropriate size and number.
+  ReshapeImageInputs(num_images);
+  Blob<float>* input_bbox = net_->input_blobs()[2];
+  vector<int> shape;
+  shape.push_back(num_images);
+  shape.push_back(4);
+  input_bbox->Reshape(shape);
+
+  // The batch is already in the layout of the input blobs, so it only needs
+  // to be copied in (as the Caffe prefetching data layers do).
+  HighResTimer hrt_copy("Copy", CLOCK_MONOTONIC);
+  hrt_copy.start();
+  Blob<float>* input_target = net_->input_blobs()[0];
+  Blob<float>* input_image = net_->input_blobs()[1];
+  caffe::caffe_copy(input_target->count(), batch.get_targets(), input_target->mutable_cpu_data());
+  caffe::caffe_copy(input_image->count(), batch.get_images(), input_image->mutable_cpu_data());
+  caffe::caffe_copy(input_bbox->count(), batch.get_bboxes_gt(), input_bbox->mutable_cpu_data());
+  hrt_copy.stop();
+  copy_seconds_ += hrt_copy.getSeconds();
+
+  // Train the network.
+  Step();
+}
+
+void RegressorTrain::GetInputShape(int* num_channels, cv::Size* input_geometry) const {
+  *num_channels = get_num_channels();
+  *input_geometry = get_input_geometry();
+}
+
 void RegressorTrain::Step() {
+  PROFILE_ZONE("SolverStep");
   assert(net_->phase() == caffe::TRAIN);
 
   // Train the network.
+  HighResTimer hrt_step("Step", CLOCK_MONOTONIC);
+  hrt_step.start();
   solver_.Step(1);
+  hrt_step.stop();
+  step_seconds_ += hrt_step.getSeconds();
 }
 
@@ -23,6 +23,12 @@ public:
                              const std::vector<cv::Mat>& targets,
                              const std::vector<BoundingBox>& bboxes_gt);
 
+  // Train the tracker on a batch that is already in the network input format.
+  // The batch is copied into the network inputs as is, without any preprocessing.
+  void Train(const InputBatch& batch);
+
+  void GetInputShape(int* num_channels, cv::Size* input_geometry) const;
+
   // Set up the solver with the given test file for validation testing.
   void set_test_net(const std::string& test_proto);
 
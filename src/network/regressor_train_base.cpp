@@ -1,10 +1,30 @@
 #include "regressor_train_base.h"
 
+#include "helper/high_res_timer.h"
+
 MySolver::MySolver(const std::string& param_file)
-  : SGDSolver(param_file) {
+  : SGDSolver(param_file),
+    update_seconds_(0) {
+}
+
+void MySolver::ApplyUpdate() {
+  HighResTimer hrt_update("Update", CLOCK_MONOTONIC);
+  hrt_update.start();
+  SGDSolver::ApplyUpdate();
+  hrt_update.stop();
+  update_seconds_ += hrt_update.getSeconds();
 }
 
 RegressorTrainBase::RegressorTrainBase(const std::string& solver_file)
-  : solver_(solver_file)
+  : solver_(solver_file),
+    copy_seconds_(0),
+    step_seconds_(0)
 {
 }
+
+void RegressorTrainBase::GetTrainTimes(double* copy_seconds, double* forward_backward_seconds,
+                                       double* update_seconds) const {
+  *copy_seconds = copy_seconds_;
+  *update_seconds = solver_.get_update_seconds();
+  *forward_backward_seconds = step_seconds_ - *update_seconds;
+}
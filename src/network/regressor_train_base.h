@@ -11,6 +11,7 @@
 #include <caffe/sgd_solvers.hpp>
 
 #include "helper/bounding_box.h"
+#include "network/input_batch.h"
 #include "network/regressor_base.h"
 
 // We subclass the Caffe solver object so that we can set protected variables like net_ and test_nets_.
@@ -26,6 +27,16 @@ public:
   void set_test_net(const boost::shared_ptr<caffe::Net<float> >& net) {
     test_nets_[0] = net;
   }
+
+  // Apply the update to the weights, timing it.
+  virtual void ApplyUpdate();
+
+  // Total time spent applying updates.  (On the GPU, the update only waits for the
+  // kernels to be launched; the rest of its time is counted in the next forward pass.)
+  double get_update_seconds() const { return update_seconds_; }
+
+private:
+  double update_seconds_;
 };
 
 // The class used to train the tracker should inherit from this class.
@@ -39,8 +50,24 @@ public:
              const std::vector<cv::Mat>& targets,
              const std::vector<BoundingBox>& bboxes_gt) = 0;
 
+  // Train the tracker on a batch that is already in the network input format.
+  virtual void Train(const InputBatch& batch) = 0;
+
+  // Get the shape of the network inputs, for building an InputBatch.
+  virtual void GetInputShape(int* num_channels, cv::Size* input_geometry) const = 0;
+
+  // Get the total time spent copying the batches into the network inputs, in the
+  // forward and backward passes (with the rest of the solver step), and in applying
+  // the updates.
+  void GetTrainTimes(double* copy_seconds, double* forward_backward_seconds,
+                     double* update_seconds) const;
+
 protected:
   MySolver solver_;
+
+  // Total time spent copying batches into the network inputs and in solver steps.
+  double copy_seconds_;
+  double step_seconds_;
 };
 
 #endif // REGRESSOR_TRAIN_BASE_H
@@ -0,0 +1,73 @@
+// Check that a candidate (optimized) path through the tracker gives the same
+// results as the reference path, up to the thresholds in ParityThresholds.
+// Without a videos folder, runs on a small synthetic video (generated in memory)
+// so that no dataset is needed.
+// Exits with status 1 if any video fails.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "evaluate/parity_checker.h"
+#include "loader/loader_vot.h"
+#include "loader/synthetic_video.h"
+#include "network/regressor.h"
+
+using std::string;
+
+// Length of the synthetic video.
+const int kNumSyntheticFrames = 30;
+
+int main (int argc, char *argv[]) {
+  if (argc < 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " reference.prototxt reference.caffemodel"
+              << " candidate.prototxt candidate.caffemodel"
+              << " [candidate_batched] [vot_videos_folder|synthetic] [gpu_id]" << std::endl;
+    return 1;
+  }
+
+  ::google::InitGoogleLogging(argv[0]);
+
+  ParityPath reference;
+  reference.deploy_proto = argv[1];
+  reference.caffe_model  = argv[2];
+
+  ParityPath candidate;
+  candidate.deploy_proto = argv[3];
+  candidate.caffe_model  = argv[4];
+  if (argc >= 6) {
+    candidate.batched = atoi(argv[5]) != 0;
+  }
+
+  string videos_folder = "synthetic";
+  if (argc >= 7) {
+    videos_folder = argv[6];
+  }
+
+  int gpu_id = 0;
+  if (argc >= 8) {
+    gpu_id = atoi(argv[7]);
+  }
+
+  // Get videos.
+  std::vector<Video> videos;
+  if (videos_folder == "synthetic") {
+    SyntheticVideoOptions options;
+    options.num_frames = kNumSyntheticFrames;
+    Video video;
+    MakeSyntheticVideo(options, "synthetic", &video);
+    videos.push_back(video);
+  } else {
+    LoaderVOT loader(videos_folder);
+    videos = loader.get_videos();
+  }
+
+  ParityChecker checker(reference, candidate, gpu_id, ParityThresholds());
+  std::vector<ParityVideoResult> results;
+  const bool passed = checker.CheckAll(videos, &results);
+  checker.PrintResults(results);
+
+  return passed ? 0 : 1;
+}
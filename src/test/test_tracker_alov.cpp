@@ -8,19 +8,28 @@
 #include <opencv2/highgui/highgui.hpp>
 
 #include "helper/high_res_timer.h"
+#include "helper/profiler.h"
 #include "network/regressor.h"
 #include "loader/loader_alov.h"
 #include "loader/loader_vot.h"
+#include "loader/synthetic_video.h"
 #include "tracker/tracker.h"
 #include "tracker/tracker_manager.h"
 
 using std::string;
 
+// Number of videos to track when videos_folder is "synthetic".
+const int kNumSyntheticVideos = 10;
+
 int main (int argc, char *argv[]) {
   if (argc < 9) {
     std::cerr << "Usage: " << argv[0]
               << " videos_folder annotations_folder deploy.prototxt network.caffemodel"
-              << " outputfolder use_train save_videos gpu_id" << std::endl;
+              << " outputfolder use_train save_videos gpu_id [realtime_fps] [adaptive_decode]"
+              << " [trace_file]"
+              << std::endl;
+    std::cerr << "(With videos_folder \"synthetic\", tracks synthetic videos generated in memory,"
+              << " and annotations_folder is ignored.)" << std::endl;
     return 1;
   }
 
@@ -35,6 +44,31 @@ int main (int argc, char *argv[]) {
   const bool save_videos        = atoi(argv[7]);
   int gpu_id                    = atoi(argv[8]);
 
+  // If set, replay the videos as a live camera at this frame rate, dropping the
+  // frames that arrive while the tracker is busy (0 to track every frame).
+  double realtime_fps = 0;
+  if (argc >= 10) {
+    realtime_fps = atof(argv[9]);
+  }
+
+  // If set, decode the frames at a reduced resolution when the target is large
+  // (not with save_videos, which needs the full frames).
+  bool adaptive_decode = false;
+  if (argc >= 11) {
+    adaptive_decode = atoi(argv[10]);
+  }
+
+  // If set, profile the tracking and write a Chrome trace to this file.
+  string trace_file;
+  if (argc >= 12) {
+    trace_file = argv[11];
+  }
+
+  if (adaptive_decode && save_videos) {
+    printf("Saving videos - decoding the frames at full resolution\n");
+    adaptive_decode = false;
+  }
+
   boost::filesystem::create_directories(output_folder);
 
   const bool do_train = false;
@@ -46,8 +80,13 @@ int main (int argc, char *argv[]) {
 
   // Get videos.
   std::vector<Video> videos;
-  LoaderAlov loader(videos_folder, annotations_folder);
-  loader.get_videos(use_train, &videos);
+  const bool synthetic = videos_folder == "synthetic";
+  if (synthetic) {
+    MakeSyntheticVideos(SyntheticVideoOptions(), kNumSyntheticVideos, &videos);
+  } else {
+    LoaderAlov loader(videos_folder, annotations_folder);
+    loader.get_videos(use_train, &videos);
+  }
 
   // Create a tracker object.
   const bool show_intermediate_output = false;
@@ -55,11 +94,29 @@ int main (int argc, char *argv[]) {
 
   // Track all objects in all videos.
   TrackerTesterAlov tracker_tester(videos, save_videos, &regressor, &tracker, output_folder);
-  tracker_tester.TrackAll();
+
+  // Compute the F-scores after tracking (from the annotation files).
+  if (!synthetic) {
+    tracker_tester.set_annotations_folder(annotations_folder);
+  }
+  tracker_tester.set_adaptive_decode(adaptive_decode);
+  if (!trace_file.empty()) {
+    Profiler::Enable();
+  }
+  if (realtime_fps > 0) {
+    tracker_tester.TrackAllRealTime(realtime_fps);
+  } else {
+    tracker_tester.TrackAll();
+  }
 
   // Print the timing information.
   hrt_total.stop();
   hrt_total.print();
 
+  if (!trace_file.empty()) {
+    Profiler::PrintStats();
+    Profiler::WriteChromeTrace(trace_file);
+  }
+
   return 0;
 }
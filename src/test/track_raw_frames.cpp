@@ -0,0 +1,278 @@
+// Track an object in raw video frames read from stdin or a named pipe, e.g. as written by
+//   ffmpeg -i video.mp4 -f rawvideo -pix_fmt bgr24 -
+// so that the tracker can be plugged into an existing decode pipeline without
+// writing (or decoding) any image files.
+//
+// Input: one text line with the initial box "x y width height" (separated by spaces
+// or commas), followed by the raw frames, each exactly one frame in size.
+// Output (to stdout): the box of each frame, starting with the initial box of the
+// first frame, either as a text line "frame_num x y width height" or, in binary
+// mode, as an int32 frame number followed by 4 float32s (x, y, width, height).
+// Everything else the program prints goes to stderr.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "helper/bounding_box.h"
+#include "helper/image_proc.h"
+#include "helper/metrics.h"
+#include "network/regressor.h"
+#include "tracker/tracker.h"
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// How often to rewrite the metrics file.
+const double kMetricsIntervalSeconds = 1;
+
+enum PixelFormat {
+  kBGR24,
+  kNV12,
+  kI420
+};
+
+// Reads raw frames of a fixed format and size.
+class RawFrameReader
+{
+public:
+  // stride is the number of bytes per row (of the luma plane for NV12 / I420);
+  // the chroma planes of I420 have half of that stride.
+  RawFrameReader(FILE* input, const PixelFormat format, const int width, const int height,
+                 const size_t stride)
+    : input_(input),
+      format_(format),
+      width_(width),
+      height_(height),
+      stride_(stride),
+      num_frames_(0)
+  {
+    const size_t frame_bytes = format == kBGR24 ? stride * height : stride * height * 3 / 2;
+    for (int i = 0; i < 2; ++i) {
+      buffers_[i].resize(frame_bytes);
+    }
+  }
+
+  // Read the next frame, into image for BGR input and into yuv_image otherwise.
+  // Returns false at the end of the input.
+  // Both wrap the frame in place, without conversion (the tracker converts only the
+  // pixels that it crops).  The tracker keeps the previous frame, so the frames alternate
+  // between two buffers, and each frame stays valid until the next-but-one frame is read.
+  bool ReadFrame(cv::Mat* image, YuvImage* yuv_image) {
+    const int index = num_frames_ % 2;
+    vector<uchar>& buffer = buffers_[index];
+    if (fread(&buffer[0], 1, buffer.size(), input_) != buffer.size()) {
+      return false;
+    }
+    num_frames_++;
+
+    if (format_ == kBGR24) {
+      *image = cv::Mat(height_, width_, CV_8UC3, &buffer[0], stride_);
+    } else if (format_ == kNV12) {
+      WrapNV12(&buffer[0], width_, height_, stride_, yuv_image);
+    } else {
+      WrapI420(&buffer[0], width_, height_, stride_, yuv_image);
+    }
+    return true;
+  }
+
+  int get_num_frames() const { return num_frames_; }
+
+private:
+  FILE* input_;
+  PixelFormat format_;
+  int width_;
+  int height_;
+  size_t stride_;
+  int num_frames_;
+
+  // Raw frames.
+  vector<uchar> buffers_[2];
+};
+
+// Read the initial box from the first line of the input.
+bool ReadInitialBox(FILE* input, BoundingBox* bbox) {
+  // Read byte by byte, so that the frames that follow stay in the stream.
+  string line;
+  int c;
+  while ((c = fgetc(input)) != EOF && c != '\n') {
+    line.push_back(c == ',' ? ' ' : c);
+  }
+
+  double x, y, width, height;
+  if (sscanf(line.c_str(), "%lf %lf %lf %lf", &x, &y, &width, &height) != 4) {
+    return false;
+  }
+  bbox->x1_ = x;
+  bbox->y1_ = y;
+  bbox->x2_ = x + width;
+  bbox->y2_ = y + height;
+  return true;
+}
+
+void WriteBox(const int frame_num, const BoundingBox& bbox, const bool binary, FILE* output) {
+  const float x = bbox.x1_;
+  const float y = bbox.y1_;
+  const float width = bbox.get_width();
+  const float height = bbox.get_height();
+  if (binary) {
+    const int32_t frame = frame_num;
+    fwrite(&frame, sizeof(frame), 1, output);
+    fwrite(&x, sizeof(x), 1, output);
+    fwrite(&y, sizeof(y), 1, output);
+    fwrite(&width, sizeof(width), 1, output);
+    fwrite(&height, sizeof(height), 1, output);
+  } else {
+    fprintf(output, "%d %.2f %.2f %.2f %.2f\n", frame_num, x, y, width, height);
+  }
+
+  // Report each box as soon as it is known.
+  fflush(output);
+}
+
+} // namespace
+
+int main (int argc, char *argv[]) {
+  if (argc < 5) {
+    std::cerr << "Usage: " << argv[0]
+              << " deploy.prototxt network.caffemodel width height"
+              << " [bgr24|nv12|i420] [stride] [gpu_id] [input] [text|binary]"
+              << " [metrics_file|unix:socket]" << std::endl;
+    std::cerr << "(input is a file or named pipe; stdin if omitted or -)" << std::endl;
+    return 1;
+  }
+
+  // Keep stdout for the boxes: anything else printed (e.g. by the network setup)
+  // goes to stderr instead.
+  FILE* output = fdopen(dup(STDOUT_FILENO), "w");
+  dup2(STDERR_FILENO, STDOUT_FILENO);
+
+  ::google::InitGoogleLogging(argv[0]);
+
+  int arg_index = 1;
+  const string& model_file   = argv[arg_index++];
+  const string& trained_file = argv[arg_index++];
+  const int width            = atoi(argv[arg_index++]);
+  const int height           = atoi(argv[arg_index++]);
+
+  PixelFormat format = kBGR24;
+  if (argc > arg_index) {
+    const string format_name = argv[arg_index++];
+    if (format_name == "nv12") {
+      format = kNV12;
+    } else if (format_name == "i420") {
+      format = kI420;
+    } else if (format_name != "bgr24") {
+      fprintf(stderr, "Error - unknown pixel format %s\n", format_name.c_str());
+      return 1;
+    }
+  }
+
+  // By default, the rows are packed.
+  size_t stride = format == kBGR24 ? width * 3 : width;
+  if (argc > arg_index) {
+    const int stride_arg = atoi(argv[arg_index++]);
+    if (stride_arg > 0) {
+      stride = stride_arg;
+    }
+  }
+
+  int gpu_id = 0;
+  if (argc > arg_index) {
+    gpu_id = atoi(argv[arg_index++]);
+  }
+
+  FILE* input = stdin;
+  if (argc > arg_index) {
+    const string input_file = argv[arg_index++];
+    if (input_file != "-") {
+      input = fopen(input_file.c_str(), "rb");
+      if (!input) {
+        fprintf(stderr, "Error - could not open %s\n", input_file.c_str());
+        return 1;
+      }
+    }
+  }
+
+  bool binary = false;
+  if (argc > arg_index) {
+    binary = string(argv[arg_index++]) == "binary";
+  }
+
+  // Export the metrics (frames tracked, tracking time, ...) while running, to a file
+  // that is rewritten every kMetricsIntervalSeconds or on a local socket.
+  boost::shared_ptr<MetricsExporter> metrics_exporter;
+  if (argc > arg_index) {
+    metrics_exporter.reset(new MetricsExporter(MetricsRegistry::Get(), argv[arg_index++],
+                                               kMetricsIntervalSeconds));
+    if (!metrics_exporter->Start()) {
+      return 1;
+    }
+  }
+
+  // The chroma of NV12 and I420 is subsampled by 2 in both directions, so both
+  // sides must be even (and for I420, the stride, which is halved for the chroma).
+  if (width <= 0 || height <= 0 ||
+      (format != kBGR24 && (width % 2 != 0 || height % 2 != 0))) {
+    fprintf(stderr, "Error - invalid frame size %d x %d\n", width, height);
+    return 1;
+  }
+  const size_t min_stride = format == kBGR24 ? width * 3 : width;
+  if (stride < min_stride || (format == kI420 && stride % 2 != 0)) {
+    fprintf(stderr, "Error - invalid stride %zu for a frame width of %d\n", stride, width);
+    return 1;
+  }
+
+  const bool do_train = false;
+  Regressor regressor(model_file, trained_file, gpu_id, do_train);
+
+  const bool show_intermediate_output = false;
+  Tracker tracker(show_intermediate_output);
+
+  BoundingBox bbox;
+  if (!ReadInitialBox(input, &bbox)) {
+    fprintf(stderr, "Error - the input should start with a line \"x y width height\"\n");
+    return 1;
+  }
+
+  RawFrameReader reader(input, format, width, height, stride);
+  cv::Mat image;
+  YuvImage yuv_image;
+  if (!reader.ReadFrame(&image, &yuv_image)) {
+    fprintf(stderr, "Error - no frames in the input\n");
+    return 1;
+  }
+  if (format == kBGR24) {
+    tracker.Init(image, bbox, &regressor);
+  } else {
+    tracker.Init(yuv_image, bbox, &regressor);
+  }
+  WriteBox(0, bbox, binary, output);
+
+  while (reader.ReadFrame(&image, &yuv_image)) {
+    BoundingBox bbox_estimate;
+    if (format == kBGR24) {
+      tracker.Track(image, &regressor, &bbox_estimate);
+    } else {
+      tracker.Track(yuv_image, &regressor, &bbox_estimate);
+    }
+    WriteBox(reader.get_num_frames() - 1, bbox_estimate, binary, output);
+  }
+
+  fprintf(stderr, "Tracked %d frames\n", reader.get_num_frames());
+  fclose(output);
+  if (input != stdin) {
+    fclose(input);
+  }
+
+  return 0;
+}
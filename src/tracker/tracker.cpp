@@ -1,5 +1,7 @@
 #include "tracker.h"
 
+#include <algorithm>
+
 #include <opencv2/videostab/inpainting.hpp>
 
 #include "helper/helper.h"
@@ -8,15 +10,52 @@
 #include "network/regressor_train.h"
 #include "helper/high_res_timer.h"
 #include "helper/image_proc.h"
+#include "helper/metrics.h"
+#include "helper/profiler.h"
+
+namespace {
+
+// Largest reduction of the decoded frames (the largest that JPEG decoders support).
+const int kMaxDecodeReduction = 8;
+
+// Scale the coordinates of the bounding box by the given factor.
+void ScaleBox(const double scale, const BoundingBox& box, BoundingBox* box_scaled) {
+  *box_scaled = box;
+  box_scaled->x1_ *= scale;
+  box_scaled->y1_ *= scale;
+  box_scaled->x2_ *= scale;
+  box_scaled->y2_ *= scale;
+}
+
+// Count a tracked frame, which took the given time.
+void CountTrackedFrame(const double seconds) {
+  static Counter* frames_tracked = MetricsRegistry::Get()->GetCounter(
+      "goturn_tracker_frames_total", "Frames tracked.");
+  static Histogram* track_seconds = MetricsRegistry::Get()->GetHistogram(
+      "goturn_tracker_track_seconds", "Time to track each frame.",
+      Histogram::DurationBuckets());
+  frames_tracked->Increment();
+  track_seconds->Observe(seconds);
+}
+
+} // namespace
 
 Tracker::Tracker(const bool show_tracking) :
+  image_prev_scale_(1),
   show_tracking_(show_tracking)
 {
 }
 
 void Tracker::Init(const cv::Mat& image, const BoundingBox& bbox_gt,
                    RegressorBase* regressor) {
+  Init(image, 1, bbox_gt, regressor);
+}
+
+void Tracker::Init(const cv::Mat& image, const double image_scale, const BoundingBox& bbox_gt,
+                   RegressorBase* regressor) {
   image_prev_ = image;
+  image_prev_scale_ = image_scale;
+  yuv_prev_ = YuvImage();
   bbox_prev_tight_ = bbox_gt;
 
   // Predict in the current frame that the location will be approximately the same
@@ -42,15 +81,28 @@ void Tracker::Init(const std::string& image_curr_path, const VOTRegion& region,
 
 void Tracker::Track(const cv::Mat& image_curr, RegressorBase* regressor,
                     BoundingBox* bbox_estimate_uncentered) {
+  Track(image_curr, 1, regressor, bbox_estimate_uncentered);
+}
+
+void Tracker::Track(const cv::Mat& image_curr, const double image_scale,
+                    RegressorBase* regressor, BoundingBox* bbox_estimate_uncentered) {
+  PROFILE_ZONE("Track");
+  HighResTimer hrt_track("Track", CLOCK_MONOTONIC);
+  hrt_track.start();
+
   // Get target from previous image.
+  BoundingBox bbox_prev_image;
+  ScaleBox(image_prev_scale_, bbox_prev_tight_, &bbox_prev_image);
   cv::Mat target_pad;
-  CropPadImage(bbox_prev_tight_, image_prev_, &target_pad);
+  CropPadImage(bbox_prev_image, image_prev_, &target_pad);
 
   // Crop the current image based on predicted prior location of target.
+  BoundingBox bbox_prior_image;
+  ScaleBox(image_scale, bbox_curr_prior_tight_, &bbox_prior_image);
   cv::Mat curr_search_region;
   BoundingBox search_location;
   double edge_spacing_x, edge_spacing_y;
-  CropPadImage(bbox_curr_prior_tight_, image_curr, &curr_search_region, &search_location, &edge_spacing_x, &edge_spacing_y);
+  CropPadImage(bbox_prior_image, image_curr, &curr_search_region, &search_location, &edge_spacing_x, &edge_spacing_y);
 
   // Estimate the bounding box location of the target, centered and scaled relative to the cropped image.
   BoundingBox bbox_estimate;
@@ -60,8 +112,11 @@ void Tracker::Track(const cv::Mat& image_curr, RegressorBase* regressor,
   BoundingBox bbox_estimate_unscaled;
   bbox_estimate.Unscale(curr_search_region, &bbox_estimate_unscaled);
 
-  // Find the estimated bounding box location relative to the current crop.
-  bbox_estimate_unscaled.Uncenter(image_curr, search_location, edge_spacing_x, edge_spacing_y, bbox_estimate_uncentered);
+  // Find the estimated bounding box location relative to the current crop,
+  // in the coordinates of the original frame.
+  BoundingBox bbox_estimate_image;
+  bbox_estimate_unscaled.Uncenter(image_curr, search_location, edge_spacing_x, edge_spacing_y, &bbox_estimate_image);
+  ScaleBox(1 / image_scale, bbox_estimate_image, bbox_estimate_uncentered);
 
   if (show_tracking_) {
     ShowTracking(target_pad, curr_search_region, bbox_estimate);
@@ -69,6 +124,8 @@ void Tracker::Track(const cv::Mat& image_curr, RegressorBase* regressor,
 
   // Save the image.
   image_prev_ = image_curr;
+  image_prev_scale_ = image_scale;
+  yuv_prev_ = YuvImage();
 
   // Save the current estimate as the location of the target.
   bbox_prev_tight_ = *bbox_estimate_uncentered;
@@ -76,6 +133,96 @@ void Tracker::Track(const cv::Mat& image_curr, RegressorBase* regressor,
   // Save the current estimate as the prior prediction for the next image.
   // TODO - replace with a motion model prediction?
   bbox_curr_prior_tight_ = *bbox_estimate_uncentered;
+
+  hrt_track.stop();
+  CountTrackedFrame(hrt_track.getSeconds());
+}
+
+int Tracker::GetDecodeReduction(const RegressorBase& regressor) const {
+  const cv::Size input_size = regressor.get_input_size();
+  if (input_size.area() <= 0) {
+    return 1;
+  }
+
+  // The next frame gives the search region, and becomes the previous frame that
+  // the target is cropped from.  Both are padded around their boxes.
+  const double crop_width = std::min(bbox_curr_prior_tight_.compute_output_width(),
+                                     bbox_prev_tight_.compute_output_width());
+  const double crop_height = std::min(bbox_curr_prior_tight_.compute_output_height(),
+                                      bbox_prev_tight_.compute_output_height());
+
+  int reduction = 1;
+  while (reduction < kMaxDecodeReduction &&
+         crop_width / (2 * reduction) >= input_size.width &&
+         crop_height / (2 * reduction) >= input_size.height) {
+    reduction *= 2;
+  }
+  return reduction;
+}
+
+void Tracker::Init(const YuvImage& image, const BoundingBox& bbox_gt,
+                   RegressorBase* regressor) {
+  Init(cv::Mat(), bbox_gt, regressor);
+  yuv_prev_ = image;
+}
+
+void Tracker::Track(const YuvImage& image_curr, RegressorBase* regressor,
+                    BoundingBox* bbox_estimate_uncentered) {
+  PROFILE_ZONE("Track");
+  HighResTimer hrt_track("Track", CLOCK_MONOTONIC);
+  hrt_track.start();
+
+  // Crop directly at the input size of the network, so that the network does not
+  // need to resize the crops again.
+  const cv::Size input_size = regressor->get_input_size();
+
+  // Get target from previous image.
+  cv::Mat target_pad;
+  BoundingBox target_location;
+  double target_edge_x, target_edge_y, target_width, target_height;
+  if (yuv_prev_.y.data) {
+    CropPadImageResized(bbox_prev_tight_, yuv_prev_, input_size, &target_pad,
+                        &target_location, &target_edge_x, &target_edge_y,
+                        &target_width, &target_height);
+  } else {
+    CropPadImage(bbox_prev_tight_, image_prev_, &target_pad);
+  }
+
+  // Crop the current image based on predicted prior location of target.
+  cv::Mat curr_search_region;
+  BoundingBox search_location;
+  double edge_spacing_x, edge_spacing_y, search_width, search_height;
+  CropPadImageResized(bbox_curr_prior_tight_, image_curr, input_size, &curr_search_region,
+                      &search_location, &edge_spacing_x, &edge_spacing_y,
+                      &search_width, &search_height);
+
+  // Estimate the bounding box location of the target, centered and scaled relative to the cropped image.
+  BoundingBox bbox_estimate;
+  regressor->Regress(image_curr.y, curr_search_region, target_pad, &bbox_estimate);
+
+  // Unscale the estimation to the size of the crop before it was resized.
+  BoundingBox bbox_estimate_unscaled;
+  bbox_estimate.Unscale(search_width, search_height, &bbox_estimate_unscaled);
+
+  // Find the estimated bounding box location relative to the current crop.
+  bbox_estimate_unscaled.Uncenter(image_curr.y, search_location, edge_spacing_x, edge_spacing_y, bbox_estimate_uncentered);
+
+  if (show_tracking_) {
+    ShowTracking(target_pad, curr_search_region, bbox_estimate);
+  }
+
+  // Save the image.
+  image_prev_ = cv::Mat();
+  image_prev_scale_ = 1;
+  yuv_prev_ = image_curr;
+
+  // Save the current estimate as the location of the target and as the prior
+  // prediction for the next image.
+  bbox_prev_tight_ = *bbox_estimate_uncentered;
+  bbox_curr_prior_tight_ = *bbox_estimate_uncentered;
+
+  hrt_track.stop();
+  CountTrackedFrame(hrt_track.getSeconds());
 }
 
 void Tracker::ShowTracking(const cv::Mat& target_pad, const cv::Mat& curr_search_region, const BoundingBox& bbox_estimate) const {
@@ -6,6 +6,7 @@
 #include <opencv2/highgui/highgui.hpp>
 
 #include "helper/bounding_box.h"
+#include "helper/image_proc.h"
 #include "train/example_generator.h"
 #include "network/regressor.h"
 
@@ -18,15 +19,41 @@ public:
   virtual void Track(const cv::Mat& image_curr, RegressorBase* regressor,
              BoundingBox* bbox_estimate_uncentered);
 
+  // Same as above, for an image that was decoded at image_scale times the size of the
+  // original frame (e.g. with the reduction from GetDecodeReduction).  The estimate
+  // (and the boxes given to Init) are in the coordinates of the original frame.
+  void Track(const cv::Mat& image_curr, const double image_scale, RegressorBase* regressor,
+             BoundingBox* bbox_estimate_uncentered);
+
   // Initialize the tracker with the ground-truth bounding box of the first frame.
   void Init(const cv::Mat& image_curr, const BoundingBox& bbox_gt,
             RegressorBase* regressor);
 
+  // Same as above, for an image decoded at image_scale times the size of the original
+  // frame; bbox_gt is in the coordinates of the original frame.
+  void Init(const cv::Mat& image_curr, const double image_scale, const BoundingBox& bbox_gt,
+            RegressorBase* regressor);
+
+  // Get by how much the next frame can be downscaled when it is decoded (1, 2, 4 or 8),
+  // so that the search region and the target still have at least the input size of
+  // the network.  Large targets are downsampled to the input size anyway, so decoding
+  // them at full resolution only adds decoding and cropping time.
+  int GetDecodeReduction(const RegressorBase& regressor) const;
+
   // Initialize the tracker with the ground-truth bounding box of the first frame.
   // VOTRegion is an object for initializing the tracker when using the VOT Tracking dataset.
   void Init(const std::string& image_curr_path, const VOTRegion& region,
             RegressorBase* regressor);
 
+  // Same as above, for frames in a YUV 4:2:0 format (e.g. from a camera or hardware
+  // decoder).  Only the pixels of the crops are converted to BGR, at the input size
+  // of the network, instead of the whole frame.
+  // The planes of the previous frame must stay valid until the next call.
+  void Init(const YuvImage& image_curr, const BoundingBox& bbox_gt,
+            RegressorBase* regressor);
+  void Track(const YuvImage& image_curr, RegressorBase* regressor,
+             BoundingBox* bbox_estimate_uncentered);
+
 private:
   // Show the tracking output, for debugging.
   void ShowTracking(const cv::Mat& target_pad, const cv::Mat& curr_search_region, const BoundingBox& bbox_estimate) const;
@@ -39,8 +66,12 @@ private:
   // Estimated previous location of the target object.
   BoundingBox bbox_prev_tight_;
 
-  // Full previous image.
+  // Full previous image, and its size relative to the original frame.
   cv::Mat image_prev_;
+  double image_prev_scale_;
+
+  // Full previous image, for YUV frames (image_prev_ is not set for them).
+  YuvImage yuv_prev_;
 
   // Whether to visualize the tracking results
   bool show_tracking_;
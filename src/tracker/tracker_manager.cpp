@@ -2,16 +2,51 @@
 
 #include <string>
 
+#include "evaluate/evaluator_alov.h"
 #include "helper/helper.h"
+#include "helper/profiler.h"
 #include "train/tracker_trainer.h"
 
 using std::string;
 
+namespace {
+
+// Overlap (intersection over union) between two bounding boxes.
+double ComputeOverlap(const BoundingBox& bbox1, const BoundingBox& bbox2) {
+  const double intersection = bbox1.compute_intersection(bbox2);
+  return intersection / (bbox1.compute_area() + bbox2.compute_area() - intersection);
+}
+
+} // namespace
+
+RealTimeStats::RealTimeStats()
+  : num_frames(0),
+    num_processed(0),
+    num_dropped(0),
+    total_seconds(0),
+    track_seconds(0),
+    total_overlap(0),
+    num_annotated(0)
+{
+}
+
+void RealTimeStats::Print() const {
+  printf("Real-time replay: %d frames, %d processed, %d dropped\n",
+         num_frames, num_processed, num_dropped);
+  printf("Effective frame rate: %lf fps (tracker alone: %lf fps)\n",
+         total_seconds > 0 ? num_processed / total_seconds : 0.0,
+         track_seconds > 0 ? num_processed / track_seconds : 0.0);
+  printf("Mean overlap over %d annotated frames: %lf\n", num_annotated,
+         num_annotated > 0 ? total_overlap / num_annotated : 0.0);
+}
+
 TrackerManager::TrackerManager(const std::vector<Video>& videos,
                                RegressorBase* regressor, Tracker* tracker) :
   videos_(videos),
   regressor_(regressor),
-  tracker_(tracker)
+  tracker_(tracker),
+  frame_skip_(1),
+  adaptive_decode_(false)
 {
 }
 
@@ -20,6 +55,30 @@ void TrackerManager::TrackAll() {
 }
 
 void TrackerManager::TrackAll(const size_t start_video_num, const int pause_val) {
+  TrackVideos(start_video_num,
+              [this, pause_val](const Video& video, const int first_frame,
+                                const BoundingBox& bbox_init) {
+    // Iterate over the remaining frames of the video.
+    printf("Frames: ");
+    size_t frame_num = first_frame + frame_skip_;
+    for (; frame_num < video.all_frames.size(); frame_num += frame_skip_) {
+      if (frame_num % 100 == 0) {
+          // force flush as printf without newline will buffer
+          printf("%lu, ", frame_num);
+          fflush(stdout);
+      }
+      BoundingBox bbox_estimate_uncentered;
+      BoundingBox bbox_gt;
+      double track_seconds;
+      TrackFrame(video, frame_num, pause_val, &bbox_estimate_uncentered, &bbox_gt,
+                 &track_seconds);
+    }
+    printf("%lu\n", frame_num);
+  });
+  PostProcessAll();
+}
+
+void TrackerManager::TrackVideos(const size_t start_video_num, const FrameLoop& frame_loop) {
   // Iterate over all videos and track the target object in each.
   for (size_t video_num = start_video_num; video_num < videos_.size(); ++video_num) {
     // Get the video.
@@ -37,42 +96,148 @@ void TrackerManager::TrackAll(const size_t start_video_num, const int pause_val)
     // Initialize the tracker.
     tracker_->Init(image_curr, bbox_gt, regressor_);
 
-    // Iterate over the remaining frames of the video.
-    printf("Frames: ");
-    size_t frame_num = first_frame + 1;
-    for (; frame_num < video.all_frames.size(); ++frame_num) {
-      if (frame_num % 100 == 0) {
-          // force flush as printf without newline will buffer
-          printf("%lu, ", frame_num);
-          fflush(stdout);
+    frame_loop(video, first_frame, bbox_gt);
+
+    PostProcessVideo();
+  }
+}
+
+bool TrackerManager::TrackFrame(const Video& video, const int frame_num, const int pause_val,
+                                BoundingBox* bbox_estimate, BoundingBox* bbox_gt,
+                                double* track_seconds) {
+  // Get image for the current frame.
+  // (The ground-truth bounding box is used only for visualization and scoring).
+  cv::Mat image_curr;
+  double image_scale;
+  const bool has_annotation = LoadTrackingFrame(video, frame_num, &image_curr, &image_scale,
+                                                bbox_gt);
+
+  // Get ready to track the object.
+  SetupEstimate();
+
+  // Track and estimate the target's bounding box location in the current image.
+  // Important: this method cannot receive bbox_gt (the ground-truth bounding box) as an input.
+  HighResTimer hrt_track("Track", CLOCK_MONOTONIC);
+  hrt_track.start();
+  tracker_->Track(image_curr, image_scale, regressor_, bbox_estimate);
+  hrt_track.stop();
+  *track_seconds = hrt_track.getSeconds();
+
+  // Process the output (e.g. visualize / save results).
+  ProcessTrackOutput(frame_num, image_curr, has_annotation, *bbox_gt, *bbox_estimate,
+                     pause_val);
+  return has_annotation;
+}
+
+bool TrackerManager::LoadTrackingFrame(const Video& video, const int frame_num,
+                                       cv::Mat* image, double* image_scale,
+                                       BoundingBox* bbox_gt) const {
+  PROFILE_ZONE("LoadFrame");
+  const bool draw_bounding_box = false;
+  if (!adaptive_decode_) {
+    *image_scale = 1;
+    const bool load_only_annotation = false;
+    return video.LoadFrame(frame_num, draw_bounding_box, load_only_annotation, image, bbox_gt);
+  }
+
+  // Decode only as much of the frame as the tracker needs for the current target size.
+  const int reduction = tracker_->GetDecodeReduction(*regressor_);
+  video.LoadReducedImage(frame_num, reduction, image, image_scale);
+
+  const bool load_only_annotation = true;
+  return video.LoadFrame(frame_num, draw_bounding_box, load_only_annotation, NULL, bbox_gt);
+}
+
+void TrackerManager::ScoreDroppedFrames(const Video& video, const int start_frame,
+                                        const int end_frame, const double first_frame_time,
+                                        const double frame_interval,
+                                        const BoundingBox& bbox_before, const BoundingBox& bbox_after,
+                                        const double time_after) {
+  for (int frame_num = start_frame; frame_num < end_frame; ++frame_num) {
+    real_time_stats_.num_dropped++;
+
+    BoundingBox bbox_gt;
+    const bool draw_bounding_box = false;
+    const bool load_only_annotation = true;
+    if (video.LoadFrame(frame_num, draw_bounding_box, load_only_annotation, NULL, &bbox_gt)) {
+      // Use the tracker output that was available when this frame arrived.
+      const double frame_time = first_frame_time + frame_num * frame_interval;
+      const BoundingBox& bbox_available = frame_time < time_after ? bbox_before : bbox_after;
+      real_time_stats_.total_overlap += ComputeOverlap(bbox_available, bbox_gt);
+      real_time_stats_.num_annotated++;
+    }
+  }
+}
+
+void TrackerManager::TrackAllRealTime(const double target_fps) {
+  real_time_stats_ = RealTimeStats();
+  const double frame_interval = 1.0 / target_fps;
+
+  const size_t start_video_num = 0;
+  TrackVideos(start_video_num,
+              [this, frame_interval](const Video& video, const int first_frame,
+                                     const BoundingBox& bbox_init) {
+    // Time on the simulated clock, starting when the first frame arrives,
+    // so frame n arrives at time (n - first_frame) * frame_interval.
+    double time = 0;
+    const double first_frame_time = -first_frame * frame_interval;
+
+    // The most recent tracker output (the output available to the application), the one
+    // before it, and the time at which the most recent output became available.
+    BoundingBox bbox_available = bbox_init;
+    BoundingBox bbox_previous = bbox_init;
+    double time_available = 0;
+
+    const int num_frames = video.all_frames.size();
+    int last_frame = first_frame;
+    while (true) {
+      // Get the latest frame that has arrived; if the tracker is ahead of the
+      // camera, wait for the next frame.
+      int frame_num = first_frame + static_cast<int>(time / frame_interval);
+      if (frame_num <= last_frame) {
+        frame_num = last_frame + 1;
+        time = (frame_num - first_frame) * frame_interval;
+      }
+      if (frame_num >= num_frames) {
+        break;
       }
-      // Get image for the current frame.
-      // (The ground-truth bounding box is used only for visualization).
-      const bool draw_bounding_box = false;
-      const bool load_only_annotation = false;
-      cv::Mat image_curr;
-      BoundingBox bbox_gt;
-      bool has_annotation = video.LoadFrame(frame_num,
-                                            draw_bounding_box,
-                                            load_only_annotation,
-                                            &image_curr, &bbox_gt);
 
-      // Get ready to track the object.
-      SetupEstimate();
+      // Score the frames that were dropped while the tracker was busy.
+      ScoreDroppedFrames(video, last_frame + 1, frame_num, first_frame_time, frame_interval,
+                         bbox_previous, bbox_available, time_available);
 
-      // Track and estimate the target's bounding box location in the current image.
-      // Important: this method cannot receive bbox_gt (the ground-truth bounding box) as an input.
+      // Track the frame, advancing the clock by the time taken.
+      const int pause_val = 1;
       BoundingBox bbox_estimate_uncentered;
-      tracker_->Track(image_curr, regressor_, &bbox_estimate_uncentered);
+      BoundingBox bbox_gt;
+      double track_seconds;
+      const bool has_annotation = TrackFrame(video, frame_num, pause_val,
+                                             &bbox_estimate_uncentered, &bbox_gt,
+                                             &track_seconds);
+      time += track_seconds;
+      real_time_stats_.track_seconds += track_seconds;
+      real_time_stats_.num_processed++;
+
+      bbox_previous = bbox_available;
+      bbox_available = bbox_estimate_uncentered;
+      time_available = time;
+
+      if (has_annotation) {
+        real_time_stats_.total_overlap += ComputeOverlap(bbox_available, bbox_gt);
+        real_time_stats_.num_annotated++;
+      }
 
-      // Process the output (e.g. visualize / save results).
-      ProcessTrackOutput(frame_num, image_curr, has_annotation, bbox_gt,
-                           bbox_estimate_uncentered, pause_val);
+      last_frame = frame_num;
     }
-    printf("%lu\n", frame_num);
 
-    PostProcessVideo();
-  }
+    // Frames that arrived while the tracker was busy with the last processed frame are dropped.
+    ScoreDroppedFrames(video, last_frame + 1, num_frames, first_frame_time, frame_interval,
+                       bbox_previous, bbox_available, time_available);
+
+    real_time_stats_.num_frames += num_frames - 1 - first_frame;
+    real_time_stats_.total_seconds += std::max(time, (num_frames - 1 - first_frame) * frame_interval);
+  });
+  real_time_stats_.Print();
   PostProcessAll();
 }
 
@@ -208,4 +373,15 @@ void TrackerTesterAlov::PostProcessAll() {
   // Compute the mean tracking time per frame.
   const double mean_time_ms = total_ms_ / num_frames_;
   printf("Mean time: %lf ms\n", mean_time_ms);
+
+  // Score the tracking output, using one thread per core.
+  if (!annotations_folder_.empty()) {
+    EvaluatorAlov evaluator(annotations_folder_, output_folder_);
+    const std::vector<double>& thresholds = EvaluatorAlov::DefaultThresholds();
+    std::vector<double> mean_fscores;
+    const int num_threads = 0;
+    if (evaluator.EvaluateAll(thresholds, num_threads, &mean_fscores)) {
+      EvaluatorAlov::PrintScores(thresholds, mean_fscores);
+    }
+  }
 }
@@ -1,11 +1,41 @@
 #ifndef TRACKER_MANAGER_H
 #define TRACKER_MANAGER_H
 
+#include <algorithm>
+#include <functional>
+
 #include "network/regressor.h"
 #include "tracker/tracker.h"
 #include "loader/video.h"
 #include "helper/high_res_timer.h"
 
+// Statistics from replaying the videos in real time (see TrackerManager::TrackAllRealTime).
+struct RealTimeStats {
+  RealTimeStats();
+
+  // Number of frames that arrived from the frame source (excluding the first frame of each video).
+  int num_frames;
+
+  // Number of frames that the tracker processed, and number of frames that
+  // it skipped because it was still busy when they arrived.
+  int num_processed;
+  int num_dropped;
+
+  // Total replay time, and total time spent in Track().
+  double total_seconds;
+  double track_seconds;
+
+  // Sum of the overlap (intersection over union) with the ground-truth over all
+  // annotated frames, using the most recent tracker output available when each
+  // frame arrived (so dropped frames are scored with a stale box), and the
+  // number of annotated frames.
+  double total_overlap;
+  int num_annotated;
+
+  // Print the effective frame rate, the dropped frames and the accuracy.
+  void Print() const;
+};
+
 // Manage the iteration over all videos and tracking the objects inside.
 class TrackerManager
 {
@@ -21,6 +51,28 @@ public:
   // pause_val is normally ignored.
   void TrackAll(const size_t start_video_num, const int pause_val);
 
+  // Iterate over all videos and track the target object in each, replaying each
+  // video as a live camera running at target_fps.  When Track() takes longer than
+  // the frame interval, the tracker gets the latest frame that has arrived and the
+  // stale frames in between are dropped.  The replay uses a simulated clock that
+  // advances by the measured time of each Track() call, so loading the frames from
+  // disk does not count against the tracker.
+  // Only the processed frames are passed to ProcessTrackOutput.
+  void TrackAllRealTime(const double target_fps);
+
+  const RealTimeStats& get_real_time_stats() const { return real_time_stats_; }
+
+  // Track only every frame_skip-th frame in TrackAll (default 1: track every frame).
+  // Values below 1 are treated as 1.
+  void set_frame_skip(const int frame_skip) { frame_skip_ = std::max(1, frame_skip); }
+
+  // Decode each frame at a reduced resolution chosen from the current target size
+  // (see Tracker::GetDecodeReduction), so that the decoding and cropping time follow
+  // the input size of the network rather than the frame size.  The boxes are still in
+  // the coordinates of the full frames, but the image passed to ProcessTrackOutput is
+  // the reduced one, so this is not meant for drawing the output.
+  void set_adaptive_decode(const bool adaptive_decode) { adaptive_decode_ = adaptive_decode; }
+
   // Functions for subclasses that get called at appropriate times.
   virtual void VideoInit(const Video& video, const size_t video_num) {}
 
@@ -40,6 +92,35 @@ public:
   virtual void PostProcessAll() {}
 
 protected:
+  // Tracks the frames of a video after the first annotated frame, first_frame, whose
+  // ground-truth box bbox_init the tracker was initialized with.
+  typedef std::function<void(const Video& video, const int first_frame,
+                             const BoundingBox& bbox_init)> FrameLoop;
+
+  // Iterate over the videos from start_video_num: call VideoInit, initialize the
+  // tracker on the first annotated frame, run frame_loop, and call PostProcessVideo.
+  void TrackVideos(const size_t start_video_num, const FrameLoop& frame_loop);
+
+  // Load the given frame, track the target in it and pass the output to
+  // ProcessTrackOutput.  track_seconds is set to the time spent in Track().
+  // Returns whether the frame has an annotation (bbox_gt).
+  bool TrackFrame(const Video& video, const int frame_num, const int pause_val,
+                  BoundingBox* bbox_estimate, BoundingBox* bbox_gt, double* track_seconds);
+
+  // Load the image of the given frame for tracking (at a reduced resolution if
+  // adaptive decoding is on, with image_scale set to its size relative to the frame)
+  // and its annotation, if any.  Returns whether the frame has an annotation.
+  bool LoadTrackingFrame(const Video& video, const int frame_num, cv::Mat* image,
+                         double* image_scale, BoundingBox* bbox_gt) const;
+
+  // Score the frames in [start_frame, end_frame), which were dropped during real-time
+  // replay, with the tracker output available when each frame arrived: bbox_before
+  // until time_after, and bbox_after from then on.
+  void ScoreDroppedFrames(const Video& video, const int start_frame, const int end_frame,
+                          const double first_frame_time, const double frame_interval,
+                          const BoundingBox& bbox_before, const BoundingBox& bbox_after,
+                          const double time_after);
+
   // Videos to track.
   const std::vector<Video>& videos_;
 
@@ -48,6 +129,15 @@ protected:
 
   // Tracker.
   Tracker* tracker_;
+
+  // Statistics from the last call to TrackAllRealTime.
+  RealTimeStats real_time_stats_;
+
+  // Number of frames to advance after each tracked frame in TrackAll.
+  int frame_skip_;
+
+  // Whether to decode the frames at a reduced resolution when the target is large.
+  bool adaptive_decode_;
 };
 
 // Track objects and visualize the tracker output.
@@ -91,12 +181,23 @@ public:
   // Close the file that saves the tracking data.
   virtual void PostProcessVideo();
 
+  // Print the timing information and, if the annotations folder was set,
+  // the F-scores of the tracking output.
   virtual void PostProcessAll();
 
+  // Set the ALOV annotations folder, to evaluate the tracking output after
+  // tracking all videos.
+  void set_annotations_folder(const std::string& annotations_folder) {
+    annotations_folder_ = annotations_folder;
+  }
+
 private:
   // Folder to save all tracking output.
   std::string output_folder_;
 
+  // Folder with the ALOV annotations used for evaluation (empty to skip evaluation).
+  std::string annotations_folder_;
+
   // File for saving tracking output coordinates (for evaluation).
   FILE* output_file_ptr_;
 
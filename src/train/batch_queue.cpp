@@ -0,0 +1,125 @@
+#include "batch_queue.h"
+
+#include <algorithm>
+
+#include "helper/high_res_timer.h"
+#include "helper/metrics.h"
+
+namespace {
+
+// Number of complete batches in all queues.
+Gauge* GetQueueDepth() {
+  static Gauge* queue_depth = MetricsRegistry::Get()->GetGauge(
+      "goturn_batch_queue_depth", "Complete training batches waiting for the solver.");
+  return queue_depth;
+}
+
+} // namespace
+
+BatchQueue::BatchQueue(const size_t capacity, const int batch_size,
+                       const int num_channels, const cv::Size& input_geometry)
+  : capacity_(std::max(static_cast<size_t>(1), capacity)),
+    closed_(false),
+    batch_size_(batch_size),
+    num_channels_(num_channels),
+    input_geometry_(input_geometry),
+    push_wait_seconds_(0),
+    pop_wait_seconds_(0)
+{
+}
+
+BatchQueue::~BatchQueue() {
+  // The batches left in the queue are never trained on.
+  GetQueueDepth()->Add(-static_cast<double>(batches_.size()));
+}
+
+boost::shared_ptr<InputBatch> BatchQueue::GetEmptyBatch() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_batches_.empty()) {
+      boost::shared_ptr<InputBatch> batch = free_batches_.back();
+      free_batches_.pop_back();
+      batch->Clear();
+      return batch;
+    }
+  }
+
+  // Nothing to reuse yet, so allocate a new batch (outside of the lock).
+  return boost::shared_ptr<InputBatch>(
+      new InputBatch(batch_size_, num_channels_, input_geometry_));
+}
+
+void BatchQueue::Recycle(const boost::shared_ptr<InputBatch>& batch) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  free_batches_.push_back(batch);
+}
+
+bool BatchQueue::Push(const boost::shared_ptr<InputBatch>& batch) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (batches_.size() >= capacity_ && !closed_) {
+    HighResTimer hrt_wait("Wait", CLOCK_MONOTONIC);
+    hrt_wait.start();
+    not_full_.wait(lock, [this]() { return batches_.size() < capacity_ || closed_; });
+    hrt_wait.stop();
+    push_wait_seconds_ += hrt_wait.getSeconds();
+  }
+
+  if (closed_) {
+    return false;
+  }
+
+  batches_.push_back(batch);
+  GetQueueDepth()->Add(1);
+
+  not_empty_.notify_one();
+  return true;
+}
+
+bool BatchQueue::Pop(boost::shared_ptr<InputBatch>* batch) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (batches_.empty() && !closed_) {
+    HighResTimer hrt_wait("Wait", CLOCK_MONOTONIC);
+    hrt_wait.start();
+    not_empty_.wait(lock, [this]() { return !batches_.empty() || closed_; });
+    hrt_wait.stop();
+    pop_wait_seconds_ += hrt_wait.getSeconds();
+  }
+
+  if (batches_.empty()) {
+    return false;
+  }
+
+  *batch = batches_.front();
+  batches_.pop_front();
+  GetQueueDepth()->Add(-1);
+
+  not_full_.notify_one();
+  return true;
+}
+
+void BatchQueue::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = true;
+  not_full_.notify_all();
+  not_empty_.notify_all();
+}
+
+bool BatchQueue::is_closed() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return closed_;
+}
+
+size_t BatchQueue::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return batches_.size();
+}
+
+double BatchQueue::get_push_wait_seconds() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return push_wait_seconds_;
+}
+
+double BatchQueue::get_pop_wait_seconds() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pop_wait_seconds_;
+}
@@ -0,0 +1,80 @@
+#ifndef BATCH_QUEUE_H
+#define BATCH_QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <opencv2/core/core.hpp>
+
+#include "network/input_batch.h"
+
+// A bounded, thread-safe queue of training batches, between the threads that
+// generate the examples (producers) and the solver (consumer).
+// Both sides block when they have to wait; the time spent waiting is recorded,
+// to show whether training is limited by the data or by the solver.
+// The batches form a ring: once the solver has trained on a batch it is recycled,
+// and its memory is reused for a later batch, so at most capacity + 2 batches
+// (the queued ones, one being filled and one being trained on) are ever allocated.
+class BatchQueue
+{
+public:
+  // The queue holds at most capacity batches, each of batch_size examples
+  // in the given network input format.
+  BatchQueue(const size_t capacity, const int batch_size,
+             const int num_channels, const cv::Size& input_geometry);
+  ~BatchQueue();
+
+  // Get an empty batch to fill, reusing a recycled batch if there is one.
+  boost::shared_ptr<InputBatch> GetEmptyBatch();
+
+  // Add a full batch, waiting while the queue is full.
+  // Returns false (and drops the batch) if the queue has been closed.
+  bool Push(const boost::shared_ptr<InputBatch>& batch);
+
+  // Remove the oldest batch, waiting while the queue is empty.
+  // Returns false if the queue has been closed and is empty.
+  bool Pop(boost::shared_ptr<InputBatch>* batch);
+
+  // Return a batch that has been trained on, so that its memory can be reused.
+  void Recycle(const boost::shared_ptr<InputBatch>& batch);
+
+  // Wake up all waiting threads; after this, Push always fails.
+  void Close();
+
+  bool is_closed() const;
+
+  // Number of batches currently in the queue.
+  size_t size() const;
+  size_t get_capacity() const { return capacity_; }
+
+  // Total time that producers spent waiting for space in the queue,
+  // and that the consumer spent waiting for a batch.
+  double get_push_wait_seconds() const;
+  double get_pop_wait_seconds() const;
+
+private:
+  std::deque<boost::shared_ptr<InputBatch> > batches_;
+  size_t capacity_;
+  bool closed_;
+
+  // Batches that have been trained on, ready to be filled again.
+  std::vector<boost::shared_ptr<InputBatch> > free_batches_;
+
+  // Format of the batches.
+  int batch_size_;
+  int num_channels_;
+  cv::Size input_geometry_;
+
+  double push_wait_seconds_;
+  double pop_wait_seconds_;
+
+  // Protects all of the above.
+  mutable std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+};
+
+#endif // BATCH_QUEUE_H
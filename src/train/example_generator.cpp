@@ -14,6 +14,9 @@ using std::string;
 // Choose whether to shift boxes using the motion model or using a uniform distribution.
 const bool shift_motion_model = true;
 
+// Default size of the generated images (the network input size).
+const int kDefaultOutputSize = 227;
+
 ExampleGenerator::ExampleGenerator(const double lambda_shift,
                                    const double lambda_scale,
                                    const double min_scale,
@@ -21,7 +24,8 @@ ExampleGenerator::ExampleGenerator(const double lambda_shift,
   : lambda_shift_(lambda_shift),
     lambda_scale_(lambda_scale),
     min_scale_(min_scale),
-    max_scale_(max_scale)
+    max_scale_(max_scale),
+    output_size_(kDefaultOutputSize, kDefaultOutputSize)
 {
 }
 
@@ -30,7 +34,10 @@ void ExampleGenerator::Reset(const BoundingBox& bbox_prev,
                              const cv::Mat& image_prev,
                              const cv::Mat& image_curr) {
   // Get padded target from previous image to feed the network.
-  CropPadImage(bbox_prev, image_prev, &target_pad_);
+  BoundingBox target_location;
+  double edge_spacing_x, edge_spacing_y, pad_width, pad_height;
+  CropPadImageResized(bbox_prev, image_prev, output_size_, &target_pad_, &target_location,
+                      &edge_spacing_x, &edge_spacing_y, &pad_width, &pad_height);
 
   // Save the current image.
   image_curr_ = image_curr;
@@ -43,6 +50,7 @@ void ExampleGenerator::Reset(const BoundingBox& bbox_prev,
 }
 
 void ExampleGenerator::MakeTrainingExamples(const int num_examples,
+                                            Rng* rng,
                                             std::vector<cv::Mat>* images,
                                             std::vector<cv::Mat>* targets,
                                             std::vector<BoundingBox>* bboxes_gt_scaled) {
@@ -53,7 +61,7 @@ void ExampleGenerator::MakeTrainingExamples(const int num_examples,
 
     // Make training example by synthetically shifting and scaling the image,
     // creating an apparent translation and scale change of the target object.
-    MakeTrainingExampleBBShift(&image_rand_focus, &target_pad, &bbox_gt_scaled);
+    MakeTrainingExampleBBShift(rng, &image_rand_focus, &target_pad, &bbox_gt_scaled);
 
     images->push_back(image_rand_focus);
     targets->push_back(target_pad);
@@ -74,15 +82,17 @@ void ExampleGenerator::MakeTrueExample(cv::Mat* curr_search_region,
   // Crop the current image based on the prior estimate, with some padding
   // to define a search region within the current image.
   BoundingBox curr_search_location;
-  double edge_spacing_x, edge_spacing_y;
-  CropPadImage(curr_prior_tight, image_curr_, curr_search_region, &curr_search_location, &edge_spacing_x, &edge_spacing_y);
+  double edge_spacing_x, edge_spacing_y, pad_width, pad_height;
+  CropPadImageResized(curr_prior_tight, image_curr_, output_size_, curr_search_region,
+                      &curr_search_location, &edge_spacing_x, &edge_spacing_y,
+                      &pad_width, &pad_height);
 
   // Recenter the ground-truth bbox relative to the search location.
   BoundingBox bbox_gt_recentered;
   bbox_curr_gt_.Recenter(curr_search_location, edge_spacing_x, edge_spacing_y, &bbox_gt_recentered);
 
   // Scale the bounding box relative to current crop.
-  bbox_gt_recentered.Scale(*curr_search_region, bbox_gt_scaled);
+  bbox_gt_recentered.Scale(pad_width, pad_height, bbox_gt_scaled);
 }
 
 void ExampleGenerator::get_default_bb_params(BBParams* default_params) const {
@@ -92,7 +102,8 @@ void ExampleGenerator::get_default_bb_params(BBParams* default_params) const {
   default_params->max_scale = max_scale_;
 }
 
-void ExampleGenerator::MakeTrainingExampleBBShift(cv::Mat* image_rand_focus,
+void ExampleGenerator::MakeTrainingExampleBBShift(Rng* rng,
+                                                  cv::Mat* image_rand_focus,
                                                   cv::Mat* target_pad,
                                                   BoundingBox* bbox_gt_scaled) const {
 
@@ -103,13 +114,13 @@ void ExampleGenerator::MakeTrainingExampleBBShift(cv::Mat* image_rand_focus,
 
   // Generate training examples.
   const bool visualize_example = false;
-  MakeTrainingExampleBBShift(visualize_example, default_bb_params,
+  MakeTrainingExampleBBShift(visualize_example, default_bb_params, rng,
                              image_rand_focus, target_pad, bbox_gt_scaled);
 
 }
 
 void ExampleGenerator::MakeTrainingExampleBBShift(
-    const bool visualize_example, cv::Mat* image_rand_focus,
+    const bool visualize_example, Rng* rng, cv::Mat* image_rand_focus,
     cv::Mat* target_pad, BoundingBox* bbox_gt_scaled) const {
   // Get default parameters for how much translation and scale change to apply to the
   // training example.
@@ -117,13 +128,14 @@ void ExampleGenerator::MakeTrainingExampleBBShift(
   get_default_bb_params(&default_bb_params);
 
   // Generate training examples.
-  MakeTrainingExampleBBShift(visualize_example, default_bb_params,
+  MakeTrainingExampleBBShift(visualize_example, default_bb_params, rng,
                              image_rand_focus, target_pad, bbox_gt_scaled);
 
 }
 
 void ExampleGenerator::MakeTrainingExampleBBShift(const bool visualize_example,
                                                   const BBParams& bbparams,
+                                                  Rng* rng,
                                                   cv::Mat* rand_search_region,
                                                   cv::Mat* target_pad,
                                                   BoundingBox* bbox_gt_scaled) const {
@@ -133,21 +145,24 @@ void ExampleGenerator::MakeTrainingExampleBBShift(const bool visualize_example,
   BoundingBox bbox_curr_shift;
   bbox_curr_gt_.Shift(image_curr_, bbparams.lambda_scale, bbparams.lambda_shift,
                       bbparams.min_scale, bbparams.max_scale,
-                      shift_motion_model,
+                      shift_motion_model, rng,
                       &bbox_curr_shift);
 
-  // Crop the image based at the new location (after applying translation and scale changes).
-  double edge_spacing_x, edge_spacing_y;
+  // Crop the image based at the new location (after applying translation and scale changes),
+  // warping the crop directly to the output size.
+  double edge_spacing_x, edge_spacing_y, pad_width, pad_height;
   BoundingBox rand_search_location;
-  CropPadImage(bbox_curr_shift, image_curr_, rand_search_region, &rand_search_location,
-               &edge_spacing_x, &edge_spacing_y);
+  CropPadImageResized(bbox_curr_shift, image_curr_, output_size_, rand_search_region,
+                      &rand_search_location, &edge_spacing_x, &edge_spacing_y,
+                      &pad_width, &pad_height);
 
   // Find the shifted ground-truth bounding box location relative to the image crop.
   BoundingBox bbox_gt_recentered;
   bbox_curr_gt_.Recenter(rand_search_location, edge_spacing_x, edge_spacing_y, &bbox_gt_recentered);
 
-  // Scale the ground-truth bounding box relative to the random transformation.
-  bbox_gt_recentered.Scale(*rand_search_region, bbox_gt_scaled);
+  // Scale the ground-truth bounding box relative to the random transformation
+  // (relative to the padded crop, so the result does not depend on the output size).
+  bbox_gt_recentered.Scale(pad_width, pad_height, bbox_gt_scaled);
 
   if (visualize_example) {
     VisualizeExample(*target_pad, *rand_search_region, *bbox_gt_scaled);
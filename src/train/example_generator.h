@@ -6,6 +6,7 @@
 #include <opencv2/highgui/highgui.hpp>
 
 #include "helper/bounding_box.h"
+#include "helper/rng.h"
 #include "loader/loader_imagenet_det.h"
 #include "loader/video.h"
 
@@ -29,12 +30,14 @@ public:
              const cv::Mat& image_prev, const cv::Mat& image_curr);
 
   // Shift the whole bounding box for the current frame
-  // (simulates camera motion)
+  // (simulates camera motion), sampling the shift from rng.
   void MakeTrainingExampleBBShift(const bool visualize_example,
+                                  Rng* rng,
                                   cv::Mat* image_rand_focus,
                                   cv::Mat* target_pad,
                                   BoundingBox* bbox_gt_scaled) const;
-  void MakeTrainingExampleBBShift(cv::Mat* image_rand_focus,
+  void MakeTrainingExampleBBShift(Rng* rng,
+                                  cv::Mat* image_rand_focus,
                                   cv::Mat* target_pad,
                                   BoundingBox* bbox_gt_scaled) const;
 
@@ -43,8 +46,10 @@ public:
   void MakeTrueExample(cv::Mat* image_focus, cv::Mat* target_pad,
                        BoundingBox* bbox_gt_scaled) const;
 
-  // Make batch_size training examples according to the input parameters.
-  void MakeTrainingExamples(const int num_examples, std::vector<cv::Mat>* images,
+  // Make batch_size training examples according to the input parameters,
+  // sampling the random shifts from rng.
+  void MakeTrainingExamples(const int num_examples, Rng* rng,
+                            std::vector<cv::Mat>* images,
                             std::vector<cv::Mat>* targets,
                             std::vector<BoundingBox>* bboxes_gt_scaled);
 
@@ -53,9 +58,14 @@ public:
     video_index_ = video_index; frame_index_ = frame_index;
   }
 
+  // Set the size at which to generate the target and search region images
+  // (the input size of the network, 227 x 227 by default).
+  void set_output_size(const cv::Size& output_size) { output_size_ = output_size; }
+
 private:
   void MakeTrainingExampleBBShift(const bool visualize_example,
                                   const BBParams& bbparams,
+                                  Rng* rng,
                                   cv::Mat* image_rand_focus,
                                   cv::Mat* target_pad,
                                   BoundingBox* bbox_gt_scaled) const;
@@ -86,6 +96,10 @@ private:
   // Cropped and scaled image of the target object from the previous image.
   cv::Mat target_pad_;
 
+  // Size of the generated images; crops are warped directly to this size
+  // rather than cropped at full resolution and resized later.
+  cv::Size output_size_;
+
   // Video and frame index from which the current example was generated.
   // These values are only used when saving images to a file, to assign them
   // a unique identifier.
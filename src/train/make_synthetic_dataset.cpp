@@ -0,0 +1,97 @@
+// Write a synthetic tracking dataset (see loader/synthetic_video.h) in the layouts of
+// ALOV, VOT and ImageNet DET, so that training, tracking and the benchmarks can run
+// end to end on machines without the real datasets.  The output folder gets:
+//   alov/videos, alov/annotations   - for train, test_tracker_alov, evaluate_alov, ...
+//   vot                             - for test_tracker_vot, evaluate_vot, sweep_tracker, ...
+//   imagenet/images, imagenet/annotations - for train, show_imagenet, ...
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "loader/synthetic_video.h"
+
+using std::string;
+
+// Number of ALOV categories to split the videos between.
+const int kNumAlovCategories = 2;
+
+// As in ALOV, annotate every 5th frame.
+const int kAlovAnnotationInterval = 5;
+
+int main (int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " output_folder [alov|vot|imagenet|all] [num_videos] [num_frames]"
+              << " [width] [height] [speed] [scale_change] [occlusion] [seed]" << std::endl;
+    std::cerr << "(speed is in pixels per frame, scale_change is the largest relative change"
+              << " of the target size, and occlusion is the fraction of occluded frames.)"
+              << std::endl;
+    return 1;
+  }
+
+  int arg_index = 1;
+  const string& output_folder = argv[arg_index++];
+
+  string layout = "all";
+  if (argc > arg_index) {
+    layout = argv[arg_index++];
+  }
+  if (layout != "alov" && layout != "vot" && layout != "imagenet" && layout != "all") {
+    std::cerr << "Error - unknown layout " << layout << std::endl;
+    return 1;
+  }
+
+  // Number of videos (and of ImageNet images) to write.
+  int num_videos = 10;
+  if (argc > arg_index) {
+    num_videos = atoi(argv[arg_index++]);
+  }
+
+  SyntheticVideoOptions options;
+  if (argc > arg_index) {
+    options.num_frames = atoi(argv[arg_index++]);
+  }
+  if (argc > arg_index) {
+    options.width = atoi(argv[arg_index++]);
+  }
+  if (argc > arg_index) {
+    options.height = atoi(argv[arg_index++]);
+  }
+  if (argc > arg_index) {
+    options.speed = atof(argv[arg_index++]);
+  }
+  if (argc > arg_index) {
+    options.scale_change = atof(argv[arg_index++]);
+  }
+  if (argc > arg_index) {
+    options.occlusion = atof(argv[arg_index++]);
+  }
+  if (argc > arg_index) {
+    options.seed = atoi(argv[arg_index++]);
+  }
+
+  if (options.width <= 0 || options.height <= 0 || options.num_frames <= 0 || num_videos <= 0) {
+    std::cerr << "Error - the sizes and counts must be positive" << std::endl;
+    return 1;
+  }
+
+  // Keep the target at the same size relative to the frame as at the default resolution.
+  const SyntheticVideoOptions default_options;
+  options.target_width = default_options.target_width * options.width / default_options.width;
+  options.target_height = default_options.target_height * options.height / default_options.height;
+
+  if (layout == "alov" || layout == "all") {
+    WriteSyntheticAlov(options, kNumAlovCategories, num_videos, kAlovAnnotationInterval,
+                       output_folder + "/alov/videos", output_folder + "/alov/annotations");
+  }
+  if (layout == "vot" || layout == "all") {
+    WriteSyntheticVot(options, num_videos, output_folder + "/vot");
+  }
+  if (layout == "imagenet" || layout == "all") {
+    WriteSyntheticImagenetDet(options, num_videos, output_folder + "/imagenet/images",
+                              output_folder + "/imagenet/annotations");
+  }
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+// Pack the training images (ImageNet DET images and the annotated frames of the
+// ALOV training videos) into large shard files, optionally downscaled, so that
+// training reads them from a few memory-mapped files (see loader/image_shards.h).
+// The images can be downscaled to a maximum side, and/or as far as their smallest
+// annotated box allows without losing detail in the crops the network is trained on.
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "helper/bounding_box.h"
+#include "helper/high_res_timer.h"
+#include "loader/image_shards.h"
+#include "loader/loader_alov.h"
+#include "loader/loader_imagenet_det.h"
+
+using std::string;
+using std::vector;
+
+int main (int argc, char *argv[]) {
+  if (argc < 6) {
+    std::cerr << "Usage: " << argv[0]
+              << " videos_folder_imagenet annotations_folder_imagenet"
+              << " alov_videos_folder alov_annotations_folder"
+              << " output_prefix [max_side] [shard_mb] [crop_size]" << std::endl;
+    std::cerr << "(Use the same folders when training, since the images are keyed by their paths.)"
+              << std::endl;
+    return 1;
+  }
+
+  int arg_index = 1;
+  const string& videos_folder_imagenet      = argv[arg_index++];
+  const string& annotations_folder_imagenet = argv[arg_index++];
+  const string& alov_videos_folder      = argv[arg_index++];
+  const string& alov_annotations_folder = argv[arg_index++];
+  const string& output_prefix           = argv[arg_index++];
+
+  // By default, keep the original images.
+  int max_side = 0;
+  if (argc > arg_index) {
+    max_side = atoi(argv[arg_index++]);
+  }
+
+  int shard_mb = 1024;
+  if (argc > arg_index) {
+    shard_mb = atoi(argv[arg_index++]);
+  }
+
+  // If crop_size > 0 (e.g. the network resolution, 227), downscale each image until
+  // the crop around its smallest box is crop_size pixels.  Use a larger crop_size
+  // to keep more detail for the smaller crops made by the scale augmentation.
+  int crop_size = 0;
+  if (argc > arg_index) {
+    crop_size = atoi(argv[arg_index++]);
+  }
+  const double min_box_side = crop_size / BoundingBox::get_context_factor();
+
+  HighResTimer hrt_total("Packing", CLOCK_MONOTONIC);
+  hrt_total.start();
+
+  ImageShardWriter writer(output_prefix, static_cast<size_t>(shard_mb) * 1024 * 1024,
+                          max_side);
+
+  // Pack the ImageNet images (all annotations of an image share the image file).
+  LoaderImagenetDet image_loader(videos_folder_imagenet, annotations_folder_imagenet);
+  const vector<vector<Annotation> >& train_images = image_loader.get_images();
+  for (size_t i = 0; i < train_images.size(); ++i) {
+    const vector<Annotation>& annotations = train_images[i];
+    double smallest_box_side = annotations[0].bbox.get_width();
+    for (size_t j = 0; j < annotations.size(); ++j) {
+      smallest_box_side = std::min(smallest_box_side, std::min(annotations[j].bbox.get_width(),
+                                                               annotations[j].bbox.get_height()));
+    }
+    const cv::Size annotation_size(annotations[0].display_width_, annotations[0].display_height_);
+    writer.AddImage(image_loader.get_image_file(annotations[0]), smallest_box_side,
+                    min_box_side, annotation_size);
+    if (i % 10000 == 0 && i > 0) {
+      printf("Packed %zu / %zu ImageNet images\n", i, train_images.size());
+    }
+  }
+
+  // Pack the annotated frames of the training videos (the only frames used for training).
+  LoaderAlov alov_video_loader(alov_videos_folder, alov_annotations_folder);
+  const bool get_train = true;
+  vector<Video> train_videos;
+  alov_video_loader.get_videos(get_train, &train_videos);
+  for (size_t i = 0; i < train_videos.size(); ++i) {
+    const Video& video = train_videos[i];
+    for (size_t j = 0; j < video.annotations.size(); ++j) {
+      const Frame frame = video.annotations[j];
+      if (frame.frame_num >= 0 &&
+          static_cast<size_t>(frame.frame_num) < video.all_frames.size()) {
+        const double smallest_box_side = std::min(frame.bbox.get_width(),
+                                                  frame.bbox.get_height());
+        writer.AddImage(video.path + "/" + video.all_frames[frame.frame_num],
+                        smallest_box_side, min_box_side, cv::Size());
+      }
+    }
+  }
+  printf("Packed %zu ALOV videos\n", train_videos.size());
+
+  if (!writer.Finish()) {
+    return 1;
+  }
+
+  hrt_total.stop();
+  hrt_total.print();
+
+  return 0;
+}
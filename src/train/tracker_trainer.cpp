@@ -2,6 +2,9 @@
 
 #include "caffe/caffe.hpp"
 
+#include "helper/high_res_timer.h"
+#include "helper/metrics.h"
+#include "helper/profiler.h"
 #include "network/regressor.h"
 
 // Number of images in each batch.
@@ -13,6 +16,8 @@ const int kGeneratedExamplesPerImage = 10;
 
 TrackerTrainer::TrackerTrainer(ExampleGenerator* example_generator)
   : example_generator_(example_generator),
+    regressor_train_(NULL),
+    batch_queue_(NULL),
     num_batches_(0)
 {
 }
@@ -21,11 +26,50 @@ TrackerTrainer::TrackerTrainer(ExampleGenerator* example_generator,
                                RegressorTrainBase* regressor_train)
   : example_generator_(example_generator),
     regressor_train_(regressor_train),
+    batch_queue_(NULL),
     num_batches_(0)
 {
 }
 
-void TrackerTrainer::MakeTrainingExamples(std::vector<cv::Mat>* images,
+TrackerTrainer::TrackerTrainer(ExampleGenerator* example_generator,
+                               BatchQueue* batch_queue)
+  : example_generator_(example_generator),
+    regressor_train_(NULL),
+    batch_queue_(batch_queue),
+    num_batches_(0)
+{
+}
+
+TrainingTimes::TrainingTimes()
+  : sample_seconds(0),
+    load_seconds(0),
+    generate_seconds(0),
+    preprocess_seconds(0),
+    num_examples(0)
+{
+}
+
+int TrackerTrainer::get_batch_size() {
+  return kBatchSize;
+}
+
+void TrackerTrainer::AddSampleTime(const double seconds) {
+  std::lock_guard<std::mutex> lock(times_mutex_);
+  times_.sample_seconds += seconds;
+}
+
+void TrackerTrainer::AddLoadTime(const double seconds) {
+  std::lock_guard<std::mutex> lock(times_mutex_);
+  times_.load_seconds += seconds;
+}
+
+void TrackerTrainer::GetTimes(TrainingTimes* times) const {
+  std::lock_guard<std::mutex> lock(times_mutex_);
+  *times = times_;
+}
+
+void TrackerTrainer::MakeTrainingExamples(Rng* rng,
+                                          std::vector<cv::Mat>* images,
                                           std::vector<cv::Mat>* targets,
                                           std::vector<BoundingBox>* bboxes_gt_scaled) {
   // Generate true example.
@@ -38,7 +82,7 @@ void TrackerTrainer::MakeTrainingExamples(std::vector<cv::Mat>* images,
   bboxes_gt_scaled->push_back(bbox_gt_scaled);
 
   // Generate additional training examples through synthetic transformations.
-  example_generator_->MakeTrainingExamples(kGeneratedExamplesPerImage, images,
+  example_generator_->MakeTrainingExamples(kGeneratedExamplesPerImage, rng, images,
                                            targets, bboxes_gt_scaled);
 }
 
@@ -48,8 +92,82 @@ void TrackerTrainer::ProcessBatch() {
                           bboxes_gt_scaled_batch_);
 }
 
+bool TrackerTrainer::TrainNextBatch(BatchQueue* batch_queue) {
+  // Wait for a complete batch.
+  boost::shared_ptr<InputBatch> input_batch;
+  {
+    PROFILE_ZONE("WaitForBatch");
+    if (!batch_queue->Pop(&input_batch)) {
+      return false;
+    }
+  }
+
+  num_batches_++;
+  regressor_train_->Train(*input_batch);
+
+  static Counter* batches = MetricsRegistry::Get()->GetCounter(
+      "goturn_training_batches_total", "Batches that the solver trained on.");
+  static Histogram* batch_sizes = MetricsRegistry::Get()->GetHistogram(
+      "goturn_training_batch_size", "Examples in each batch that the solver trained on.",
+      Histogram::PowerOfTwoBuckets(1024));
+  batches->Increment();
+  batch_sizes->Observe(input_batch->get_num_examples());
+
+  // Let the producer fill this batch again.
+  batch_queue->Recycle(input_batch);
+  return true;
+}
+
+void TrackerTrainer::AddExample(const cv::Mat& image, const cv::Mat& target,
+                                const BoundingBox& bbox_gt_scaled,
+                                HighResTimer* hrt_preprocess) {
+  if (batch_queue_) {
+    // Convert the example straight into the next slot of the batch.
+    hrt_preprocess->start();
+    if (!input_batch_) {
+      input_batch_ = batch_queue_->GetEmptyBatch();
+    }
+    input_batch_->Add(image, target, bbox_gt_scaled);
+    hrt_preprocess->stop();
+
+    if (input_batch_->is_full()) {
+      // Hand the batch over to the thread that trains the network.
+      num_batches_++;
+      batch_queue_->Push(input_batch_);
+      input_batch_.reset();
+    }
+    return;
+  }
+
+  if (images_batch_.empty()) {
+    // Reserve the appropriate amount of space for the batch.
+    images_batch_.reserve(kBatchSize);
+    targets_batch_.reserve(kBatchSize);
+    bboxes_gt_scaled_batch_.reserve(kBatchSize);
+  }
+
+  images_batch_.push_back(image);
+  targets_batch_.push_back(target);
+  bboxes_gt_scaled_batch_.push_back(bbox_gt_scaled);
+
+  // If we have a full batch, then train!  Otherwise, save this batch for later.
+  if (images_batch_.size() == kBatchSize) {
+    // Increment the batch count.
+    num_batches_++;
+
+    // We have filled up a complete batch, so we should train.
+    ProcessBatch();
+
+    // After training, clear the batch.
+    images_batch_.clear();
+    targets_batch_.clear();
+    bboxes_gt_scaled_batch_.clear();
+  }
+}
+
 void TrackerTrainer::Train(const cv::Mat& image_prev, const cv::Mat& image_curr,
-                           const BoundingBox& bbox_prev, const BoundingBox& bbox_curr) {
+                           const BoundingBox& bbox_prev, const BoundingBox& bbox_curr,
+                           Rng* rng) {
   // Check that the saved batches are of appropriate dimensions.
   CHECK_EQ(images_batch_.size(), targets_batch_.size())
       << " images_batch: " << images_batch_.size() <<
@@ -59,6 +177,10 @@ void TrackerTrainer::Train(const cv::Mat& image_prev, const cv::Mat& image_curr,
       << " images_batch: " << images_batch_.size() <<
          " bboxes_gt_scaled_batch_: " << bboxes_gt_scaled_batch_.size();
 
+  PROFILE_ZONE("GenerateExamples");
+  HighResTimer hrt_generate("Generate", CLOCK_MONOTONIC);
+  hrt_generate.start();
+
   // Set up example generator.
   example_generator_->Reset(bbox_prev,
                            bbox_curr,
@@ -69,52 +191,22 @@ void TrackerTrainer::Train(const cv::Mat& image_prev, const cv::Mat& image_curr,
   std::vector<cv::Mat> images;
   std::vector<cv::Mat> targets;
   std::vector<BoundingBox> bboxes_gt_scaled;
-  MakeTrainingExamples(&images, &targets, &bboxes_gt_scaled);
-
-  while (images.size() > 0) {
-    // Compute the number of images left to complete the batch.
-    const int num_in_batch = images_batch_.size();
-    const int num_left_in_batch = kBatchSize - num_in_batch;
-
-    // The number of images to use is upper-bounded by the number left in the batch.
-    // The rest go into the next batch.
-    const int num_use = std::min(static_cast<int>(images.size()), num_left_in_batch);
-
-    if (num_use < 0) {
-      printf("Error: num_use: %d\n", num_use);
-    }
-
-    // Add the approrpriate number of images to the batch.
-    images_batch_.insert(images_batch_.end(),
-                         images.begin(), images.begin() + num_use);
-    targets_batch_.insert(targets_batch_.end(),
-                          targets.begin(), targets.begin() + num_use);
-    bboxes_gt_scaled_batch_.insert(bboxes_gt_scaled_batch_.end(),
-                                   bboxes_gt_scaled.begin(),
-                                   bboxes_gt_scaled.begin() + num_use);
-
-    // If we have a full batch, then train!  Otherwise, save this batch for later.
-    if (images_batch_.size() == kBatchSize) {
-      // Increment the batch count.
-      num_batches_++;
+  MakeTrainingExamples(rng, &images, &targets, &bboxes_gt_scaled);
 
-      // We have filled up a complete batch, so we should train.
-      ProcessBatch();
+  hrt_generate.stop();
 
-      // After training, clear the batch.
-      images_batch_.clear();
-      targets_batch_.clear();
-      bboxes_gt_scaled_batch_.clear();
+  // Add the examples to the batch; any that do not fit go into the next batch.
+  static Counter* examples = MetricsRegistry::Get()->GetCounter(
+      "goturn_training_examples_total", "Training examples generated.");
+  examples->Increment(images.size());
 
-      // Reserve the appropriate amount of space for the next batch.
-      images_batch_.reserve(kBatchSize);
-      targets_batch_.reserve(kBatchSize);
-      bboxes_gt_scaled_batch_.reserve(kBatchSize);
-    }
-
-    // Remove the images that were used.
-    images.erase(images.begin(), images.begin() + num_use);
-    targets.erase(targets.begin(), targets.begin() + num_use);
-    bboxes_gt_scaled.erase(bboxes_gt_scaled.begin(), bboxes_gt_scaled.begin() + num_use);
+  HighResTimer hrt_preprocess("Preprocess", CLOCK_MONOTONIC);
+  for (size_t i = 0; i < images.size(); ++i) {
+    AddExample(images[i], targets[i], bboxes_gt_scaled[i], &hrt_preprocess);
   }
+
+  std::lock_guard<std::mutex> lock(times_mutex_);
+  times_.generate_seconds += hrt_generate.getSeconds();
+  times_.preprocess_seconds += hrt_preprocess.getSeconds();
+  times_.num_examples += images.size();
 }
@@ -2,12 +2,38 @@
 #define TRACKER_TRAINER_H
 
 
+#include <stdint.h>
+
+#include <mutex>
 #include <vector>
+#include <boost/shared_ptr.hpp>
 #include <opencv/cv.h>
 
 #include "helper/bounding_box.h"
+#include "helper/high_res_timer.h"
 #include "tracker/tracker.h"
 #include "network/regressor_train_base.h"
+#include "train/batch_queue.h"
+
+// Total time that a TrackerTrainer spent in each stage of making its training examples.
+struct TrainingTimes {
+  TrainingTimes();
+
+  // Sampling the examples (including the stages below, and waiting to push the batches).
+  double sample_seconds;
+
+  // Loading and decoding the images.
+  double load_seconds;
+
+  // Generating the examples (ExampleGenerator).
+  double generate_seconds;
+
+  // Converting the examples into the network input format (Preprocess).
+  double preprocess_seconds;
+
+  // Number of examples generated.
+  int64_t num_examples;
+};
 
 class TrackerTrainer
 {
@@ -17,22 +43,52 @@ public:
   TrackerTrainer(ExampleGenerator* example_generator,
                  RegressorTrainBase* regressor_train);
 
+  // Instead of training, convert each example into a batch from batch_queue as
+  // soon as it is generated, and push each complete batch onto batch_queue, to be
+  // trained on by another thread (see TrainNextBatch).
+  TrackerTrainer(ExampleGenerator* example_generator,
+                 BatchQueue* batch_queue);
+
   // Train from this example.
-  // Inputs: previous image, current image, previous image's bounding box, current image's bounding box.
+  // Inputs: previous image, current image, previous image's bounding box, current image's bounding box,
+  // and the generator from which to sample the synthetic transformations.
   void Train(const cv::Mat& image_prev, const cv::Mat& image_curr,
-             const BoundingBox& bbox_prev, const BoundingBox& bbox_curr);
+             const BoundingBox& bbox_prev, const BoundingBox& bbox_curr,
+             Rng* rng);
 
-  // Number of total batches trained on so far.
+  // Pop the next complete batch from batch_queue (assembled by other threads) and train on it.
+  // Returns false if the queue has been closed.
+  bool TrainNextBatch(BatchQueue* batch_queue);
+
+  // Number of total batches trained on (or pushed onto the queue) so far.
   int get_num_batches() { return num_batches_; }
 
+  // Number of examples in each batch.
+  static int get_batch_size();
+
+  // Record time spent sampling examples and loading images, which happen outside of the
+  // trainer (in the ExampleSampler).
+  void AddSampleTime(const double seconds);
+  void AddLoadTime(const double seconds);
+
+  // Get the time spent in each stage so far.  Can be called from another thread.
+  void GetTimes(TrainingTimes* times) const;
+
 private:
   // Generate training examples and return them.
   // Note that we do not clear the input variables, so if they already contain
   // some examples then we will append to them.
-  virtual void MakeTrainingExamples(std::vector<cv::Mat>* images,
+  virtual void MakeTrainingExamples(Rng* rng,
+                            std::vector<cv::Mat>* images,
                             std::vector<cv::Mat>* targets,
                             std::vector<BoundingBox>* bboxes_gt_scaled);
 
+  // Add an example to the current batch, and train on the batch (or push it
+  // onto the queue) once it is full.
+  // hrt_preprocess accumulates the time spent converting the example into the batch.
+  void AddExample(const cv::Mat& image, const cv::Mat& target,
+                  const BoundingBox& bbox_gt_scaled, HighResTimer* hrt_preprocess);
+
   // Train on the batch.
   virtual void ProcessBatch();
 
@@ -47,8 +103,18 @@ private:
   // Neural network.
   RegressorTrainBase* regressor_train_;
 
+  // If set, complete batches are pushed here instead of being trained on.
+  BatchQueue* batch_queue_;
+
+  // Batch from batch_queue_ that is currently being filled.
+  boost::shared_ptr<InputBatch> input_batch_;
+
   // Number of total batches trained on so far.
   int num_batches_;
+
+  // Time spent in each stage, protected by times_mutex_.
+  TrainingTimes times_;
+  mutable std::mutex times_mutex_;
 };
 
 #endif // TRACKER_TRAINER_H
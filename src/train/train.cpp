@@ -3,14 +3,21 @@
 #include <string>
 #include <iostream>
 
+#include <boost/shared_ptr.hpp>
 #include <caffe/caffe.hpp>
 
 #include "example_generator.h"
 #include "helper/helper.h"
+#include "helper/high_res_timer.h"
+#include "helper/metrics.h"
+#include "helper/rng.h"
+#include "loader/image_cache.h"
+#include "loader/image_shards.h"
 #include "loader/loader_imagenet_det.h"
 #include "loader/loader_alov.h"
 #include "network/regressor_train.h"
 #include "train/tracker_trainer.h"
+#include "train/training_pipeline.h"
 #include "tracker/tracker_manager.h"
 #include "loader/video.h"
 #include "loader/video_loader.h"
@@ -20,36 +27,50 @@ using std::string;
 // Desired number of training batches.
 const int kNumBatches = 500000;
 
+// Maximum number of complete batches waiting for the solver.
+const size_t kQueueCapacity = 8;
+
+// Number of batches to profile when writing a trace.
+const int kTraceBatches = 200;
+
+// How often to rewrite the metrics file.
+const double kMetricsIntervalSeconds = 10;
+
 namespace {
 
 // Train on a random image.
 void train_image(const LoaderImagenetDet& image_loader,
            const std::vector<std::vector<Annotation> >& images,
-           TrackerTrainer* tracker_trainer) {
+           Rng* rng, TrackerTrainer* tracker_trainer) {
   // Get a random image.
-  const int image_num = rand() % images.size();
+  const int image_num = rng->UniformInt(images.size());
   const std::vector<Annotation>& annotations = images[image_num];
 
   // Choose a random annotation.
-  const int annotation_num = rand() % annotations.size();
+  const int annotation_num = rng->UniformInt(annotations.size());
 
   // Load the image with its ground-truth bounding box.
+  HighResTimer hrt_load("Load", CLOCK_MONOTONIC);
+  hrt_load.start();
   cv::Mat image;
   BoundingBox bbox;
   image_loader.LoadAnnotation(image_num, annotation_num, &image, &bbox);
+  hrt_load.stop();
+  tracker_trainer->AddLoadTime(hrt_load.getSeconds());
 
   // Train on this example
-  tracker_trainer->Train(image, image, bbox, bbox);
+  tracker_trainer->Train(image, image, bbox, bbox, rng);
 }
 
 // Train on all annotated frames in the set of videos.
-void train_video(const std::vector<Video>& videos, TrackerTrainer* tracker_trainer) {
+void train_video(const std::vector<Video>& videos, Rng* rng,
+                 TrackerTrainer* tracker_trainer) {
   // Get a random video.
-  const int video_num = rand() % videos.size();
+  const int video_num = rng->UniformInt(videos.size());
   const Video& video = videos[video_num];
 
   // Get the video's annotations.
-  const std::vector<Frame>& annotations = video.annotations;
+  const FrameAnnotations& annotations = video.annotations;
 
   // We need at least 2 annotations in this video for this to be useful.
   if (annotations.size() < 2) {
@@ -59,9 +80,11 @@ void train_video(const std::vector<Video>& videos, TrackerTrainer* tracker_train
   }
 
   // Choose a random annotation.
-  const int annotation_index = rand() % (annotations.size() - 1);
+  const int annotation_index = rng->UniformInt(annotations.size() - 1);
 
   // Load the frame's annotation.
+  HighResTimer hrt_load("Load", CLOCK_MONOTONIC);
+  hrt_load.start();
   int frame_num_prev;
   cv::Mat image_prev;
   BoundingBox bbox_prev;
@@ -72,9 +95,11 @@ void train_video(const std::vector<Video>& videos, TrackerTrainer* tracker_train
   cv::Mat image_curr;
   BoundingBox bbox_curr;
   video.LoadAnnotation(annotation_index + 1, &frame_num_curr, &image_curr, &bbox_curr);
+  hrt_load.stop();
+  tracker_trainer->AddLoadTime(hrt_load.getSeconds());
 
   // Train on this example
-  tracker_trainer->Train(image_prev, image_curr, bbox_prev, bbox_curr);
+  tracker_trainer->Train(image_prev, image_curr, bbox_prev, bbox_curr, rng);
 
   // Save
   frame_num_prev = frame_num_curr;
@@ -89,10 +114,11 @@ int main (int argc, char *argv[]) {
     std::cerr << "Usage: " << argv[0]
               << " videos_folder_imagenet annotations_folder_imagenet"
               << " alov_videos_folder alov_annotations_folder"
-              << " network.caffemodel train.prototxt val.prototxt"
+              << " network.caffemodel train.prototxt"
               << " solver_file"
               << " lambda_shift lambda_scale min_scale max_scale"
-              << " gpu_id"
+              << " gpu_id random_seed [num_threads] [shards_prefix]"
+              << " [cache_mb] [cache_max_side] [trace_file] [metrics_file|unix:socket]"
               << std::endl;
     return 1;
   }
@@ -116,6 +142,47 @@ int main (int argc, char *argv[]) {
   const int gpu_id          = atoi(argv[arg_index++]);
   const int random_seed          = atoi(argv[arg_index++]);
 
+  // Number of threads generating training examples (by default, one per core).
+  int num_threads = 0;
+  if (argc > arg_index) {
+    num_threads = atoi(argv[arg_index++]);
+  }
+
+  // Optionally, read the images from shards made by pack_shards
+  // (pass an empty string to only use the cache below).
+  string shards_prefix;
+  if (argc > arg_index) {
+    shards_prefix = argv[arg_index++];
+  }
+
+  // Optionally, keep up to cache_mb of decoded images in memory (shared by all workers),
+  // downscaled so that their longest side is at most cache_max_side (0 to keep the size).
+  int cache_mb = 0;
+  if (argc > arg_index) {
+    cache_mb = atoi(argv[arg_index++]);
+  }
+  int cache_max_side = 0;
+  if (argc > arg_index) {
+    cache_max_side = atoi(argv[arg_index++]);
+  }
+
+  // If set, profile the first kTraceBatches batches and write a Chrome trace
+  // of them to this file ("-" for no trace).
+  string trace_file;
+  if (argc > arg_index) {
+    trace_file = argv[arg_index++];
+    if (trace_file == "-") {
+      trace_file.clear();
+    }
+  }
+
+  // If set, export the metrics (see helper/metrics.h) while training, to this file
+  // or (if it starts with "unix:") on this socket.
+  string metrics_target;
+  if (argc > arg_index) {
+    metrics_target = argv[arg_index++];
+  }
+
   caffe::Caffe::set_random_seed(random_seed);
   printf("Using random seed: %d\n", random_seed);
 
@@ -140,6 +207,28 @@ int main (int argc, char *argv[]) {
   alov_video_loader.get_videos(get_train, &train_videos);
   printf("Total training videos: %zu\n", train_videos.size());
 
+  // Read the images from the shards when they are there.
+  boost::shared_ptr<ImageShards> image_shards;
+  if (!shards_prefix.empty()) {
+    image_shards.reset(new ImageShards(shards_prefix));
+    image_loader.set_image_shards(image_shards.get());
+    for (size_t i = 0; i < train_videos.size(); ++i) {
+      train_videos[i].set_image_shards(image_shards.get());
+    }
+  }
+
+  // Images that are drawn again (images are sampled with replacement, and consecutive
+  // video samples share frames) are then decoded only once.
+  boost::shared_ptr<ImageCache> image_cache;
+  if (cache_mb > 0) {
+    image_cache.reset(new ImageCache(static_cast<size_t>(cache_mb) * 1024 * 1024,
+                                     cache_max_side));
+    image_loader.set_image_cache(image_cache.get());
+    for (size_t i = 0; i < train_videos.size(); ++i) {
+      train_videos[i].set_image_cache(image_cache.get());
+    }
+  }
+
   // Create an ExampleGenerator to generate training examples.
   ExampleGenerator example_generator(lambda_shift, lambda_scale,
                                      min_scale, max_scale);
@@ -148,17 +237,33 @@ int main (int argc, char *argv[]) {
   RegressorTrain regressor_train(train_proto, caffe_model,
                                  gpu_id, solver_file);
 
-  // Set up trainer.
-  TrackerTrainer tracker_trainer(&example_generator, &regressor_train);
+  // Set up the training pipeline: worker threads generate the batches
+  // (each sampling from its own stream of random_seed) while this thread runs the solver.
+  TrainingPipeline training_pipeline(example_generator, &regressor_train,
+                                     num_threads, kQueueCapacity, random_seed);
+  training_pipeline.set_image_cache(image_cache.get());
+
+  if (!trace_file.empty()) {
+    training_pipeline.set_trace(trace_file, kTraceBatches);
+  }
+
+  boost::shared_ptr<MetricsExporter> metrics_exporter;
+  if (!metrics_target.empty()) {
+    metrics_exporter.reset(new MetricsExporter(MetricsRegistry::Get(), metrics_target,
+                                               kMetricsIntervalSeconds));
+    if (!metrics_exporter->Start()) {
+      return 1;
+    }
+  }
 
   // Train tracker.
-  while (tracker_trainer.get_num_batches() < kNumBatches) {
+  training_pipeline.Train([&](TrackerTrainer* tracker_trainer, Rng* rng) {
     // Train on an image example.
-    train_image(image_loader, train_images, &tracker_trainer);
+    train_image(image_loader, train_images, rng, tracker_trainer);
 
     // Train on a video example.
-    train_video(train_videos, &tracker_trainer);
-  }
+    train_video(train_videos, rng, tracker_trainer);
+  }, kNumBatches);
 
   return 0;
 }
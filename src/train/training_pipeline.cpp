@@ -0,0 +1,202 @@
+#include "training_pipeline.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include "helper/helper.h"
+#include "helper/high_res_timer.h"
+#include "helper/metrics.h"
+#include "helper/profiler.h"
+#include "loader/image_cache.h"
+
+using std::vector;
+
+// How often to print the pipeline statistics (in batches).
+const int kStatsInterval = 100;
+
+TrainingPipeline::TrainingPipeline(const ExampleGenerator& example_generator,
+                                   RegressorTrainBase* regressor_train,
+                                   const int num_workers,
+                                   const size_t queue_capacity,
+                                   const int random_seed)
+  : example_generator_(example_generator),
+    regressor_train_(regressor_train),
+    num_workers_(get_num_threads(num_workers)),
+    queue_capacity_(queue_capacity),
+    random_seed_(random_seed),
+    image_cache_(NULL),
+    trace_batches_(0)
+{
+}
+
+void TrainingPipeline::Train(const ExampleSampler& sample_examples, const int num_batches) {
+  printf("Training with %d worker threads and a queue of %zu batches\n",
+         num_workers_, queue_capacity_);
+
+  // The workers convert the examples straight into the network input format.
+  int num_channels;
+  cv::Size input_geometry;
+  regressor_train_->GetInputShape(&num_channels, &input_geometry);
+
+  // Split the queue capacity between the workers.
+  const size_t worker_capacity = std::max(static_cast<size_t>(1), queue_capacity_ / num_workers_);
+  vector<boost::shared_ptr<BatchQueue> > batch_queues(num_workers_);
+  for (int i = 0; i < num_workers_; ++i) {
+    batch_queues[i].reset(new BatchQueue(worker_capacity, TrackerTrainer::get_batch_size(),
+                                         num_channels, input_geometry));
+  }
+
+  const bool trace = !trace_file_.empty() && trace_batches_ > 0;
+  if (trace) {
+    Profiler::Enable();
+  }
+
+  // Set up the trainer of each worker here, so that its times can be printed.
+  vector<boost::shared_ptr<ExampleGenerator> > example_generators(num_workers_);
+  vector<boost::shared_ptr<TrackerTrainer> > worker_trainers(num_workers_);
+  for (int i = 0; i < num_workers_; ++i) {
+    example_generators[i].reset(new ExampleGenerator(example_generator_));
+    example_generators[i]->set_output_size(input_geometry);
+    worker_trainers[i].reset(new TrackerTrainer(example_generators[i].get(),
+                                                batch_queues[i].get()));
+  }
+
+  // Start the workers, which generate batches until their queue is closed.
+  vector<std::thread> workers;
+  for (int i = 0; i < num_workers_; ++i) {
+    workers.push_back(std::thread([&, i]() {
+      Profiler::SetThreadName("Worker " + std::to_string(i));
+      Rng rng(random_seed_, i);
+      BatchQueue* batch_queue = batch_queues[i].get();
+      TrackerTrainer* tracker_trainer = worker_trainers[i].get();
+      while (!batch_queue->is_closed()) {
+        PROFILE_ZONE("SampleExamples");
+        HighResTimer hrt_sample("Sample", CLOCK_MONOTONIC);
+        hrt_sample.start();
+        sample_examples(tracker_trainer, &rng);
+        hrt_sample.stop();
+        tracker_trainer->AddSampleTime(hrt_sample.getSeconds());
+      }
+    }));
+  }
+
+  // Train on the batches from each worker in turn.
+  Profiler::SetThreadName("Solver");
+  TrackerTrainer tracker_trainer(NULL, regressor_train_);
+  HighResTimer hrt_total("Training", CLOCK_MONOTONIC);
+  hrt_total.start();
+  while (tracker_trainer.get_num_batches() < num_batches) {
+    BatchQueue* batch_queue = batch_queues[tracker_trainer.get_num_batches() % num_workers_].get();
+    if (!tracker_trainer.TrainNextBatch(batch_queue)) {
+      break;
+    }
+
+    if (trace && tracker_trainer.get_num_batches() == trace_batches_) {
+      WriteTrace();
+    }
+
+    if (tracker_trainer.get_num_batches() % kStatsInterval == 0) {
+      hrt_total.stop();
+      PrintStats(tracker_trainer.get_num_batches(), num_batches, batch_queues, worker_trainers,
+                 hrt_total.getSeconds());
+      hrt_total.start();
+    }
+  }
+
+  // Stop the workers.
+  for (int i = 0; i < num_workers_; ++i) {
+    batch_queues[i]->Close();
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+
+  // Training ended before all the batches to trace.
+  if (trace && Profiler::IsEnabled()) {
+    WriteTrace();
+  }
+}
+
+void TrainingPipeline::WriteTrace() const {
+  Profiler::Disable();
+  Profiler::PrintStats();
+  Profiler::WriteChromeTrace(trace_file_);
+}
+
+void TrainingPipeline::PrintStats(const int num_batches, const int total_batches,
+                                  const vector<boost::shared_ptr<BatchQueue> >& batch_queues,
+                                  const vector<boost::shared_ptr<TrackerTrainer> >& worker_trainers,
+                                  const double elapsed_seconds) const {
+  double solver_wait_seconds = 0;
+  double worker_wait_seconds = 0;
+  size_t num_queued = 0;
+  size_t capacity = 0;
+  for (size_t i = 0; i < batch_queues.size(); ++i) {
+    solver_wait_seconds += batch_queues[i]->get_pop_wait_seconds();
+    worker_wait_seconds += batch_queues[i]->get_push_wait_seconds();
+    num_queued += batch_queues[i]->size();
+    capacity += batch_queues[i]->get_capacity();
+  }
+
+  // Sum the times of the workers.
+  TrainingTimes worker_times;
+  for (size_t i = 0; i < worker_trainers.size(); ++i) {
+    TrainingTimes times;
+    worker_trainers[i]->GetTimes(&times);
+    worker_times.sample_seconds += times.sample_seconds;
+    worker_times.load_seconds += times.load_seconds;
+    worker_times.generate_seconds += times.generate_seconds;
+    worker_times.preprocess_seconds += times.preprocess_seconds;
+    worker_times.num_examples += times.num_examples;
+  }
+
+  const double examples_per_second =
+      num_batches * TrackerTrainer::get_batch_size() / elapsed_seconds;
+  static Gauge* examples_per_second_gauge = MetricsRegistry::Get()->GetGauge(
+      "goturn_training_examples_per_second",
+      "Examples trained on per second, averaged since the start of training.");
+  examples_per_second_gauge->Set(examples_per_second);
+
+  // Estimate the time left at the average speed so far.
+  const double batches_per_second = num_batches / elapsed_seconds;
+  const int seconds_left = static_cast<int>((total_batches - num_batches) / batches_per_second);
+  printf("Batch %d / %d: %lf batches / s, %.1lf examples / s "
+         "(%.1lf generated / s), %d:%02d:%02d left\n",
+         num_batches, total_batches, batches_per_second, examples_per_second,
+         worker_times.num_examples / elapsed_seconds,
+         seconds_left / 3600, seconds_left / 60 % 60, seconds_left % 60);
+
+  // The split of the solver thread's time.  On the GPU, the forward and backward passes
+  // also include finishing the previous update, which is only launched asynchronously.
+  double copy_seconds;
+  double forward_backward_seconds;
+  double update_seconds;
+  regressor_train_->GetTrainTimes(&copy_seconds, &forward_backward_seconds, &update_seconds);
+  printf("Solver: waiting for data %.1lf%%, copying batches %.1lf%%, "
+         "forward / backward %.1lf%%, update %.1lf%%\n",
+         100 * solver_wait_seconds / elapsed_seconds, 100 * copy_seconds / elapsed_seconds,
+         100 * forward_backward_seconds / elapsed_seconds,
+         100 * update_seconds / elapsed_seconds);
+
+  // The split of the workers' time (per worker), where sampling covers whatever the
+  // sampler does besides loading the images and generating the examples.
+  // If the solver waits, training is limited by the data (add workers); if the
+  // workers wait, it is limited by the solver.
+  const double worker_seconds = elapsed_seconds * num_workers_;
+  const double other_sample_seconds = worker_times.sample_seconds - worker_times.load_seconds -
+      worker_times.generate_seconds - worker_times.preprocess_seconds - worker_wait_seconds;
+  printf("Workers: loading images %.1lf%%, generating examples %.1lf%%, "
+         "preprocessing %.1lf%%, other sampling %.1lf%%, waiting for the solver %.1lf%%, "
+         "queue %zu / %zu\n",
+         100 * worker_times.load_seconds / worker_seconds,
+         100 * worker_times.generate_seconds / worker_seconds,
+         100 * worker_times.preprocess_seconds / worker_seconds,
+         100 * other_sample_seconds / worker_seconds,
+         100 * worker_wait_seconds / worker_seconds,
+         num_queued, capacity);
+
+  if (image_cache_) {
+    image_cache_->PrintStats();
+  }
+}
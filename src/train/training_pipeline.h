@@ -0,0 +1,82 @@
+#ifndef TRAINING_PIPELINE_H
+#define TRAINING_PIPELINE_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "helper/rng.h"
+#include "network/regressor_train_base.h"
+#include "train/batch_queue.h"
+#include "train/example_generator.h"
+#include "train/tracker_trainer.h"
+
+class ImageCache;
+
+// Generates training examples by passing one or more (image, bounding box) pairs
+// to tracker_trainer->Train (e.g. a random image or a random pair of video frames),
+// drawing all random choices from rng.
+// This is called concurrently from several threads, each with its own tracker_trainer and rng.
+typedef std::function<void(TrackerTrainer* tracker_trainer, Rng* rng)> ExampleSampler;
+
+// Trains the network with a producer/consumer pipeline: worker threads load
+// the images, generate the augmented examples and assemble them into complete
+// batches in bounded queues, while the calling thread only pops the batches
+// and runs the solver.  This keeps the solver from waiting on image decoding
+// and cropping.
+// Each worker samples from its own stream of the random seed and has its own
+// queue, and the solver takes the batches from the workers in turn, so the
+// training data only depends on the seed and the number of workers.
+class TrainingPipeline
+{
+public:
+  // Each worker uses its own copy of example_generator.
+  // If num_workers <= 0, use one worker per core.
+  TrainingPipeline(const ExampleGenerator& example_generator,
+                   RegressorTrainBase* regressor_train,
+                   const int num_workers,
+                   const size_t queue_capacity,
+                   const int random_seed);
+
+  // Train until num_batches batches have been trained on.
+  void Train(const ExampleSampler& sample_examples, const int num_batches);
+
+  // Also print the statistics of the cache that the samplers load images through.
+  void set_image_cache(const ImageCache* image_cache) { image_cache_ = image_cache; }
+
+  // Profile the first trace_batches batches (see helper/profiler.h), then print the
+  // statistics and write the Chrome trace to trace_file.  (The trace of a whole
+  // training run would not fit in memory.)
+  void set_trace(const std::string& trace_file, const int trace_batches) {
+    trace_file_ = trace_file;
+    trace_batches_ = trace_batches;
+  }
+
+private:
+  // Print the training speed, the estimated time until total_batches, and how the
+  // time of the solver and of the workers was split between the stages of training.
+  void PrintStats(const int num_batches, const int total_batches,
+                  const std::vector<boost::shared_ptr<BatchQueue> >& batch_queues,
+                  const std::vector<boost::shared_ptr<TrackerTrainer> >& worker_trainers,
+                  const double elapsed_seconds) const;
+
+  // Stop profiling, and print and write out the trace.
+  void WriteTrace() const;
+
+  ExampleGenerator example_generator_;
+  RegressorTrainBase* regressor_train_;
+  int num_workers_;
+  size_t queue_capacity_;
+  int random_seed_;
+
+  // Optional cache of decoded images (not owned).
+  const ImageCache* image_cache_;
+
+  // File to write the trace of the first trace_batches_ batches to (empty for no trace).
+  std::string trace_file_;
+  int trace_batches_;
+};
+
+#endif // TRAINING_PIPELINE_H